@@ -0,0 +1,100 @@
+#ifndef ASSET_ARCHIVE_H
+#define ASSET_ARCHIVE_H
+#include "map_file.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <time.h>
+#include <vector>
+using namespace std;
+
+// the images, fonts and prefabs packed into one file by the asset_packer
+// target so the game opens one file at startup instead of walking the
+// asset directories. Little endian, records are written as they are laid
+// out in memory like the binary map format. A file is:
+//   AssetArchiveHeader
+//   AssetArchiveEntry[num_entries], sorted by name
+//   names_num_bytes of nul terminated names, padded to the alignment
+//   the files' bytes, each starting on ASSET_ARCHIVE_ALIGNMENT
+// Names are paths under the assets directory ("ui/ui.png"), the game still
+// asks for "../assets/ui/ui.png" and falls back to the loose file when
+// there is no archive (or the asset isn't in it), which is what the editor
+// edits. Prefabs saved since the archive was packed are read from their
+// loose files too, see is_loose_file_newer. Maps aren't packed, the
+// MapLoader reads them.
+#define ASSET_ARCHIVE_MAGIC "LPAK"
+#define ASSET_ARCHIVE_VERSION 1
+#define ASSET_ARCHIVE_ALIGNMENT 16
+#define ASSET_ARCHIVE_FILE_PATH "../assets/assets.lpak"
+#define ASSET_ARCHIVE_ASSETS_DIR "../assets/"
+
+// which Assets array a prefab goes in, prefab_name is its item_name,
+// unit_name, etc. so Assets can find it without parsing every prefab.
+enum class AssetArchivePrefabKind {
+  None,
+  Item,
+  Ability,
+  Unit,
+  TreasureChest,
+  StatusEffect,
+};
+
+struct AssetArchiveHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t num_entries;
+  uint32_t names_num_bytes;
+};
+
+struct AssetArchiveEntry {
+  uint32_t name_offset;
+  int32_t prefab_kind;
+  int32_t prefab_name;
+  uint32_t reserved;
+  uint64_t offset;
+  uint64_t num_bytes;
+};
+
+static_assert(sizeof(AssetArchiveHeader) == 16,
+              "AssetArchiveHeader is written as is");
+static_assert(sizeof(AssetArchiveEntry) == 32,
+              "AssetArchiveEntry is written as is");
+
+// a file's bytes in the archive, null when it isn't there
+struct AssetBlob {
+  const char *data = nullptr;
+  size_t num_bytes = 0;
+};
+
+// a file for asset_archive_write
+struct AssetArchiveFile {
+  string name = "";
+  AssetArchivePrefabKind prefab_kind = AssetArchivePrefabKind::None;
+  int prefab_name = 0;
+  vector<char> bytes = vector<char>();
+};
+
+// the mapped archive. Nothing is read from the blobs until they are asked
+// for, the pages of assets that are never used aren't touched.
+class AssetArchive {
+public:
+  MappedFile file;
+  AssetArchiveHeader header = AssetArchiveHeader();
+  vector<AssetArchiveEntry> entries = vector<AssetArchiveEntry>();
+  const char *names = nullptr;
+  // when the archive file was last written
+  time_t modified_time = 0;
+  AssetArchive() = default;
+  bool open(const char *file_path);
+  bool is_open();
+  AssetBlob find(const char *file_path);
+  AssetBlob get_blob(const AssetArchiveEntry &entry);
+  const char *get_name(const AssetArchiveEntry &entry);
+  bool is_loose_file_newer(const AssetArchiveEntry &entry);
+};
+
+string get_asset_archive_name(const char *file_path);
+void asset_archive_write(vector<AssetArchiveFile> &files,
+                         const char *file_path);
+
+#endif // ASSET_ARCHIVE_H
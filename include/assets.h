@@ -2,8 +2,10 @@
 #define ASSETS_H
 
 #include "ability.h"
+#include "asset_archive.h"
 #include "constants.h"
 #include "item.h"
+#include "rapidjson/document.h"
 #include "status_effect.h"
 #include "treasure_chest.h"
 #include "unit.h"
@@ -13,11 +15,19 @@
 #include <unordered_map>
 #include <vector>
 using namespace std;
+using namespace rapidjson;
 
 struct Game;
 
+// a prefab in the asset archive, decoded the first time it is asked for
+struct AssetPrefab {
+  int entry_idx = -1;
+  bool is_loaded = false;
+};
+
 class Assets {
 private:
+  Game *game = nullptr;
   array<Item, ITEM_NAME_LAST> items;
   array<Ability, ABILITY_NAME_LAST> abilities;
   array<Unit, UNIT_NAME_LAST> units;
@@ -34,6 +44,13 @@ private:
   unordered_map<string, Unit> unit_dict;
   unordered_map<string, TreasureChest> treasure_chest_dict;
   unordered_map<string, StatusEffect> status_effect_dict;
+  array<AssetPrefab, ITEM_NAME_LAST> item_prefabs;
+  array<AssetPrefab, ABILITY_NAME_LAST> ability_prefabs;
+  array<AssetPrefab, UNIT_NAME_LAST> unit_prefabs;
+  array<AssetPrefab, STATUS_EFFECT_NAME_LAST> status_effect_prefabs;
+  void index_archive(Game &game);
+  void set_prefabs_loaded(bool is_loaded);
+  bool load_prefab(AssetPrefab &prefab, Document &doc);
 
 public:
   Assets() = default;
@@ -76,4 +93,23 @@ void check_if_all_asset_names_exist(
   }
 }
 
+// prefab names that aren't in the asset archive, index 0 is the None name.
+template <size_t N>
+void check_if_all_prefabs_exist(array<AssetPrefab, N> &prefabs,
+                                const char *asset_display_name) {
+  auto asset_name_error = false;
+  for (size_t i = 1; i < prefabs.size(); i++) {
+    if (prefabs[i].entry_idx == -1) {
+      asset_name_error = true;
+      cout << "Assets - " << asset_display_name << " name not found " << i
+           << "\n";
+    }
+  }
+  // don't abort, just fix it in the editor
+  if (asset_name_error) {
+    cout << "Assets::index_archive - " << asset_display_name
+         << " name not found.\n";
+  }
+}
+
 #endif // ASSETS_H
\ No newline at end of file
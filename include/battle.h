@@ -2,6 +2,8 @@
 #define BATTLE_H
 
 #include "constants.h"
+#include "flow_field.h"
+#include "move_range_field.h"
 #include "robin_hood.h"
 #include "unit.h"
 #include <SDL.h>
@@ -17,27 +19,39 @@ struct AbilityTarget;
 
 struct BattleAction {
   BattleActionType action_type;
-  boost::uuids::uuid acting_unit_guid;
-  vector<boost::uuids::uuid> receiving_unit_guids;
+  EntityHandle acting_unit_handle;
+  vector<EntityHandle> receiving_unit_handles;
   Ability ability;
   Vec2 tile_point;
   Vec2 ability_target_dst;
+  // moves with has_path walk path instead of searching for one, an empty
+  // path means the unit stays where it is.
+  bool has_path = false;
+  vector<Vec2> path;
   BattleAction() = default;
-  void set_as_unit_move(boost::uuids::uuid _acting_unit_guid, Vec2 _tile_point);
-  void set_as_use_ability(boost::uuids::uuid _acting_unit_guid,
-                          vector<boost::uuids::uuid> _receiving_unit_guids,
+  void set_as_unit_move(EntityHandle _acting_unit_handle, Vec2 _tile_point);
+  void set_as_unit_move_along_path(EntityHandle _acting_unit_handle,
+                                   Vec2 _tile_point, const vector<Vec2> &_path);
+  void set_as_use_ability(EntityHandle _acting_unit_handle,
+                          vector<EntityHandle> _receiving_unit_handles,
                           const Ability &_ability, Vec2 _ability_target_dst);
-  void set_as_end_turn(boost::uuids::uuid _acting_unit_guid);
+  void set_as_end_turn(EntityHandle _acting_unit_handle);
 };
 
 struct Battle {
   boost::uuids::uuid guid;
-  boost::uuids::uuid acting_unit_guid;
-  vector<boost::uuids::uuid> unit_guids;
+  EntityHandle acting_unit_handle;
+  vector<EntityHandle> unit_handles;
   queue<BattleAction> action_queue;
   vector<BattleAction> charging_actions;
   queue<BattleAction> counter_queue;
   PerformAbilityContext current_context = PerformAbilityContext::Default;
+  // where the acting unit can move with the action points it has left.
+  MoveRangeField move_range_field = MoveRangeField();
+  // one per target unit and hitbox size, see get_flow_field. Fields of
+  // dead units are dropped each turn, see evict_flow_fields.
+  vector<FlowField> flow_fields = vector<FlowField>();
+  vector<Vec2> ai_move_path = vector<Vec2>();
   Battle() = default;
   Battle(Game &game);
   void update(Game &game);
@@ -57,14 +71,19 @@ struct Battle {
   bool all_faction_units_dead(Game &game, Faction faction);
   bool is_battle_over(Game &game);
   void end_battle(Game &game);
-  pair<bool, boost::uuids::uuid>
-  get_closest_faction_unit(Game &game, boost::uuids::uuid _acting_unit_guid,
+  void set_move_range_field(Game &game, Unit &acting_unit);
+  MoveRangeField &get_move_range_field(Game &game, Unit &acting_unit);
+  FlowField &get_flow_field(Game &game, Unit &target_unit, Vec2 hit_box_dims);
+  void evict_flow_fields(Game &game);
+  pair<bool, EntityHandle>
+  get_closest_faction_unit(Game &game, EntityHandle _acting_unit_handle,
                            Faction faction_to_search_for);
-  vector<boost::uuids::uuid>
-  get_receiving_unit_guids(Game &game, Ability &ability,
-                           AbilityTarget &ability_target);
-  vector<boost::uuids::uuid> get_units_in_aoe(Game &game,
-                                              AbilityTarget &ability_target);
+  vector<EntityHandle>
+  get_receiving_unit_handles(Game &game, Ability &ability,
+                             AbilityTarget &ability_target);
+  vector<EntityHandle> get_units_in_aoe(Game &game,
+                                        AbilityTarget &ability_target);
+  bool has_unit_handle(EntityHandle unit_handle);
 };
 
 #endif // BATTLE_H
\ No newline at end of file
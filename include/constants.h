@@ -193,6 +193,13 @@ enum class TweenCallbackType {
   UseAbilityTimeout, // js style set timeout for ability usage
 };
 
+enum class PathFinderMode {
+  AStar,
+  // jump point search, shortest 8 way paths, skips over open areas by
+  // scanning 64 points of a line at a time
+  JumpPoint,
+};
+
 enum BattleActionType {
   None,
   Move,
@@ -229,6 +236,7 @@ enum class AbilityElement {
 enum class ShaderName {
   None,
   Default,
+  StaticMap,
 };
 
 enum class ItemType {
@@ -92,7 +92,7 @@ struct Editor {
       "Nerf",
   };
   string current_editor_mode = "";
-  boost::uuids::uuid inspecting_prefab_guid;
+  EntityHandle inspecting_prefab_handle;
   string prefab_file_path = "";
   string formatted_prefab_file_name = "";
   string save_prefab_file_name = "";
@@ -5,11 +5,13 @@
 
 #include <GL/glew.h>
 
+#include "asset_archive.h"
 #include "camera.h"
 #include "constants.h"
 #include "imgui.h"
 #include "imgui_impl_opengl3.h"
 #include "imgui_impl_sdl.h"
+#include "robin_hood.h"
 #include "stb_truetype.h"
 #include "utils.h"
 #include <SDL.h>
@@ -154,7 +156,14 @@ struct Engine {
   int delta_time;
   int fps;
   bool quit;
+  // the images, fonts and prefabs, not open when the archive hasn't been
+  // built (the loose files are read then)
+  AssetArchive asset_archive;
   vector<Image> images = vector<Image>();
+  // images whose png hasn't been decoded and uploaded yet, by texture id.
+  // Only the game thread touches it.
+  robin_hood::unordered_flat_map<GLuint, string> unloaded_image_file_paths =
+      robin_hood::unordered_flat_map<GLuint, string>();
   vector<Shader> shaders = vector<Shader>();
   vector<Font> fonts = vector<Font>();
   // render buffers
@@ -164,6 +173,9 @@ struct Engine {
   int num_draw_calls = 0;
   vector<short> vertices = vector<short>();
   vector<float> uvs = vector<float>();
+  // uniforms of the static map shader, see MapRenderer
+  GLint static_map_camera_location = -1;
+  GLint static_map_scale_location = -1;
   void start();
   void update(Game &game);
   void clear();
@@ -171,6 +183,15 @@ struct Engine {
   void push_to_render_buffer(short *_vertices_to_add, int _vertices_size,
                              float *_uvs_to_add, int _uvs_size);
   void present_render_buffer();
+  void upload_static_buffers(GLuint &_vao, GLuint &_vbo, GLuint &_ubo,
+                             vector<short> &_vertices, vector<float> &_uvs);
+  void update_static_buffers(GLuint _vbo, GLuint _ubo, int first_vertex,
+                             short *_vertices, float *_uvs, int num_vertices);
+  void delete_static_buffers(GLuint &_vao, GLuint &_vbo, GLuint &_ubo);
+  void begin_static_draw(Vec2 camera_dst);
+  void draw_static_buffers(GLuint _vao, GLuint texture_id, int first_vertex,
+                           int num_vertices);
+  void end_static_draw();
   void set_active_shader(ShaderName _shader_name);
   void set_active_image(Image &image);
   void set_cursor(CursorType _cursor_type);
@@ -179,7 +200,11 @@ struct Engine {
   void load_cursors();
   void load_images();
   Image load_image(ImageName _image_name, const char *_image_path);
+  void bind_texture(GLuint texture_id);
+  void upload_image(const char *_image_path);
+  bool read_asset_file(const char *file_path, string &contents);
   void load_default_shader();
+  void load_static_map_shader();
   void load_fonts();
   Image get_image(ImageName _image_name);
   Shader get_shader(ShaderName _shader_name);
@@ -0,0 +1,35 @@
+#ifndef ENTITY_HANDLE_H
+#define ENTITY_HANDLE_H
+#include "robin_hood.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// the low bits of a handle are the entity's idx in the EntityRegistry, the
+// rest are the generation of that idx.
+#define ENTITY_HANDLE_IDX_BITS 20
+#define ENTITY_HANDLE_IDX_MASK ((1u << ENTITY_HANDLE_IDX_BITS) - 1)
+#define ENTITY_HANDLE_MAX_GENERATION ((1u << (32 - ENTITY_HANDLE_IDX_BITS)) - 1)
+// the last idx is never handed out so this is never a real handle
+#define INVALID_ENTITY_HANDLE_VALUE UINT32_MAX
+
+// the runtime id of a unit, item or treasure chest. The guids are what
+// gets saved and sent over the network, see EntityRegistry.
+struct EntityHandle {
+  uint32_t value = INVALID_ENTITY_HANDLE_VALUE;
+  EntityHandle() = default;
+  EntityHandle(int idx, uint32_t generation);
+  int get_idx() const;
+  uint32_t get_generation() const;
+  bool is_valid() const;
+};
+
+struct EntityHandleHash {
+  size_t operator()(const EntityHandle &handle) const {
+    return robin_hood::hash<uint32_t>()(handle.value);
+  }
+};
+
+bool operator==(const EntityHandle &h1, const EntityHandle &h2);
+bool operator!=(const EntityHandle &h1, const EntityHandle &h2);
+
+#endif // ENTITY_HANDLE_H
@@ -0,0 +1,92 @@
+#ifndef ENTITY_MAP_H
+#define ENTITY_MAP_H
+#include "constants.h"
+#include "entity_handle.h"
+#include <vector>
+
+#include "utils.h"
+using namespace std;
+
+// entities of one type stored next to each other so updating and drawing
+// them walks an array. items[i] is the entity with handles[i], item_idxs
+// is indexed by a handle's idx and is -1 for handles that aren't in the
+// map. erase moves the last entity into the erased one's place, so
+// references into items are invalidated by insert and erase.
+template <class T> class EntityMap {
+public:
+  vector<T> items;
+  vector<EntityHandle> handles;
+  vector<int> item_idxs;
+  EntityMap();
+  bool contains(EntityHandle handle) const;
+  T &operator[](EntityHandle handle);
+  T &at(EntityHandle handle);
+  void insert(EntityHandle handle, const T &item);
+  void erase(EntityHandle handle);
+  int size() const;
+  void clear();
+};
+
+template <class T> EntityMap<T>::EntityMap() {
+  items = vector<T>();
+  handles = vector<EntityHandle>();
+  item_idxs = vector<int>();
+}
+
+template <class T> bool EntityMap<T>::contains(EntityHandle handle) const {
+  auto idx = handle.get_idx();
+  return handle.is_valid() && idx < (int)item_idxs.size() &&
+         item_idxs[idx] != -1 && handles[item_idxs[idx]] == handle;
+}
+
+template <class T> T &EntityMap<T>::operator[](EntityHandle handle) {
+  GAME_ASSERT(contains(handle));
+  return items[item_idxs[handle.get_idx()]];
+}
+
+template <class T> T &EntityMap<T>::at(EntityHandle handle) {
+  return (*this)[handle];
+}
+
+// replaces the entity if the handle is already in the map.
+template <class T>
+void EntityMap<T>::insert(EntityHandle handle, const T &item) {
+  GAME_ASSERT(handle.is_valid());
+  auto idx = handle.get_idx();
+  if (idx >= (int)item_idxs.size()) {
+    item_idxs.resize(idx + 1, -1);
+  }
+  if (item_idxs[idx] != -1 && handles[item_idxs[idx]] == handle) {
+    items[item_idxs[idx]] = item;
+    return;
+  }
+  items.push_back(item);
+  handles.push_back(handle);
+  item_idxs[idx] = items.size() - 1;
+}
+
+template <class T> void EntityMap<T>::erase(EntityHandle handle) {
+  if (!contains(handle)) {
+    return;
+  }
+  auto item_idx = item_idxs[handle.get_idx()];
+  auto last_idx = (int)items.size() - 1;
+  if (item_idx != last_idx) {
+    items[item_idx] = move(items[last_idx]);
+    handles[item_idx] = handles[last_idx];
+    item_idxs[handles[item_idx].get_idx()] = item_idx;
+  }
+  items.pop_back();
+  handles.pop_back();
+  item_idxs[handle.get_idx()] = -1;
+}
+
+template <class T> int EntityMap<T>::size() const { return items.size(); }
+
+template <class T> void EntityMap<T>::clear() {
+  items.clear();
+  handles.clear();
+  item_idxs.clear();
+}
+
+#endif // ENTITY_MAP_H
@@ -0,0 +1,34 @@
+#ifndef ENTITY_REGISTRY_H
+#define ENTITY_REGISTRY_H
+#include "entity_handle.h"
+#include "robin_hood.h"
+#include "utils.h"
+#include <boost/uuid/uuid.hpp>
+#include <stdint.h>
+#include <vector>
+using namespace std;
+
+// maps the guids of units, items and treasure chests to the handles used
+// for them at runtime and back. A guid keeps its handle for the whole
+// session, so maps copied or loaded again (the editor's play mode, map
+// transitions) still agree on every entity's handle. release is for
+// entities that are gone for good (see Map::release_entity_handle), it
+// bumps the idx's generation so stale handles to it stop matching. An idx whose generation runs out is not
+// used again.
+struct EntityRegistry {
+  vector<boost::uuids::uuid> guids = vector<boost::uuids::uuid>();
+  vector<uint32_t> generations = vector<uint32_t>();
+  vector<int> free_idxs = vector<int>();
+  robin_hood::unordered_flat_map<boost::uuids::uuid, EntityHandle,
+                                 BoostUUIDHash>
+      handles = robin_hood::unordered_flat_map<boost::uuids::uuid,
+                                               EntityHandle, BoostUUIDHash>();
+  EntityRegistry();
+  EntityHandle get_handle(boost::uuids::uuid guid);
+  EntityHandle find_handle(boost::uuids::uuid guid);
+  boost::uuids::uuid get_guid(EntityHandle handle);
+  bool contains(EntityHandle handle);
+  void release(EntityHandle handle);
+};
+
+#endif // ENTITY_REGISTRY_H
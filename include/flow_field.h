@@ -0,0 +1,47 @@
+#ifndef FLOW_FIELD_H
+#define FLOW_FIELD_H
+#include "move_grid.h"
+#include "occupancy_grid.h"
+#include "utils.h"
+#include <boost/uuid/uuid.hpp>
+#include <stdint.h>
+#include <vector>
+using namespace std;
+
+#define FLOW_FIELD_UNREACHED -1
+#define FLOW_FIELD_NO_DIRECTION -1
+
+extern const Vec2 FLOW_FIELD_DIRS[8];
+
+// paths from every move grid point to one target unit, for units with the
+// same hitbox size. costs is the integration field (breadth first from the
+// target over the move grid only) and directions is the direction field,
+// the index into FLOW_FIELD_DIRS of the cheapest neighbour. Any number of
+// units can follow it, so units that share a target share the search.
+// Units aren't in the field, they move every turn, set_path stops before
+// the first one in the way. A field is out of date once the target moves
+// or the move grid changes, see is_stale.
+struct FlowField {
+  EntityHandle target_unit_handle;
+  Vec2 target = Vec2(0, 0);
+  Vec2 hit_box_dims = Vec2(0, 0);
+  uint32_t move_grid_version = 0;
+  int rows = 0;
+  int cols = 0;
+  vector<int> costs = vector<int>();
+  vector<int8_t> directions = vector<int8_t>();
+  // the breadth first search's queue, in the order points were reached
+  vector<int> reached_idxs = vector<int>();
+  FlowField();
+  void set(const MoveGrid &move_grid, EntityHandle _target_unit_handle,
+           Vec2 _target, Vec2 _hit_box_dims);
+  bool is_stale(const MoveGrid &move_grid, Vec2 target_point);
+  void set_path(const OccupancyGrid &occupancy_grid, Rect unit_hit_box,
+                int max_steps, vector<Vec2> &path);
+  int get_cost(Vec2 p);
+  bool point_in_bounds(Vec2 p);
+  int get_idx(Vec2 p);
+  Vec2 get_point(int idx);
+};
+
+#endif // FLOW_FIELD_H
@@ -5,8 +5,12 @@
 #include "assets.h"
 #include "constants.h"
 #include "engine.h"
+#include "entity_registry.h"
 #include "map.h"
+#include "map_loader.h"
+#include "map_renderer.h"
 #include "network.h"
+#include "path_request_service.h"
 #include "pathfinder.h"
 #include "serializer.h"
 #include "text.h"
@@ -19,6 +23,11 @@ using namespace std;
 struct EditorState {
   bool use_editor = false;
   bool in_play_mode = false;
+  // guids of the entities in the map play mode goes back to, their handles
+  // aren't released while playing, see Map::release_entity_handle.
+  robin_hood::unordered_flat_set<boost::uuids::uuid, BoostUUIDHash>
+      saved_map_guids =
+          robin_hood::unordered_flat_set<boost::uuids::uuid, BoostUUIDHash>();
   bool no_editor_or_editor_and_in_play_mode();
 };
 
@@ -46,8 +55,12 @@ struct Game {
   MapTransitionRequest map_transition_request = MapTransitionRequest();
   Engine engine = Engine();
   Assets assets = Assets();
+  EntityRegistry entity_registry = EntityRegistry();
   Map map = Map();
+  MapLoader map_loader;
+  MapRenderer map_renderer = MapRenderer();
   PathFinder path_finder = PathFinder();
+  PathRequestService path_request_service;
   TextRenderer text_renderer = TextRenderer();
   AbilityTargets ability_targets = AbilityTargets();
   UI ui = UI();
@@ -2,7 +2,6 @@
 #define GAME_EVENTS_H
 
 #include "utils.h"
-#include <boost/uuid/uuid.hpp>
 #include <string>
 
 using namespace std;
@@ -24,23 +23,25 @@ public:
   uint32_t m_sender_guid;
   uint32_t m_receiver_guid;
   uint32_t m_player_guid;
-  boost::uuids::uuid m_unit_guid;
-  boost::uuids::uuid m_item_guid;
+  // sent as the entities' guids, an invalid handle if this client doesn't
+  // know the entity.
+  EntityHandle m_unit_handle;
+  EntityHandle m_item_handle;
   Vec2 m_tile_point;
   bool m_allow_units_to_path_through_each_other;
 
   string serialize(Game &game);
   static GameEvent deserialize(Game &game, const string &message);
-  static string create_move_unit(Game &game, boost::uuids::uuid unit_guid,
+  static string create_move_unit(Game &game, EntityHandle unit_handle,
                                  Vec2 tile_point,
                                  bool allow_units_to_path_through_each_other);
   static string player_handle_request(Game &game);
   static string player_handle_respond(Game &game, uint32_t receiver_guid,
                                       uint32_t player_guid);
-  static string collect_item_request(Game &game, boost::uuids::uuid m_unit_guid,
-                                     boost::uuids::uuid item_guid);
-  static string collect_item_respond(Game &game, boost::uuids::uuid m_unit_guid,
-                                     boost::uuids::uuid item_guid);
+  static string collect_item_request(Game &game, EntityHandle m_unit_handle,
+                                     EntityHandle item_handle);
+  static string collect_item_respond(Game &game, EntityHandle m_unit_handle,
+                                     EntityHandle item_handle);
 };
 
 #endif // GAME_EVENTS_H
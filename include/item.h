@@ -3,6 +3,7 @@
 #include <SDL.h>
 
 #include "constants.h"
+#include "entity_handle.h"
 #include "rapidjson/document.h"
 #include "text.h"
 #include "tweenable_sprite.h"
@@ -18,6 +19,8 @@ struct Game;
 
 struct Item {
   boost::uuids::uuid guid;
+  // only set for items on a map, see Map::add_item.
+  EntityHandle handle;
   ItemName item_name = ItemName::None;
   ItemType item_type = ItemType::None;
   bool in_use_in_pool = false;
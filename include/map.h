@@ -3,11 +3,19 @@
 #include "ability.h"
 #include "ability_targets.h"
 #include "battle.h"
+#include "entity_map.h"
 #include "game_events.h"
 #include "item.h"
+#include "map_file.h"
+#include "map_layer.h"
+#include "move_grid.h"
+#include "occupancy_grid.h"
+#include "path_cluster_graph.h"
+#include "path_request_service.h"
 #include "pool.h"
 #include "rapidjson/document.h"
 #include "robin_hood.h"
+#include "spatial_grid.h"
 #include "sprite.h"
 #include "tile.h"
 #include "treasure_chest.h"
@@ -24,6 +32,9 @@ using namespace std;
 using namespace rapidjson;
 
 #define MAX_LAYERS 10
+// tile and layer sprites are baked by the MapRenderer in square chunks of
+// this many tiles a side.
+#define MAP_CHUNK_TILES 16
 // how many units are reserved for the players 1 for now until its figured
 // out how it works
 #define PLAYER_CONTROLLED_UNITS_SIZE 1
@@ -31,39 +42,70 @@ using namespace rapidjson;
 struct Game;
 
 struct Map {
-  // the unit guids of every player and player controlled unit
-  // i.e all host and client player unit guids
-  vector<boost::uuids::uuid> all_player_unit_guids =
-      vector<boost::uuids::uuid>();
-  // just the unit guids you control i.e either the host units
+  // the unit handles of every player and player controlled unit
+  // i.e all host and client player unit handles
+  vector<EntityHandle> all_player_unit_handles = vector<EntityHandle>();
+  // just the unit handles you control i.e either the host units
   // or a particular client's units
-  vector<boost::uuids::uuid> player_unit_guids = vector<boost::uuids::uuid>();
+  vector<EntityHandle> player_unit_handles = vector<EntityHandle>();
   int rows = 0;
   int cols = 0;
   int rows_move_grid = 0;
   int cols_move_grid = 0;
   queue<GameEvent> game_events;
   vector<Tile> tiles = vector<Tile>();
-  vector<vector<Sprite>> layers = vector<vector<Sprite>>();
-  // keys are boost::uuids::uuid
-  robin_hood::unordered_flat_map<boost::uuids::uuid, TreasureChest,
-                                 BoostUUIDHash>
-      treasure_chest_dict =
-          robin_hood::unordered_flat_map<boost::uuids::uuid, TreasureChest,
-                                         BoostUUIDHash>();
-  robin_hood::unordered_flat_map<boost::uuids::uuid, Unit, BoostUUIDHash>
-      unit_dict = robin_hood::unordered_flat_map<boost::uuids::uuid, Unit,
-                                                 BoostUUIDHash>();
-  robin_hood::unordered_flat_map<boost::uuids::uuid, Item, BoostUUIDHash>
-      item_dict = robin_hood::unordered_flat_map<boost::uuids::uuid, Item,
-                                                 BoostUUIDHash>();
-  vector<boost::uuids::uuid> sorted_unit_guids = vector<boost::uuids::uuid>();
+  // walkability of the tiles at move grid resolution, kept in sync with
+  // Tile::is_obstacle through set_tile_is_obstacle.
+  MoveGrid move_grid = MoveGrid();
+  // which move grid points unit hitboxes cover, see add_unit/erase_unit_handle.
+  OccupancyGrid occupancy_grid = OccupancyGrid();
+  // one abstract graph per hitbox size, see get_path_cluster_graph.
+  vector<PathClusterGraph> path_cluster_graphs = vector<PathClusterGraph>();
+  // reused by deliver_path_results every frame
+  vector<PathResult> path_results = vector<PathResult>();
+  vector<MapLayer> layers = vector<MapLayer>();
+  // the tile points update and draw touch (x, y is the first tile point,
+  // w, h the number of tiles). Set from the camera in update so draw uses
+  // the range the sprites were updated with.
+  Rect visible_tile_rect = Rect(0, 0, 0, 0);
+  // the largest tile or layer sprite src, a sprite can reach this far
+  // into the visible tiles from outside of them.
+  Vec2 max_sprite_dims = Vec2(TILE_SIZE, TILE_SIZE);
+  // the camera the visible tiles were found with, the baked chunks are
+  // drawn with it too.
+  Vec2 visible_camera_dst = Vec2(0, 0);
+  // chunk_rows chunks along x, chunk_cols along y. A chunk's version
+  // changes whenever one of its tile or layer sprites does, the
+  // MapRenderer rebakes chunks whose version it hasn't seen.
+  int chunk_rows = 0;
+  int chunk_cols = 0;
+  vector<uint32_t> chunk_versions = vector<uint32_t>();
+  // keyed by the entities' handles, see EntityRegistry. Iterate over
+  // .items, adding or erasing moves entities around.
+  EntityMap<TreasureChest> treasure_chest_dict = EntityMap<TreasureChest>();
+  EntityMap<Unit> unit_dict = EntityMap<Unit>();
+  EntityMap<Item> item_dict = EntityMap<Item>();
+  // units in draw order, highest y first. Kept up to date by add_unit,
+  // erase_unit_handle and sort_unit_handles.
+  vector<EntityHandle> sorted_unit_handles = vector<EntityHandle>();
+  // where the units, items and treasure chests are, moved along with their
+  // sprites in update. Entities are added and erased through add_unit,
+  // add_item etc.
+  SpatialGrid unit_grid = SpatialGrid();
+  SpatialGrid item_grid = SpatialGrid();
+  SpatialGrid treasure_chest_grid = SpatialGrid();
+  // reused by the spatial grid queries
+  vector<EntityHandle> nearby_handles = vector<EntityHandle>();
+  vector<EntityHandle> mouse_over_unit_handles = vector<EntityHandle>();
+  vector<EntityHandle> mouse_over_item_handles = vector<EntityHandle>();
+  vector<EntityHandle> mouse_over_treasure_chest_handles =
+      vector<EntityHandle>();
   robin_hood::unordered_flat_map<boost::uuids::uuid, Battle, BoostUUIDHash>
       battle_dict = robin_hood::unordered_flat_map<boost::uuids::uuid, Battle,
                                                    BoostUUIDHash>();
   Pool<Ability> abilities = Pool<Ability>();
-  vector<boost::uuids::uuid> item_guids_to_remove_at_end_of_frame =
-      vector<boost::uuids::uuid>();
+  vector<EntityHandle> item_handles_to_remove_at_end_of_frame =
+      vector<EntityHandle>();
   vector<boost::uuids::uuid> battle_guids_to_remove_at_end_of_frame =
       vector<boost::uuids::uuid>();
   vector<int> ability_handles_to_release_at_end_of_frame = vector<int>();
@@ -84,6 +126,7 @@ struct Map {
   Map();
   Map(Game &game);
   Map(Game &game, int _rows, int _cols);
+  void set_ui(Game &game);
   void update(Game &game);
   void process_game_events(Game &game);
   void update_battle_input(Game &game, Unit &acting_unit);
@@ -95,44 +138,67 @@ struct Map {
                           Vec2 start, Vec2 target);
   void update_ability_selected(Game &game, Unit &acting_unit,
                                const Ability &ability);
+  int set_battle_path(Game &game, Unit &acting_unit, Vec2 start, Vec2 target);
   pair<int, Vec2> get_ap_of_move(Game &game, Unit &acting_unit, Vec2 start,
                                  Vec2 target);
-  vector<boost::uuids::uuid>
-  get_receiving_unit_guids(Game &game, const Ability &ability, Vec2 target_dst);
-  vector<boost::uuids::uuid>
+  vector<EntityHandle> get_receiving_unit_handles(Game &game,
+                                                  const Ability &ability,
+                                                  Vec2 target_dst);
+  vector<EntityHandle>
   get_units_in_aoe(Game &game, const Ability &ability, Vec2 target_dst);
   void update_non_battle_input(Game &game, Unit &acting_unit);
   void draw(Game &game);
+  void set_visible_tile_rect(Game &game);
+  void set_max_sprite_dims();
+  void expand_max_sprite_dims(const Sprite &sprite);
+  void build_chunk_versions();
+  void set_tile_sprites_changed(Vec2 tile_point);
+  int get_chunk_idx(Vec2 tile_point);
   void create_battle(Game &game, Unit &acting_unit);
   void check_if_battle_start(Game &game, Unit &acting_unit);
   void pickup_nearby_items(Game &game, Unit &acting_unit);
   void handle_in_dialogue(Game &game, Unit &acting_unitd);
   void handle_on_unit_click(Game &game, Unit &acting_unit,
-                            boost::uuids::uuid unit_guid);
+                            EntityHandle unit_handle);
   void handle_on_treasure_chest_click(Game &game, Unit &acting_unit,
-                                      boost::uuids::uuid treasure_chest_guid);
+                                      EntityHandle treasure_chest_handle);
   bool point_in_bounds(Vec2 &p);
   bool point_in_bounds_move_grid(Vec2 &p);
-  bool unit_occupies_tile_point_move_grid(Game &game,
-                                          const Rect &tile_point_hit_box,
-                                          boost::uuids::uuid acting_unit_guid);
-  void start_ability_timeout(Game &game, boost::uuids::uuid acting_unit_guid,
-                             vector<boost::uuids::uuid> &receiving_unit_guids,
+  void build_move_grid();
+  void build_spatial_grids();
+  void set_tile_is_obstacle(Vec2 tile_point, bool is_obstacle);
+  void deliver_path_results(Game &game);
+  PathClusterGraph &get_path_cluster_graph(Vec2 hit_box_dims);
+  void start_ability_timeout(Game &game, EntityHandle acting_unit_handle,
+                             vector<EntityHandle> &receiving_unit_handles,
                              const Ability &ability, Vec2 target_point,
                              PerformAbilityContext _ability_contex);
-  void perform_ability(Game &game, boost::uuids::uuid acting_unit_guid,
-                       vector<boost::uuids::uuid> &receiving_unit_guids,
+  void perform_ability(Game &game, EntityHandle acting_unit_handle,
+                       vector<EntityHandle> &receiving_unit_handles,
                        const Ability &ability, Vec2 target_point,
                        PerformAbilityContext _ability_context);
-  void set_sorted_unit_guids();
-  void erase_unit_guid(Game &game, boost::uuids::uuid _unit_guid);
+  void sort_unit_handles();
+  void insert_sorted_unit_handle(EntityHandle unit_handle);
+  void add_unit(Game &game, Unit &unit);
+  void erase_unit_handle(Game &game, EntityHandle _unit_handle);
+  void add_item(Game &game, Item &item);
+  void erase_item_handle(Game &game, EntityHandle item_handle);
+  void add_treasure_chest(Game &game, TreasureChest &treasure_chest);
+  void erase_treasure_chest_handle(Game &game,
+                                   EntityHandle treasure_chest_handle);
+  void release_entity_handle(Game &game, EntityHandle handle);
+  void release_entity_handles(Game &game);
+  void add_entity_guids(
+      robin_hood::unordered_flat_set<boost::uuids::uuid, BoostUUIDHash>
+          &guids);
   Unit &get_player_unit();
-  bool is_guid_in_all_player_units(boost::uuids::uuid unit_guid);
+  bool is_handle_in_all_player_units(EntityHandle unit_handle);
   void add_all_player_units(Game &game);
-  void remove_item_guid_at_end_of_frame(boost::uuids::uuid item_guid);
+  void remove_item_handle_at_end_of_frame(EntityHandle item_handle);
 };
 
-void map_transition(Game &game, string &file_path, Vec2 warp_to_map_tile_point);
+uint32_t get_next_map_chunk_version();
+void map_transition(Game &game, Map &map, Vec2 warp_to_map_tile_point);
 void map_serialize(Game &game, Map &map, bool is_save_file = false);
 void map_serialize_into_file(Game &game, Map &map, const char *file_path,
                              bool is_save_file = false);
@@ -140,5 +206,15 @@ Map map_deserialize_from_file(Game &game, const char *file_path,
                               bool is_save_file = false);
 Map map_deserialize(Game &game, GenericObject<false, Value> &obj,
                     bool is_save_file = false);
+void map_deserialize_tiles(Game &game, GenericObject<false, Value> &obj,
+                           Map &map);
+void map_deserialize_entities(Game &game, GenericObject<false, Value> &obj,
+                              Map &map, bool is_save_file = false);
+void map_serialize_into_binary_file(Game &game, Map &map,
+                                    const char *file_path);
+Map map_deserialize_from_binary_file(Game &game, const char *file_path);
+void map_deserialize_tiles_binary(Game &game, MapFileView &view, Map &map);
+void map_deserialize_entities_binary(Game &game, MapFileView &view,
+                                     Map &map);
 
 #endif // MAP_H
@@ -0,0 +1,129 @@
+#ifndef MAP_FILE_H
+#define MAP_FILE_H
+#include "rapidjson/document.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+using namespace std;
+using namespace rapidjson;
+
+// the binary map format. Everything is little endian, the records are
+// written and read as they are laid out in memory, so only little endian
+// hosts can read and write it. A file is:
+//   MapFileHeader
+//   MapFileSrc[num_srcs], the srcs of every sprite, sprites point at a run
+//     of them and sprites with the same srcs share a run
+//   strings_num_bytes of nul terminated strings, padded to 4 bytes
+//   MapFileTile[rows * cols]
+//   num_layers times: uint32 n, MapFileLayerSprite[n]
+//   units, treasure chests and items: uint32 n, then n times uint32 len and
+//     len bytes of the entity's json
+// Entities are kept as json as they are few and their fields change often.
+// The format is for map prefabs, save files stay json. It doesn't depend on
+// the game so the map_converter target can build it from json alone.
+#define MAP_FILE_MAGIC "LMAP"
+#define MAP_FILE_VERSION 1
+#define MAP_FILE_EXTENSION ".lmap"
+#define MAP_FILE_NO_STRING -1
+
+struct MapFileHeader {
+  char magic[4];
+  uint32_t version;
+  int32_t rows;
+  int32_t cols;
+  uint32_t num_srcs;
+  uint32_t strings_num_bytes;
+  uint32_t num_layers;
+  uint32_t reserved;
+};
+
+struct MapFileSrc {
+  int32_t x;
+  int32_t y;
+  int32_t w;
+  int32_t h;
+};
+
+struct MapFileSprite {
+  int32_t image_name;
+  int32_t dst_x;
+  int32_t dst_y;
+  int32_t dst_w;
+  int32_t dst_h;
+  uint32_t anim_speed;
+  uint32_t first_src;
+  uint32_t num_srcs;
+};
+
+struct MapFileTile {
+  MapFileSprite sprite;
+  int32_t warps_to_tile_point_x;
+  int32_t warps_to_tile_point_y;
+  // byte offset into the strings, MAP_FILE_NO_STRING for none
+  int32_t warps_to_map_file_path;
+  uint8_t is_obstacle;
+  uint8_t is_warp_point;
+  uint8_t padding[2];
+};
+
+struct MapFileLayerSprite {
+  int32_t tile_idx;
+  MapFileSprite sprite;
+};
+
+static_assert(sizeof(MapFileHeader) == 32, "MapFileHeader is written as is");
+static_assert(sizeof(MapFileSrc) == 16, "MapFileSrc is written as is");
+static_assert(sizeof(MapFileTile) == 48, "MapFileTile is written as is");
+static_assert(sizeof(MapFileLayerSprite) == 36,
+              "MapFileLayerSprite is written as is");
+
+// an entity's json in the file
+struct MapFileEntity {
+  const char *json = nullptr;
+  uint32_t num_bytes = 0;
+};
+
+// the sections of a map file, pointing into its bytes (which have to
+// outlive it). Records can be unaligned, copy them out with memcpy.
+struct MapFileView {
+  MapFileHeader header = MapFileHeader();
+  const char *srcs = nullptr;
+  const char *strings = nullptr;
+  const char *tiles = nullptr;
+  vector<const char *> layers = vector<const char *>();
+  vector<uint32_t> layer_num_sprites = vector<uint32_t>();
+  vector<MapFileEntity> units = vector<MapFileEntity>();
+  vector<MapFileEntity> treasure_chests = vector<MapFileEntity>();
+  vector<MapFileEntity> items = vector<MapFileEntity>();
+  bool init(const char *data, size_t num_bytes);
+  string get_string(int32_t offset);
+};
+
+// a read only file mapped into memory, read into a buffer on platforms
+// without mmap.
+class MappedFile {
+public:
+  const char *data = nullptr;
+  size_t num_bytes = 0;
+#ifdef _WIN32
+  void *file_handle = nullptr;
+  void *mapping_handle = nullptr;
+#else
+  int fd = -1;
+#endif
+  MappedFile() = default;
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  ~MappedFile();
+  bool open(const char *file_path);
+  void close();
+};
+
+bool is_little_endian_host();
+string get_binary_map_file_path(const string &json_file_path);
+// obj is a map as map_serialize writes it (not a save file).
+void map_file_write_from_json(GenericObject<false, Value> &obj,
+                              const char *file_path);
+
+#endif // MAP_FILE_H
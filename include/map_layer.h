@@ -0,0 +1,35 @@
+#ifndef MAP_LAYER_H
+#define MAP_LAYER_H
+#include "rapidjson/document.h"
+#include "sprite.h"
+#include "utils.h"
+#include <vector>
+using namespace std;
+using namespace rapidjson;
+
+#define MAP_LAYER_EMPTY -1
+
+struct Game;
+
+// one layer of sprites drawn over the tiles. Most tiles have nothing on a
+// layer, so only the sprites that exist are stored. sprite_idxs[tile_idx]
+// is the tile's sprite in sprites, or MAP_LAYER_EMPTY.
+struct MapLayer {
+  vector<int> sprite_idxs = vector<int>();
+  vector<Sprite> sprites = vector<Sprite>();
+  // the tile idx of each sprite in sprites
+  vector<int> tile_idxs = vector<int>();
+  MapLayer() = default;
+  MapLayer(int num_tiles);
+  Sprite *get_sprite(int tile_idx);
+  Sprite &add_sprite(int tile_idx, Sprite sprite);
+  void remove_sprite(int tile_idx);
+};
+
+void map_layer_serialize(Game &game, MapLayer &map_layer,
+                         SpritePalette *palette = nullptr);
+MapLayer map_layer_deserialize(Game &game, GenericArray<false, Value> &array,
+                               int num_tiles,
+                               SpritePalette *palette = nullptr);
+
+#endif // MAP_LAYER_H
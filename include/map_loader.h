@@ -0,0 +1,94 @@
+#ifndef MAP_LOADER_H
+#define MAP_LOADER_H
+#include "map.h"
+#include "map_reader.h"
+#include "rapidjson/document.h"
+#include "utils.h"
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace std;
+using namespace rapidjson;
+
+// loaded maps past this are dropped, least recently used first
+#define MAP_CACHE_MAX_BYTES (128 * 1024 * 1024)
+// the maps of warp points this many tiles from the player are prefetched
+#define MAP_PREFETCH_TILE_RADIUS 8
+
+struct Game;
+
+// a map file as the MapLoader's thread left it: the json and the reader
+// that read it (which points into buffer), or the mapped binary map when
+// there is one, and a
+// map with only its tiles and layers built. Entries aren't changed once
+// they're in the cache.
+struct MapCacheEntry {
+  string file_path = "";
+  vector<char> buffer = vector<char>();
+  MapReader reader = MapReader();
+  bool is_binary = false;
+  MappedFile binary_file;
+  MapFileView binary_view = MapFileView();
+  Map map = Map();
+  size_t num_bytes = 0;
+  uint64_t last_used = 0;
+};
+
+// loads map files on a background thread while the current map keeps
+// updating and drawing. The thread reads a file and builds the tiles and
+// layers of a staging map with a MapReader, which only reads static game
+// data. The binary map next to a json one
+// (get_binary_map_file_path) is used when it exists, the editor saves both
+// so they match. Loaded maps stay in an lru cache capped at
+// MAP_CACHE_MAX_BYTES, so going back to a map or through a prefetched warp
+// point doesn't touch the disk. finish runs on the game thread once
+// is_loaded: the cached map is copied, its ui, units, treasure chests and
+// items are added (they use the entity registry and the guid generator)
+// and it is swapped in with map_transition, so every visit starts from the
+// map file as before. No gl work happens here, the MapRenderer bakes the
+// new map's chunks on the game thread when they are first drawn.
+class MapLoader {
+public:
+  bool is_stopping = false;
+  thread worker;
+  mutex jobs_mutex;
+  condition_variable jobs_cv;
+  // file paths waiting to be loaded, the map being transitioned to goes
+  // first
+  deque<string> jobs = deque<string>();
+  string loading_file_path = "";
+  // guarded by jobs_mutex
+  vector<shared_ptr<MapCacheEntry>> cache =
+      vector<shared_ptr<MapCacheEntry>>();
+  size_t cache_num_bytes = 0;
+  uint64_t use_count = 0;
+  bool is_transitioning = false;
+  string transition_file_path = "";
+  Vec2 warp_to_map_tile_point = Vec2(0, 0);
+  Vec2 prefetch_tile_point = Vec2(-1, -1);
+  MapLoader() = default;
+  ~MapLoader();
+  void start(Game &game);
+  void stop();
+  void load(Game &game, string &file_path, Vec2 _warp_to_map_tile_point);
+  void prefetch(string &file_path);
+  void prefetch_near_player(Game &game);
+  bool is_loaded();
+  void finish(Game &game);
+  void erase(string &file_path);
+  size_t get_cache_num_bytes();
+  int get_cache_size();
+  void run_worker(Game &game);
+  shared_ptr<MapCacheEntry> load_entry(Game &game, string &file_path);
+  shared_ptr<MapCacheEntry> find_entry(string &file_path);
+  bool is_queued(string &file_path);
+  void add_entry(shared_ptr<MapCacheEntry> entry);
+};
+
+size_t get_map_num_bytes(Map &map);
+
+#endif // MAP_LOADER_H
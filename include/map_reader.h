@@ -0,0 +1,126 @@
+#ifndef MAP_READER_H
+#define MAP_READER_H
+#include "map.h"
+#include "rapidjson/memorystream.h"
+#include "rapidjson/reader.h"
+#include "robin_hood.h"
+#include "sprite.h"
+#include "tile.h"
+#include "utils.h"
+#include <stddef.h>
+#include <string>
+#include <vector>
+using namespace std;
+using namespace rapidjson;
+
+// deepest a map's tiles and layers nest (a tile's sprite's srcs' rects)
+// with some room to spare, deeper values are ignored
+#define MAP_READER_MAX_DEPTH 16
+
+// the top level keys of a map file
+enum class MapReaderSection {
+  None,
+  Rows,
+  Cols,
+  SpritePalette,
+  Tiles,
+  Layer,
+  AllPlayerUnitGuids,
+  Units,
+  TreasureChests,
+  Items,
+};
+
+// the keys of tiles, layer sprites and sprites
+enum class MapReaderKey {
+  None,
+  Sprite,
+  IsObstacle,
+  IsWarpPoint,
+  WarpsToTilePoint,
+  WarpsToMapFilePath,
+  TileIdx,
+  Dst,
+  ImageName,
+  AnimSpeed,
+  Srcs,
+  PaletteIdx,
+  X,
+  Y,
+  W,
+  H,
+};
+
+// a sprite as it is read, resolved into a Sprite when it ends
+struct MapReaderSprite {
+  Rect dst = Rect(0, 0, 0, 0);
+  ImageName image_name = ImageName::None;
+  Uint32 anim_speed = 0;
+  vector<Rect> srcs = vector<Rect>();
+  int palette_idx = -1;
+};
+
+// a unit, treasure chest or item's json, a slice of the map file
+struct MapReaderEntity {
+  size_t offset = 0;
+  size_t num_bytes = 0;
+};
+
+// reads a map file with rapidjson's sax Reader. The tiles, layers and their
+// sprites are built as the json is parsed, without a document of the whole
+// file, and each distinct image is looked up once. Entities are a small
+// part of a map and their deserializers are shared with prefabs and save
+// files, so only where each one is in the json is kept and read_entities
+// parses them one at a time. read only reads static game data (the images)
+// so the MapLoader runs it on its thread, read_entities runs on the game
+// thread. The json has to outlive the reader.
+struct MapReader : public BaseReaderHandler<UTF8<>, MapReader> {
+  Game *game = nullptr;
+  Map *map = nullptr;
+  const char *json = nullptr;
+  MemoryStream *stream = nullptr;
+  int depth = 0;
+  MapReaderSection section = MapReaderSection::None;
+  MapReaderKey keys[MAP_READER_MAX_DEPTH];
+  // the depth of the sprite being read, 0 when there isn't one
+  int sprite_depth = 0;
+  MapReaderSprite reader_sprite = MapReaderSprite();
+  // the last sprite read
+  Sprite sprite = Sprite();
+  Tile tile = Tile();
+  SpritePalette palette = SpritePalette();
+  robin_hood::unordered_flat_map<int, Image> images =
+      robin_hood::unordered_flat_map<int, Image>();
+  int layer_idx = 0;
+  int layer_entry_idx = 0;
+  int layer_tile_idx = -1;
+  size_t entity_offset = 0;
+  vector<MapReaderEntity> units = vector<MapReaderEntity>();
+  vector<MapReaderEntity> treasure_chests = vector<MapReaderEntity>();
+  vector<MapReaderEntity> items = vector<MapReaderEntity>();
+  bool has_all_player_unit_guids = false;
+  vector<string> all_player_unit_guids = vector<string>();
+  MapReader() = default;
+  bool read(Game &_game, const char *_json, size_t num_bytes, Map &_map);
+  void read_entities(Game &_game, Map &_map, bool is_save_file = false);
+  void start_sprite();
+  void end_sprite();
+  Image get_image(ImageName image_name);
+  void set_int(int value);
+  // sax handler
+  bool Null() { return true; }
+  bool Bool(bool value);
+  bool Int(int value);
+  bool Uint(unsigned value);
+  bool Int64(int64_t value);
+  bool Uint64(uint64_t value);
+  bool Double(double value);
+  bool String(const char *str, SizeType len, bool copy);
+  bool Key(const char *str, SizeType len, bool copy);
+  bool StartObject();
+  bool EndObject(SizeType member_count);
+  bool StartArray();
+  bool EndArray(SizeType element_count);
+};
+
+#endif // MAP_READER_H
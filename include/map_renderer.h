@@ -0,0 +1,106 @@
+#ifndef MAP_RENDERER_H
+#define MAP_RENDERER_H
+#include "engine.h"
+#include "robin_hood.h"
+#include "utils.h"
+#include <vector>
+using namespace std;
+
+// the stage of the tiles in a chunk, layer l is stage l + 1.
+#define MAP_CHUNK_TILE_STAGE 0
+
+struct Game;
+struct Map;
+struct Sprite;
+
+// consecutive quads in a chunk's buffers that share a texture.
+struct MapChunkBatch {
+  GLuint texture_id = 0;
+  int first_vertex = 0;
+  int num_vertices = 0;
+};
+
+// animated sprites with the same number of srcs and anim speed that were
+// spawned at the same point in their cycle (spawn_time % the cycle's
+// length) are always on the same frame, whatever their srcs are. Deserialized
+// sprites all spawn at 0, so most of a map's animated sprites share a
+// clock.
+struct MapAnimationClockKey {
+  int num_frames = 0;
+  Uint32 anim_speed = 1;
+  Uint32 phase = 0;
+};
+
+struct MapAnimationClockKeyHash {
+  size_t operator()(const MapAnimationClockKey &key) const {
+    return robin_hood::hash_bytes(&key, sizeof(MapAnimationClockKey));
+  }
+};
+
+bool operator==(const MapAnimationClockKey &k1, const MapAnimationClockKey &k2);
+
+// the frame idx of a clock's sprites, worked out once a frame.
+struct MapAnimationClock {
+  MapAnimationClockKey key = MapAnimationClockKey();
+  int frame_idx = 0;
+};
+
+// a sprite with more than one src, its quad is rewritten when its clock's
+// frame changes.
+struct MapChunkAnimation {
+  int stage = MAP_CHUNK_TILE_STAGE;
+  int tile_idx = 0;
+  int quad_idx = 0;
+  int clock_idx = 0;
+  int frame_idx = 0;
+};
+
+// the tile and layer sprites of one chunk, in world points, on the gpu.
+// stage_batch_idxs[k] is the first batch of stage k, the last entry is
+// batches.size().
+struct MapChunkMesh {
+  uint32_t version = 0;
+  GLuint vao = 0;
+  GLuint vbo = 0;
+  GLuint ubo = 0;
+  vector<MapChunkBatch> batches = vector<MapChunkBatch>();
+  vector<int> stage_batch_idxs = vector<int>();
+  vector<MapChunkAnimation> animations = vector<MapChunkAnimation>();
+};
+
+// draws the map's tiles and layers from buffers baked once per chunk, so
+// the static world costs a few draw calls a frame instead of a render
+// buffer push per sprite. Chunks are baked when they are first visible and
+// again when Map::set_tile_sprites_changed changes their version. Lives on
+// Game rather than Map as maps are copied and the gl buffers can't be.
+// Tiles are drawn chunk by chunk along x and layers chunk by chunk from the
+// top, so a sprite wider and taller than a tile that crosses the right edge
+// of its chunk can be ordered differently against the next chunk than it
+// was when the whole map was drawn tile by tile. Vertices are shorts so the
+// map can be at most 32767 world points a side.
+struct MapRenderer {
+  vector<MapChunkMesh> meshes = vector<MapChunkMesh>();
+  // clocks are kept for the whole session, clock_idxs finds them by key
+  vector<MapAnimationClock> clocks = vector<MapAnimationClock>();
+  robin_hood::unordered_flat_map<MapAnimationClockKey, int,
+                                 MapAnimationClockKeyHash>
+      clock_idxs = robin_hood::unordered_flat_map<MapAnimationClockKey, int,
+                                                  MapAnimationClockKeyHash>();
+  // reused by bake
+  vector<short> vertices = vector<short>();
+  vector<float> uvs = vector<float>();
+  void update(Game &game, Map &map);
+  void draw_tiles(Game &game, Map &map);
+  void draw_layers(Game &game, Map &map);
+  void draw_stage(Game &game, Map &map, int chunk_idx, int stage);
+  void bake(Game &game, Map &map, int chunk_idx);
+  void add_sprite(Game &game, MapChunkMesh &mesh, Sprite &sprite, int stage,
+                  int tile_idx);
+  void update_animations(Game &game, Map &map, MapChunkMesh &mesh);
+  void update_clocks(Game &game);
+  int get_clock_idx(Game &game, Sprite &sprite);
+  Sprite *get_sprite(Map &map, int stage, int tile_idx);
+  Rect get_visible_chunk_rect(Map &map);
+};
+
+#endif // MAP_RENDERER_H
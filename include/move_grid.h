@@ -0,0 +1,44 @@
+#ifndef MOVE_GRID_H
+#define MOVE_GRID_H
+#include "utils.h"
+#include <stdint.h>
+#include <vector>
+using namespace std;
+
+// clearances are stored in a byte, and capping them keeps the area that
+// has to be recomputed when a tile changes small.
+#define MOVE_GRID_MAX_CLEARANCE 64
+
+// every change to a MoveGrid or OccupancyGrid stamps it with a new version,
+// so two grids with the same version have the same contents. Path request
+// snapshots use it to tell when they are out of date.
+uint32_t get_next_walkability_version();
+
+// the walkability of a map at move grid resolution. walkable is a packed
+// bitmap with one bit per move grid point, built from the tile obstacles.
+// clearances[idx] is the side of the largest obstacle free square with its
+// bottom left corner at idx (0 if the point itself is not walkable), so a
+// hitbox can be tested against the obstacles with a lookup per square
+// instead of testing every point it covers. The map edge counts as an
+// obstacle.
+struct MoveGrid {
+  int rows = 0;
+  int cols = 0;
+  uint32_t version = 0;
+  vector<uint64_t> walkable = vector<uint64_t>();
+  vector<uint8_t> clearances = vector<uint8_t>();
+  MoveGrid();
+  MoveGrid(int _rows, int _cols);
+  int get_idx(Vec2 p) const;
+  bool point_in_bounds(Vec2 p) const;
+  bool is_walkable(Vec2 p) const;
+  int get_clearance(Vec2 p) const;
+  bool rect_is_walkable(const Rect &rect) const;
+  void set_walkable(Vec2 p, bool is_walkable);
+  void set_tile_is_obstacle(Vec2 tile_point, bool is_obstacle,
+                            bool update_clearances_after = true);
+  void update_clearances(Rect area);
+  void update_all_clearances();
+};
+
+#endif // MOVE_GRID_H
@@ -0,0 +1,62 @@
+#ifndef MOVE_RANGE_FIELD_H
+#define MOVE_RANGE_FIELD_H
+#include "move_grid.h"
+#include "occupancy_grid.h"
+#include "utils.h"
+#include <boost/uuid/uuid.hpp>
+#include <stdint.h>
+#include <vector>
+using namespace std;
+
+#define MOVE_RANGE_UNKNOWN -1
+#define MOVE_RANGE_BLOCKED -2
+
+// every move grid point a unit can reach in at most max_steps steps, found
+// with a breadth first search from origin. Steps are uniform cost like
+// PathFinder so the paths are as short as A*'s. Battles build one for the
+// acting unit when its turn starts and when it stops moving, hovering a
+// point then only walks came_from back to the origin. reached_idxs lists
+// the reachable points in the order they were found, which is also what
+// to iterate to draw the reachable area. A field is out of date once the
+// unit, its origin, its move budget or the move grid changes, or units come
+// or go inside area (every hitbox the search can test), see is_stale.
+struct MoveRangeField {
+  EntityHandle unit_handle;
+  bool is_valid = false;
+  Vec2 origin = Vec2(0, 0);
+  int max_steps = 0;
+  uint32_t move_grid_version = 0;
+  Rect area = Rect(0, 0, 0, 0);
+  uint32_t area_occupancy_version = 0;
+  int rows = 0;
+  int cols = 0;
+  // steps from the origin, or MOVE_RANGE_UNKNOWN/MOVE_RANGE_BLOCKED
+  vector<int> steps = vector<int>();
+  vector<int> came_from = vector<int>();
+  // reached points at max_steps that have an unreached passable neighbour,
+  // the unit could keep going from them with more action points.
+  vector<uint8_t> is_range_edge = vector<uint8_t>();
+  vector<int> reached_idxs = vector<int>();
+  // every idx that was written, so the next set only resets those
+  vector<int> touched_idxs = vector<int>();
+  // hover asks for the same target every frame
+  Vec2 closest_point_target = Vec2(-1, -1);
+  Vec2 closest_point = Vec2(0, 0);
+  MoveRangeField();
+  void set(const MoveGrid &move_grid, const OccupancyGrid &occupancy_grid,
+           EntityHandle _unit_handle, Rect hit_box, Vec2 _origin,
+           int _max_steps);
+  void invalidate();
+  bool is_stale(const MoveGrid &move_grid, const OccupancyGrid &occupancy_grid,
+                EntityHandle _unit_handle, Vec2 _origin, int _max_steps);
+  bool is_reachable(Vec2 p);
+  int get_steps(Vec2 p);
+  Vec2 get_closest_point(Vec2 target);
+  bool is_out_of_range(Vec2 reachable_point, Vec2 target);
+  void set_path(Vec2 target, vector<Vec2> &path);
+  bool point_in_bounds(Vec2 p);
+  int get_idx(Vec2 p);
+  Vec2 get_point(int idx);
+};
+
+#endif // MOVE_RANGE_FIELD_H
@@ -0,0 +1,48 @@
+#ifndef OCCUPANCY_GRID_H
+#define OCCUPANCY_GRID_H
+#include "entity_handle.h"
+#include "robin_hood.h"
+#include "utils.h"
+#include <stdint.h>
+#include <vector>
+using namespace std;
+
+// which move grid points are covered by unit hitboxes. counts[idx] is the
+// number of units covering the point (units can overlap when they path
+// through each other), tile_counts is the same per tile so that most
+// queries only look at a handful of tiles. unit_hit_boxes is the hitbox
+// each unit was added with, it is what gets subtracted when a query ignores
+// a unit. tile_versions is the version each tile last changed at, so a
+// cache over part of the map only goes stale when that part changes (see
+// get_area_version).
+struct OccupancyGrid {
+  int rows = 0;
+  int cols = 0;
+  int tile_rows = 0;
+  int tile_cols = 0;
+  // see get_next_walkability_version
+  uint32_t version = 0;
+  vector<uint16_t> counts = vector<uint16_t>();
+  vector<uint16_t> tile_counts = vector<uint16_t>();
+  vector<uint32_t> tile_versions = vector<uint32_t>();
+  robin_hood::unordered_flat_map<EntityHandle, Rect, EntityHandleHash>
+      unit_hit_boxes = robin_hood::unordered_flat_map<EntityHandle, Rect,
+                                                      EntityHandleHash>();
+  OccupancyGrid();
+  OccupancyGrid(int _rows, int _cols);
+  void add_unit(EntityHandle unit_handle, Rect hit_box);
+  void remove_unit(EntityHandle unit_handle);
+  void move_unit(EntityHandle unit_handle, Rect hit_box);
+  bool contains_unit(EntityHandle unit_handle) const;
+  Rect get_unit_hit_box(EntityHandle unit_handle) const;
+  bool rect_is_occupied(const Rect &rect,
+                        EntityHandle ignored_unit_handle) const;
+  bool rect_is_occupied(const Rect &rect, const Rect &ignored_hit_box) const;
+  void add_rect(const Rect &rect, int amount);
+  bool half_open_rect_contains(const Rect &rect, int x, int y) const;
+  Rect clip_rect(const Rect &rect) const;
+  Rect get_tile_area(const Rect &clipped_rect) const;
+  uint32_t get_area_version(const Rect &rect) const;
+};
+
+#endif // OCCUPANCY_GRID_H
@@ -0,0 +1,93 @@
+#ifndef PATH_CLUSTER_GRAPH_H
+#define PATH_CLUSTER_GRAPH_H
+#include "move_grid.h"
+#include "utils.h"
+#include <queue>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+using namespace std;
+
+// clusters are square chunks of tiles
+#define PATH_CLUSTER_TILES 4
+#define PATH_CLUSTER_SIZE (PATH_CLUSTER_TILES * MOVE_GRID_RATIO)
+// entrances at least this long get a node at each end, shorter ones get
+// one node in the middle.
+#define PATH_CLUSTER_LONG_ENTRANCE 6
+// node keys are cluster_idx * PATH_CLUSTER_MAX_NODES + node idx
+#define PATH_CLUSTER_MAX_NODES 256
+
+// a point on the edge of a cluster where the unit can cross into the
+// neighbouring cluster, partner is the point it crosses to.
+struct PathClusterNode {
+  Vec2 p;
+  Vec2 partner;
+  PathClusterNode();
+  PathClusterNode(Vec2 _p, Vec2 _partner);
+};
+
+// costs[i * nodes.size() + j] is the number of steps from node i to node
+// j without leaving the cluster, -1 if it can't be reached that way.
+struct PathCluster {
+  Rect area = Rect(0, 0, 0, 0);
+  bool is_dirty = true;
+  vector<PathClusterNode> nodes = vector<PathClusterNode>();
+  vector<int> costs = vector<int>();
+};
+
+// the abstract graph for hierarchical pathfinding (HPA*) over a move grid
+// for one hitbox size. Clusters are built lazily and only dirty ones are
+// rebuilt, mark_tile_dirty is called when a tile obstacle changes.
+// set_waypoints searches the abstract graph and gives the cluster edge
+// points to walk through, each one is close enough to the previous one to
+// be refined with PathFinder when the unit gets there. Units are not part
+// of the graph, only obstacles.
+struct PathClusterGraph {
+  Vec2 hit_box_dims = Vec2(0, 0);
+  int rows = 0;
+  int cols = 0;
+  int cluster_rows = 0;
+  int cluster_cols = 0;
+  vector<PathCluster> clusters = vector<PathCluster>();
+  bool waypoints_found = false;
+  // excludes the start, ends with the target
+  vector<Vec2> waypoints = vector<Vec2>();
+  // abstract search state, generation stamped the same way as PathFinder
+  uint32_t search_generation = 0;
+  vector<uint32_t> key_generations = vector<uint32_t>();
+  vector<int> g_costs = vector<int>();
+  vector<int> came_from = vector<int>();
+  vector<uint8_t> is_closed = vector<uint8_t>();
+  // (f, key), stale entries are skipped when popped
+  priority_queue<pair<int, int>, vector<pair<int, int>>,
+                 greater<pair<int, int>>>
+      open_keys = priority_queue<pair<int, int>, vector<pair<int, int>>,
+                                 greater<pair<int, int>>>();
+  // breadth first search inside one cluster, indexed by the point's
+  // position in the cluster
+  vector<int> cluster_distances = vector<int>();
+  vector<int> cluster_queue = vector<int>();
+  vector<int> start_costs = vector<int>();
+  vector<int> target_costs = vector<int>();
+  PathClusterGraph();
+  PathClusterGraph(int _rows, int _cols, Vec2 _hit_box_dims);
+  bool set_waypoints(const MoveGrid &move_grid, Vec2 start, Vec2 target);
+  void mark_tile_dirty(Vec2 tile_point);
+  void rebuild_dirty_clusters(const MoveGrid &move_grid);
+  void build_cluster(const MoveGrid &move_grid, int cluster_idx);
+  void add_border_nodes(const MoveGrid &move_grid, PathCluster &cluster,
+                        Vec2 border_start, Vec2 along, Vec2 across,
+                        int length);
+  void set_cluster_distances(const MoveGrid &move_grid,
+                             const PathCluster &cluster, Vec2 from);
+  int get_cluster_distance(const PathCluster &cluster, Vec2 p);
+  void set_costs_to_nodes(const MoveGrid &move_grid, int cluster_idx,
+                          Vec2 from, vector<int> &costs);
+  void open_key(int key, int parent_key, int g_cost, Vec2 p, Vec2 target);
+  bool is_passable(const MoveGrid &move_grid, Vec2 p);
+  int get_cluster_idx(Vec2 p);
+  int find_node_idx(int cluster_idx, Vec2 p, Vec2 partner);
+  Vec2 get_key_point(int key, Vec2 start, Vec2 target);
+};
+
+#endif // PATH_CLUSTER_GRAPH_H
@@ -0,0 +1,104 @@
+#ifndef PATH_REQUEST_SERVICE_H
+#define PATH_REQUEST_SERVICE_H
+#include "move_grid.h"
+#include "occupancy_grid.h"
+#include "pathfinder.h"
+#include "utils.h"
+#include <boost/uuid/uuid.hpp>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+using namespace std;
+
+#define PATH_REQUEST_NONE -1
+#define PATH_REQUEST_MAX_WORKERS 4
+
+struct Map;
+struct Unit;
+
+// the part of the map's OccupancyGrid a search needs: the grid size and
+// every unit's hitbox. It is a few bytes per unit, where copying the grid
+// itself would copy every move point.
+struct OccupancySnapshot {
+  uint32_t version = 0;
+  int rows = 0;
+  int cols = 0;
+  vector<pair<EntityHandle, Rect>> unit_hit_boxes =
+      vector<pair<EntityHandle, Rect>>();
+};
+
+// what a worker keeps between searches. occupancy_grid is rebuilt from a
+// request's OccupancySnapshot, only the hitboxes of the last snapshot are
+// taken out and the new ones put in.
+struct PathWorker {
+  PathFinder path_finder = PathFinder();
+  OccupancyGrid occupancy_grid = OccupancyGrid();
+  shared_ptr<const OccupancySnapshot> occupancy_snapshot = nullptr;
+};
+
+struct PathRequest {
+  int ticket = PATH_REQUEST_NONE;
+  EntityHandle unit_handle;
+  Vec2 start = Vec2(0, 0);
+  Vec2 target = Vec2(0, 0);
+  Rect hit_box = Rect(0, 0, 0, 0);
+  Rect ignored_hit_box = Rect(0, 0, 0, 0);
+  PathFinderMode mode = PathFinderMode::AStar;
+  bool allow_units_to_path_through_each_other = true;
+  shared_ptr<const MoveGrid> move_grid = nullptr;
+  // null when units can path through each other
+  shared_ptr<const OccupancySnapshot> occupancy_snapshot = nullptr;
+};
+
+struct PathResult {
+  int ticket = PATH_REQUEST_NONE;
+  EntityHandle unit_handle;
+  Vec2 start = Vec2(0, 0);
+  Vec2 target = Vec2(0, 0);
+  bool allow_units_to_path_through_each_other = true;
+  bool path_found = false;
+  Vec2 closest_point_to_target = Vec2(0, 0);
+  vector<Vec2> path = vector<Vec2>();
+};
+
+// runs PathFinder searches on worker threads. request_path copies what the
+// search needs out of the map into read-only snapshots (shared between
+// requests until the map's grids change) and returns a ticket. Units step
+// often so the occupancy snapshot is only the unit hitboxes, each worker
+// puts them into its own OccupancyGrid. Workers never touch the map.
+// Finished results wait in results until take_results, which Map::update
+// calls once a frame before the units update, so paths are only ever
+// applied on the game thread.
+class PathRequestService {
+public:
+  int next_ticket = 0;
+  bool is_stopping = false;
+  vector<thread> workers = vector<thread>();
+  // one per worker, a PathFinder's search state isn't shareable
+  vector<PathWorker> path_workers = vector<PathWorker>();
+  // used when there are no workers
+  PathWorker game_thread_path_worker = PathWorker();
+  mutex requests_mutex;
+  condition_variable requests_cv;
+  queue<PathRequest> requests = queue<PathRequest>();
+  vector<PathResult> results = vector<PathResult>();
+  shared_ptr<const MoveGrid> move_grid_snapshot = nullptr;
+  shared_ptr<const OccupancySnapshot> occupancy_snapshot = nullptr;
+  PathRequestService() = default;
+  ~PathRequestService();
+  void start();
+  void stop();
+  int request_path(Map &map, Unit &unit, Vec2 start, Vec2 target,
+                   bool allow_units_to_path_through_each_other,
+                   PathFinderMode mode);
+  void take_results(vector<PathResult> &_results);
+  void run_worker(int worker_idx);
+  void set_occupancy_grid(const PathRequest &request,
+                          PathWorker &path_worker);
+  PathResult find_path(const PathRequest &request, PathWorker &path_worker);
+};
+
+#endif // PATH_REQUEST_SERVICE_H
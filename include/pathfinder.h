@@ -1,43 +1,143 @@
 #ifndef PATHFINDER_H
 #define PATHFINDER_H
+#include "move_grid.h"
+#include "occupancy_grid.h"
 #include "utils.h"
 #include <SDL.h>
-#include <queue>
-#include <unordered_map>
+#include <array>
 #include <utility>
 #include <vector>
 using namespace std;
 
+#define PATH_FINDER_MAX_ITERS 5000
+// jump point search's cap on scanned blocks of 64 points and diagonal
+// steps, A* tests up to 8 points per node it expands.
+#define PATH_FINDER_MAX_SCANS (PATH_FINDER_MAX_ITERS * 8)
+// search used for walks outside of battle and for refining the cluster
+// graph's waypoints, PATH_FINDER_MAX_SCANS bounds it
+#define PATH_FINDER_WALK_MODE PathFinderMode::JumpPoint
+#define NODE_CLOSED -1
+// how many path points ahead smooth_path looks for a straight line to
+#define PATH_SMOOTHING_MAX_LOOKAHEAD 64
+
 struct Game;
 struct Map;
 struct Unit;
 
+// an entry in the open set. idx is the node's index into the move grid,
+// h is kept so that ties on f can be broken towards the target.
 struct NodeF {
-  Vec2 p;
+  int idx;
   int f;
+  int h;
   NodeF();
-  NodeF(Vec2 _p, int _f);
+  NodeF(int _idx, int _f, int _h);
 };
 
-struct CompareNodeF {
-  bool operator()(const NodeF &n1, const NodeF &n2) const {
-    return n1.f > n2.f;
-  }
+// which points a hitbox fits in for jump point search, as bitmaps with a
+// line per move grid row (bit y of line x) and one per column (bit x of
+// line y) so a scan along either axis reads 64 points at a time. The stops
+// are where scans in the increasing or decreasing direction along a line
+// stop (see set_stops).
+struct JumpBits {
+  int rows;
+  int cols;
+  int words_per_row;
+  int words_per_col;
+  vector<uint64_t> passable_by_row;
+  vector<uint64_t> passable_by_col;
+  vector<uint64_t> inc_stops_by_row;
+  vector<uint64_t> dec_stops_by_row;
+  vector<uint64_t> inc_stops_by_col;
+  vector<uint64_t> dec_stops_by_col;
+  JumpBits();
+  void init(int _rows, int _cols);
+  void set_passable(Vec2 p);
+  void set_blocked(Rect area);
+  void set_stops();
+  bool is_passable(int x, int y) const;
+  int scan_straight(int x, int y, int dx, int dy, int &num_scans) const;
 };
 
+// all per node search state is stored in flat arrays indexed by
+// the move grid index of the node. node_generations stamps which search
+// a node's state belongs to, so nothing has to be cleared between
+// searches. a node is unvisited if its stamp is not search_generation.
+// passable_generations does the same for the cached passable_values.
 class PathFinder {
 public:
   bool path_found;
   Vec2 closest_point_to_target;
+  int closest_point_dist;
   vector<Vec2> path;
-  priority_queue<NodeF, vector<NodeF>, CompareNodeF> pq;
-  unordered_map<Vec2, bool, Vec2HashFunction> closed_set;
-  unordered_map<Vec2, Vec2, Vec2HashFunction> came_from;
-  unordered_map<Vec2, int, Vec2HashFunction> g_cost_map;
+  // nodes taken off the open heap by the last search
+  int nodes_expanded;
+  // towards PATH_FINDER_MAX_SCANS in the last jump point search
+  int num_scans;
+  int rows_move_grid;
+  int cols_move_grid;
+  uint32_t search_generation;
+  vector<uint32_t> node_generations;
+  vector<int> g_costs;
+  vector<int> came_from;
+  // position of the node in open_heap, or NODE_CLOSED once expanded.
+  vector<int> heap_positions;
+  vector<NodeF> open_heap;
+  vector<uint32_t> passable_generations;
+  vector<uint8_t> passable_values;
+  // what the current search tests points against. occupancy_grid is null
+  // when units can path through each other.
+  const MoveGrid *move_grid;
+  const OccupancyGrid *occupancy_grid;
+  Rect hit_box;
+  Rect ignored_hit_box;
+  // smooth_path's copy of the path it is rewriting
+  vector<Vec2> unsmoothed_path;
+  // jump point search's bitmaps, see set_jump_bits. jump_bits points at
+  // the ones the current search reads.
+  uint32_t walkable_jump_bits_version;
+  Vec2 walkable_jump_bits_hit_box_dims;
+  JumpBits walkable_jump_bits;
+  JumpBits unit_jump_bits;
+  const JumpBits *jump_bits;
   PathFinder();
-  void set_path(Game &game, Map &map, Unit &unit, Vec2 start, Vec2 target,
-                bool allow_units_to_path_through_each_other = true);
-  void clear_pq();
+  void set_path(Map &map, Unit &unit, Vec2 start, Vec2 target,
+                bool allow_units_to_path_through_each_other = true,
+                PathFinderMode mode = PathFinderMode::AStar);
+  void find_path(const MoveGrid &_move_grid,
+                 const OccupancyGrid *_occupancy_grid, Rect _hit_box,
+                 Rect _ignored_hit_box, Vec2 start, Vec2 target,
+                 PathFinderMode mode);
+  void smooth_path(const MoveGrid &_move_grid,
+                   const OccupancyGrid *_occupancy_grid, Rect _hit_box,
+                   Rect _ignored_hit_box, Vec2 start, vector<Vec2> &cells,
+                   vector<int> &corner_idxs);
+  void smooth_waypoints(const MoveGrid &_move_grid, Rect _hit_box,
+                        Vec2 start, vector<Vec2> &waypoints);
+  bool has_line_of_sight(Vec2 from, Vec2 to);
+  void add_line_cells(Vec2 from, Vec2 to, vector<Vec2> &cells);
+  void a_star(Vec2 start, Vec2 target);
+  void jump_point_search(Vec2 start, Vec2 target);
+  int jump(Vec2 p, Vec2 dir, Vec2 target);
+  int jump_straight(int x, int y, int dx, int dy, Vec2 target);
+  int get_jump_point_dirs(Vec2 p, int parent_idx, array<Vec2, 8> &dirs);
+  void set_jump_bits();
+  void add_node(int idx, int parent_idx, int g_cost, int f, int h);
+  void set_path_from_came_from(int start_idx, int target_idx);
+  void start_search(int _rows_move_grid, int _cols_move_grid);
+  bool is_passable(Vec2 p);
+  void track_closest_point(Vec2 p, Vec2 target);
+  int get_idx(Vec2 p);
+  Vec2 get_point(int idx);
+  bool is_visited(int idx);
+  void visit(int idx, int g_cost, int _came_from);
+  void open_heap_push(NodeF node);
+  NodeF open_heap_pop();
+  void open_heap_decrease_key(int heap_position, int f);
+  bool open_heap_less(const NodeF &n1, const NodeF &n2);
+  void open_heap_swap(int i, int j);
+  void open_heap_sift_up(int heap_position);
+  void open_heap_sift_down(int heap_position);
 };
 
 #endif // PATHFINDER_H
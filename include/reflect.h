@@ -0,0 +1,185 @@
+#ifndef REFLECT_H
+#define REFLECT_H
+#include "rapidjson/document.h"
+#include "rapidjson/stringbuffer.h"
+#include "rapidjson/writer.h"
+#include <array>
+#include <stddef.h>
+#include <string.h>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+using namespace std;
+using namespace rapidjson;
+
+// compile time field lists for plain data structs. A struct lists its
+// fields once, in the order they are written:
+//   template <> struct Reflect<Vec2> {
+//     static constexpr auto fields = make_tuple(
+//         reflect_field("x", &Vec2::x), reflect_field("y", &Vec2::y));
+//   };
+// and gets a json object with those keys from reflect_serialize and
+// reflect_deserialize. Fields can be bools, ints, uints, doubles, enums (as
+// their underlying type), strings, other reflected structs and vectors of
+// any of those. Structs holding images, sprites or handles need the game to
+// be read and stay hand written.
+
+template <class T> struct Reflect {};
+
+template <class T, class = void> struct IsReflected : false_type {};
+template <class T>
+struct IsReflected<T, void_t<decltype(Reflect<T>::fields)>> : true_type {};
+
+template <class T> struct IsVector : false_type {};
+template <class V> struct IsVector<vector<V>> : true_type {};
+
+template <class T, class M> struct ReflectField {
+  const char *key;
+  size_t key_num_bytes;
+  M T::*member;
+};
+
+struct ReflectKey {
+  const char *key;
+  size_t num_bytes;
+};
+
+template <class T, class M, size_t N>
+constexpr ReflectField<T, M> reflect_field(const char (&key)[N],
+                                           M T::*member) {
+  return ReflectField<T, M>{key, N - 1, member};
+}
+
+template <class T>
+constexpr size_t reflect_num_fields =
+    tuple_size<decay_t<decltype(Reflect<T>::fields)>>::value;
+
+template <class T, size_t... I>
+constexpr array<ReflectKey, sizeof...(I)>
+reflect_get_keys(index_sequence<I...>) {
+  return {{ReflectKey{get<I>(Reflect<T>::fields).key,
+                      get<I>(Reflect<T>::fields).key_num_bytes}...}};
+}
+
+// calls f with the field at idx, idx is only known at runtime
+template <class T, class F, size_t... I>
+void reflect_visit_field(size_t idx, F &&f, index_sequence<I...>) {
+  ((idx == I ? (f(get<I>(Reflect<T>::fields)), true) : false) || ...);
+}
+
+template <class T, class F> void reflect_for_each_field(F &&f) {
+  apply([&](const auto &...field) { (f(field), ...); }, Reflect<T>::fields);
+}
+
+// the index of the key named name, starting the search at next_idx since
+// reflect_serialize writes the fields in order, num_keys when there is no
+// such field.
+template <size_t N>
+size_t reflect_find_key(const array<ReflectKey, N> &keys, const Value &name,
+                        size_t next_idx) {
+  auto name_num_bytes = name.GetStringLength();
+  for (size_t i = 0; i < N; i++) {
+    auto idx = (next_idx + i) % N;
+    if (keys[idx].num_bytes == name_num_bytes &&
+        memcmp(keys[idx].key, name.GetString(), name_num_bytes) == 0) {
+      return idx;
+    }
+  }
+  return N;
+}
+
+// json
+
+template <class T>
+void reflect_serialize(Writer<StringBuffer> &writer, const T &value);
+template <class T> void reflect_deserialize(const Value &json, T &value);
+
+template <class V>
+void reflect_write_json_value(Writer<StringBuffer> &writer, const V &value) {
+  if constexpr (is_same<V, bool>::value) {
+    writer.Bool(value);
+  } else if constexpr (is_enum<V>::value) {
+    writer.Int(static_cast<int>(value));
+  } else if constexpr (is_integral<V>::value && is_signed<V>::value) {
+    static_assert(sizeof(V) <= sizeof(int), "reflected ints are 32 bit");
+    writer.Int(value);
+  } else if constexpr (is_integral<V>::value) {
+    static_assert(sizeof(V) <= sizeof(unsigned), "reflected uints are 32 bit");
+    writer.Uint(value);
+  } else if constexpr (is_floating_point<V>::value) {
+    writer.Double(value);
+  } else if constexpr (is_same<V, string>::value) {
+    writer.String(value.c_str(), value.size());
+  } else if constexpr (IsVector<V>::value) {
+    writer.StartArray();
+    for (auto &element : value) {
+      reflect_write_json_value(writer, element);
+    }
+    writer.EndArray();
+  } else {
+    static_assert(IsReflected<V>::value, "field type isn't reflected");
+    reflect_serialize(writer, value);
+  }
+}
+
+template <class V>
+void reflect_read_json_value(const Value &json, V &value) {
+  if constexpr (is_same<V, bool>::value) {
+    value = json.GetBool();
+  } else if constexpr (is_enum<V>::value) {
+    value = static_cast<V>(json.GetInt());
+  } else if constexpr (is_integral<V>::value && is_signed<V>::value) {
+    value = json.GetInt();
+  } else if constexpr (is_integral<V>::value) {
+    value = json.GetUint();
+  } else if constexpr (is_floating_point<V>::value) {
+    value = json.GetDouble();
+  } else if constexpr (is_same<V, string>::value) {
+    value = string(json.GetString(), json.GetStringLength());
+  } else if constexpr (IsVector<V>::value) {
+    value.clear();
+    for (auto &element : json.GetArray()) {
+      value.emplace_back();
+      reflect_read_json_value(element, value.back());
+    }
+  } else {
+    static_assert(IsReflected<V>::value, "field type isn't reflected");
+    reflect_deserialize(json, value);
+  }
+}
+
+template <class T>
+void reflect_serialize(Writer<StringBuffer> &writer, const T &value) {
+  writer.StartObject();
+  reflect_for_each_field<T>([&](const auto &field) {
+    writer.String(field.key, field.key_num_bytes);
+    reflect_write_json_value(writer, value.*field.member);
+  });
+  writer.EndObject();
+}
+
+// fields that aren't in json keep their value so older files still load,
+// keys that aren't fields are skipped.
+template <class T> void reflect_deserialize(const Value &json, T &value) {
+  constexpr auto num_fields = reflect_num_fields<T>;
+  static constexpr auto keys =
+      reflect_get_keys<T>(make_index_sequence<num_fields>());
+  size_t next_idx = 0;
+  for (auto &member : json.GetObject()) {
+    auto idx = reflect_find_key(keys, member.name, next_idx);
+    if (idx == num_fields) {
+      continue;
+    }
+    reflect_visit_field<T>(
+        idx,
+        [&](const auto &field) {
+          reflect_read_json_value(member.value, value.*field.member);
+        },
+        make_index_sequence<num_fields>());
+    next_idx = idx + 1;
+  }
+}
+
+#endif // REFLECT_H
@@ -1,10 +1,12 @@
 #ifndef SERIALIZER_H
 #define SERIALIZER_H
 #include "engine.h"
+#include "entity_handle.h"
 #include "rapidjson/document.h"
 #include "rapidjson/prettywriter.h" // for stringify JSON
 #include "rapidjson/stringbuffer.h"
 #include "rapidjson/writer.h"
+#include "reflect.h"
 #include <SDL.h>
 #include <vector>
 
@@ -18,6 +20,43 @@ struct Dialogue;
 struct AIWalkPath;
 struct TweenCallback;
 
+// the plain data structs in utils.h, see reflect.h
+template <> struct Reflect<Vec2> {
+  static constexpr auto fields =
+      make_tuple(reflect_field("x", &Vec2::x), reflect_field("y", &Vec2::y));
+};
+
+template <> struct Reflect<Rect> {
+  static constexpr auto fields =
+      make_tuple(reflect_field("x", &Rect::x), reflect_field("y", &Rect::y),
+                 reflect_field("w", &Rect::w), reflect_field("h", &Rect::h));
+};
+
+template <> struct Reflect<DoublePoint> {
+  static constexpr auto fields =
+      make_tuple(reflect_field("x", &DoublePoint::x),
+                 reflect_field("y", &DoublePoint::y));
+};
+
+template <> struct Reflect<Range> {
+  static constexpr auto fields = make_tuple(
+      reflect_field("lower_bound", &Range::lower_bound),
+      reflect_field("current", &Range::current),
+      reflect_field("current_before_status_effects",
+                    &Range::current_before_status_effects),
+      reflect_field("max", &Range::max),
+      reflect_field("upper_bound", &Range::upper_bound));
+};
+
+template <> struct Reflect<Stats> {
+  static constexpr auto fields = make_tuple(
+      reflect_field("hp", &Stats::hp),
+      reflect_field("action_points", &Stats::action_points),
+      reflect_field("damage", &Stats::damage),
+      reflect_field("range", &Stats::range), reflect_field("aoe", &Stats::aoe),
+      reflect_field("cast_time", &Stats::cast_time));
+};
+
 struct Serializer {
   Document doc;
   StringBuffer sb;
@@ -32,11 +71,14 @@ struct Serializer {
   void serialize_string_val(const char *key, string value);
   void serialize_rect(const char *key, Rect &value);
   void serialize_vec2(const char *key, Vec2 &value);
+  void serialize_vec2_vec(const char *key, vector<Vec2> &values);
   void serialize_double_point(const char *key, DoublePoint &value);
   void serialize_sprite_src_vec(const char *key, vector<SpriteSrc> &srcs);
   void serialize_dialogues(vector<Dialogue> &dialogues);
   void serialize_ai_walk_paths(vector<AIWalkPath> &ai_walk_paths);
-  void serialize_tween_callback(TweenCallback &cb);
+  void serialize_tween_callback(Game &game, TweenCallback &cb);
+  void serialize_entity_handle(Game &game, const char *key,
+                               EntityHandle handle);
   void serialize_tile_point_hitbox(Vec2 &hitbox_dims, Rect &tile_point_hit_box);
   void serialize_range(const char *key, Range &range);
   void serialize_stats(const char *key, Stats &stats);
@@ -44,6 +86,8 @@ struct Serializer {
                         Rect &value);
   void deserialize_vec2(GenericObject<false, Value> &obj, const char *key,
                         Vec2 &value);
+  void deserialize_vec2_vec(GenericObject<false, Value> &obj, const char *key,
+                            vector<Vec2> &values);
   void deserialize_double_point(GenericObject<false, Value> &obj,
                                 const char *key, DoublePoint &value);
   void deserialize_sprite_src_vec(GenericObject<false, Value> &obj,
@@ -55,6 +99,8 @@ struct Serializer {
                                  vector<AIWalkPath> &ai_walk_paths);
   void deserialize_tween_callback(Game &game, GenericObject<false, Value> &obj,
                                   TweenCallback &cb);
+  void deserialize_entity_handle(Game &game, GenericObject<false, Value> &obj,
+                                 const char *key, EntityHandle &handle);
   void deserialize_tile_point_hitbox(GenericObject<false, Value> &obj,
                                      Vec2 &hitbox_dims,
                                      Rect &tile_point_hit_box);
@@ -0,0 +1,60 @@
+#ifndef SPATIAL_GRID_H
+#define SPATIAL_GRID_H
+#include "entity_handle.h"
+#include "robin_hood.h"
+#include "utils.h"
+#include <functional>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+using namespace std;
+
+// world points a spatial grid cell covers on each side
+#define SPATIAL_GRID_CELL_SIZE 100
+
+struct SpatialGridEntry {
+  EntityHandle handle;
+  Rect rect = Rect(0, 0, 0, 0);
+  // the cells rect is in (x, y is the first cell, w, h the number of cells)
+  Rect cell_rect = Rect(0, 0, 0, 0);
+  // set to the query's stamp once the entry has been tested, so an entry in
+  // more than one cell is only tested once.
+  uint32_t query_stamp = 0;
+};
+
+// a uniform grid over a map's world points. An entry is listed in every
+// cell its rect touches, rects outside the map are put in the edge cells.
+// Queries only test the entries in the cells they overlap. cells hold
+// indexes into entries.
+struct SpatialGrid {
+  int rows = 1;
+  int cols = 1;
+  vector<vector<int>> cells = vector<vector<int>>(1);
+  vector<SpatialGridEntry> entries = vector<SpatialGridEntry>();
+  robin_hood::unordered_flat_map<EntityHandle, int, EntityHandleHash>
+      entry_idxs = robin_hood::unordered_flat_map<EntityHandle, int,
+                                                  EntityHandleHash>();
+  uint32_t query_stamp = 0;
+  SpatialGrid();
+  SpatialGrid(int map_rows, int map_cols);
+  void update(EntityHandle handle, const Rect &rect);
+  void erase(EntityHandle handle);
+  bool contains(EntityHandle handle);
+  void query_point(Vec2 p, vector<EntityHandle> &handles);
+  void query_rect(const Rect &rect, vector<EntityHandle> &handles);
+  void query_radius(Vec2 p, int radius, vector<EntityHandle> &handles);
+  void query_circle(Vec2 center, int radius,
+                    vector<EntityHandle> &handles);
+  pair<bool, EntityHandle>
+  get_closest(Vec2 p, function<bool(EntityHandle)> is_match);
+  void query_cells(const Rect &cell_rect, vector<EntityHandle> &handles,
+                   function<bool(const Rect &)> is_hit);
+  Vec2 get_cell(Vec2 p);
+  Rect get_cell_rect(const Rect &rect);
+  int get_cell_idx(int cell_x, int cell_y);
+  void add_to_cells(int entry_idx);
+  void remove_from_cells(int entry_idx);
+  void start_query();
+};
+
+#endif // SPATIAL_GRID_H
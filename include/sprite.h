@@ -3,6 +3,7 @@
 
 #include "engine.h"
 #include "rapidjson/document.h"
+#include "robin_hood.h"
 #include "tween.h"
 #include "utils.h"
 #include <SDL.h>
@@ -30,10 +31,29 @@ struct Sprite {
   void set_is_hidden(bool _is_hidden);
 };
 
-void sprite_serialize(Game &game, Sprite &sprite);
+// the distinct image, anim speed and srcs of a map's tile and layer
+// sprites, there are only a few of them. Maps store them once and each
+// sprite as its dst and an idx into the palette. The palette's sprites are
+// resolved (image and srcs) once when the map is read and copied from
+// there.
+struct SpritePalette {
+  vector<Sprite> sprites = vector<Sprite>();
+  robin_hood::unordered_flat_map<string, int> idxs =
+      robin_hood::unordered_flat_map<string, int>();
+  SpritePalette() = default;
+  int add(Sprite &sprite);
+  int get_idx(Sprite &sprite);
+};
+
+void sprite_serialize(Game &game, Sprite &sprite,
+                      SpritePalette *palette = nullptr);
 void sprite_serialize_into_file(Game &game, Sprite &sprite,
                                 const char *file_path);
 Sprite sprite_deserialize_from_file(Game &game, const char *file_path);
-Sprite sprite_deserialize(Game &game, GenericObject<false, Value> &obj);
+Sprite sprite_deserialize(Game &game, GenericObject<false, Value> &obj,
+                          SpritePalette *palette = nullptr);
+void sprite_palette_serialize(Game &game, SpritePalette &palette);
+SpritePalette sprite_palette_deserialize(Game &game,
+                                         GenericArray<false, Value> &array);
 
 #endif // SPRITE_H
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "rapidjson/document.h"
 #include "sprite.h"
 #include "utils.h"
+#include <string>
 using namespace rapidjson;
 
 struct Game;
@@ -10,6 +11,8 @@ struct Game;
 struct Tile {
   Sprite sprite = Sprite();
   Vec2 warps_to_tile_point = Vec2(0, 0);
+  // empty for warp points within the map
+  string warps_to_map_file_path = "";
   bool is_obstacle = false;
   bool is_warp_point = false;
   void update(Game &game);
@@ -17,9 +20,10 @@ struct Tile {
   void set_to_default_tile(Game &game);
 };
 
-void tile_serialize(Game &game, Tile &tile);
+void tile_serialize(Game &game, Tile &tile, SpritePalette *palette = nullptr);
 void tile_serialize_into_file(Game &game, Tile &tile, const char *file_path);
 Tile tile_deserialize_from_file(Game &game, const char *file_path);
-Tile tile_deserialize(Game &game, GenericObject<false, Value> &unit_obj);
+Tile tile_deserialize(Game &game, GenericObject<false, Value> &unit_obj,
+                      SpritePalette *palette = nullptr);
 
 #endif // TILE_H
@@ -3,6 +3,7 @@
 #include <SDL.h>
 
 #include "constants.h"
+#include "entity_handle.h"
 #include "inventory.h"
 #include "item.h"
 #include "rapidjson/document.h"
@@ -16,6 +17,8 @@ struct Game;
 
 struct TreasureChest {
   boost::uuids::uuid guid;
+  // set when the treasure chest is added to a map, see EntityRegistry.
+  EntityHandle handle;
   TreasureChestName treasure_chest_name = TreasureChestName::None;
   Vec2 tile_point = Vec2(0, 0);
   TweenableSprite sprite;
@@ -28,6 +31,7 @@ struct TreasureChest {
   void update(Game &game);
   void draw(Game &game);
   void set_tile_point(Game &game, Vec2 _tile_point);
+  Rect get_bounding_dst();
 };
 
 void treasure_chest_serialize(Game &game, TreasureChest &treasure_chest);
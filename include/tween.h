@@ -26,33 +26,34 @@ struct TweenCompletion {
 
 struct TweenCallback {
   TweenCallbackType cb_type = TweenCallbackType::None;
-  boost::uuids::uuid unit_guid;
+  EntityHandle unit_handle;
   Vec2 tile_point = Vec2(0, 0);
   bool is_final_point_in_path = false;
-  boost::uuids::uuid item_guid;
+  // the unit still has path waypoints to refine when it gets here.
+  bool is_final_point_in_segment = false;
+  EntityHandle item_handle;
   boost::uuids::uuid panel_guid;
   int idx = 0;
   int handle = 0;
   int damage = 1;
   PerformAbilityContext ability_context = PerformAbilityContext::Default;
-  vector<boost::uuids::uuid> receiving_unit_guids =
-      vector<boost::uuids::uuid>();
+  vector<EntityHandle> receiving_unit_handles = vector<EntityHandle>();
   Vec2 target_dst = Vec2(0, 0);
   AbilityName ability_name;
-  void set_as_unit_move_callback(boost::uuids::uuid _unit_guid,
+  void set_as_unit_move_callback(EntityHandle _unit_handle,
                                  Vec2 _tile_point,
                                  bool _is_final_point_in_path);
-  void set_as_send_item_to_unit_callback(boost::uuids::uuid _unit_guid,
-                                         boost::uuids::uuid _item_guid);
+  void set_as_send_item_to_unit_callback(EntityHandle _unit_handle,
+                                         EntityHandle _item_handle);
   void set_as_item_pickup_display_complete(boost::uuids::uuid _panel_guid);
-  void set_as_battle_text(boost::uuids::uuid _unit_guid, int _handle);
-  void set_as_use_ability(boost::uuids::uuid _acting_unit_guid,
-                          vector<boost::uuids::uuid> _receiving_unit_guids,
+  void set_as_battle_text(EntityHandle _unit_handle, int _handle);
+  void set_as_use_ability(EntityHandle _acting_unit_handle,
+                          vector<EntityHandle> _receiving_unit_handles,
                           int _ability_handle, int _damage, Vec2 _target_dst,
                           PerformAbilityContext _ability_context);
   void
-  set_as_use_ability_timeout(boost::uuids::uuid _acting_unit_guid,
-                             vector<boost::uuids::uuid> _receiving_unit_guids,
+  set_as_use_ability_timeout(EntityHandle _acting_unit_handle,
+                             vector<EntityHandle> _receiving_unit_handles,
                              AbilityName _ability_name, int _damage,
                              Vec2 _target_dst,
                              PerformAbilityContext _ability_context);
@@ -112,7 +113,7 @@ struct TweenXYSpeedMovingTarget {
   DoublePoint double_point;
   bool has_started;
   TweenMovingTargetType moving_target_type = TweenMovingTargetType::None;
-  boost::uuids::uuid moving_target_guid;
+  EntityHandle moving_target_handle;
   std::function<void()> on_start;
   std::function<void()> on_complete;
   TweenXYSpeedMovingTarget();
@@ -122,17 +123,52 @@ struct TweenXYSpeedMovingTarget {
                            TweenInterpType _tween_interp_type,
                            Uint32 current_time, Uint32 _delay, double _speed,
                            TweenMovingTargetType _moving_target_type,
-                           boost::uuids::uuid _moving_target_guid,
+                           EntityHandle _moving_target_handle,
                            TweenCallback _callback,
                            std::function<void()> _on_start,
                            std::function<void()> _on_complete);
   TweenCompletion update(Game &game, Rect &val, Rect &_target_val);
 };
 
+// moves a unit along a path of move grid points at a constant speed. The
+// unit goes in straight lines between the corners (see
+// PathFinder::smooth_path) but still passes every point in cells, and each
+// one gets the same UnitMove on start and on complete callbacks a TweenXY
+// per point would. Callbacks are built when they fire, see Tweens::update.
+struct TweenPath {
+  EntityHandle unit_handle;
+  Rect start_val;
+  vector<Vec2> cells;
+  vector<int> corner_idxs;
+  // distance along the path to each corner
+  vector<double> corner_dists;
+  double speed;
+  Uint32 spawn_time;
+  Uint32 delay;
+  Uint32 current_time_spawn_time_delta;
+  bool has_started;
+  // false if the unit has more path waypoints after the last cell.
+  bool path_ends;
+  int reached_cell_count;
+  int completed_cell_count;
+  TweenPath();
+  // tweens from start_val through cells at speed (pixels per ms) after delay
+  TweenPath(EntityHandle _unit_handle, Rect _start_val,
+            const vector<Vec2> &_cells, const vector<int> &_corner_idxs,
+            Uint32 current_time, Uint32 _delay, double _speed,
+            bool _path_ends);
+  void set_corner_dists();
+  TweenCompletion update(Game &game, Rect &val);
+  TweenCallback get_cell_callback(int cell_idx);
+};
+
 struct Tweens {
   vector<TweenXY> tween_xys;
+  vector<TweenPath> tween_paths;
   vector<TweenXYConstantSpeed> tween_xys_constant_speed;
   vector<TweenXYSpeedMovingTarget> tween_xys_speed_moving_target;
+  // bumped by clear, so update can tell a callback cleared the tweens.
+  uint32_t clear_count = 0;
   void update(Game &game, Rect &val);
   void clear();
   Tweens() = default;
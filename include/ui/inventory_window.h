@@ -26,7 +26,7 @@ struct InventoryWindow {
   InventoryWindow() = default;
   InventoryWindow(Game &game, Vec2 _dst);
   void update(Game &game, Inventory &inventory, DropType _drop_type,
-              boost::uuids::uuid unit_guid);
+              EntityHandle unit_handle);
   void draw(Game &game, Inventory &inventory);
 };
 
@@ -42,14 +42,14 @@ struct ShopWindow {
   MoneyDisplay funds_display = MoneyDisplay();
   MoneyDisplay total_display = MoneyDisplay();
   ButtonText confirm_button;
-  boost::uuids::uuid seller_unit_guid;
+  EntityHandle seller_unit_handle;
   bool is_hidden = true;
   ShopWindow() = default;
   ShopWindow(Game &game);
   void update_always(Game &game, Unit &unit);
   void update_when_open(Game &game, Unit &unit, Unit &seller);
   void draw(Game &game, Unit &unit, Unit &seller);
-  void show_shop(boost::uuids::uuid _seller_unit_guid);
+  void show_shop(EntityHandle _seller_unit_handle);
 };
 
 #endif // UI_SHOPWINDOW_H
\ No newline at end of file
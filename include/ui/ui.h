@@ -31,20 +31,20 @@ struct Game;
 
 struct DropCallback {
   DropType drop_type = DropType::None;
-  boost::uuids::uuid unit_guid;
-  boost::uuids::uuid merchant_guid;
+  EntityHandle unit_handle;
+  EntityHandle merchant_handle;
   Item item = Item();
   Ability ability = Ability();
   int item_idx = 0;
   int ability_idx = 0;
   DropCallback() = default;
-  void set_as_equip_item(Item &_item, boost::uuids::uuid _unit_guid,
+  void set_as_equip_item(Item &_item, EntityHandle _unit_handle,
                          int _item_idx);
-  void set_as_unequip_item(Item &_item, boost::uuids::uuid _unit_guid);
-  void set_as_shop_buy_item(Item &_item, boost::uuids::uuid _merchant_guid);
+  void set_as_unequip_item(Item &_item, EntityHandle _unit_handle);
+  void set_as_shop_buy_item(Item &_item, EntityHandle _merchant_handle);
   void set_as_equip_ability(const Ability &_ability,
-                            boost::uuids::uuid _unit_guid);
-  void set_as_bottom_navbar_ability_swap(boost::uuids::uuid _unit_guid,
+                            EntityHandle _unit_handle);
+  void set_as_bottom_navbar_ability_swap(EntityHandle _unit_handle,
                                          int _ability_idx);
 };
 
@@ -4,6 +4,7 @@
 #include "ai_walk_path.h"
 #include "dialogue.h"
 #include "inventory.h"
+#include "path_request_service.h"
 #include "rapidjson/document.h"
 #include "robin_hood.h"
 #include "sprite.h"
@@ -25,6 +26,8 @@ struct Game;
 
 struct Unit {
   boost::uuids::uuid guid;
+  // set when the unit is added to a map, see EntityRegistry.
+  EntityHandle handle;
   UnitName unit_name = UnitName::None;
   UnitSprite sprite;
   Faction faction;
@@ -42,13 +45,22 @@ struct Unit {
   vector<StatusEffect> status_effects;
   vector<Dialogue> dialogues;
   vector<AIWalkPath> ai_walk_paths;
+  // cluster graph waypoints of a long walk that haven't been refined yet,
+  // the next one is at the back.
+  vector<Vec2> path_waypoints;
   Equipment equipment;
   int num_moves_this_turn = 0;
   int move_indexes_this_turn = 0;
   int ai_walk_path_idx;
+  // the unit's outstanding PathRequestService request, results for any
+  // other ticket are ignored.
+  int path_request_ticket = PATH_REQUEST_NONE;
+  Uint32 path_request_delay = 0;
+  // the battle is waiting on the request's move, see stop_moving
+  bool is_path_request_battle_move = false;
   int dialogue_idx;
   pair<int, int> selected_ability_idx = make_pair(0, 0);
-  boost::uuids::uuid in_dialogue_with_unit_guid;
+  EntityHandle in_dialogue_with_unit_handle;
   boost::uuids::uuid battle_guid;
   bool in_dialogue = false;
   bool is_ai_walking = false;
@@ -57,20 +69,30 @@ struct Unit {
   bool in_battle = false;
   bool is_battle_acting = false;
   bool is_ability_selected = false;
+  bool waypoints_allow_units_to_path_through_each_other = true;
   Unit() = default;
   Unit(Game &game);
   void update(Game &game);
   void draw(Game &game);
   void do_next_ai_walk(Game &game);
   bool show_next_dialogue(Game &game,
-                          boost::uuids::uuid _talking_to_unit_handle);
+                          EntityHandle _talking_to_unit_handle);
   void move_to(Game &game, Vec2 target, Uint32 _delay,
                bool allow_units_to_path_through_each_other);
-  void send_item_to_player(Game &game, boost::uuids::uuid item_guid);
+  void request_move_to(Game &game, Vec2 target, Uint32 _delay,
+                       bool allow_units_to_path_through_each_other);
+  void follow_path_result(Game &game, PathResult &result);
+  void walk_path(Game &game, const vector<Vec2> &path, Vec2 target,
+                 Uint32 _delay);
+  void move_to_next_path_waypoints(Game &game, Uint32 _delay);
+  void show_move_icon(Game &game, Vec2 target);
+  void add_move_tweens(Game &game, const vector<Vec2> &path, Uint32 _delay,
+                       bool path_ends);
+  void send_item_to_player(Game &game, EntityHandle item_handle);
   void stop_moving(Game &game);
   Vec2 get_tile_point();
-  void set_tile_point(Vec2 tile_point);
-  void set_tile_point_move_grid(Vec2 tile_point_move_grid);
+  void set_tile_point(Game &game, Vec2 tile_point);
+  void set_tile_point_move_grid(Game &game, Vec2 tile_point_move_grid);
   void add_battle_text(Game &game, string &_text);
   void add_status_effect(Game &game, const StatusEffect &_status_effect);
   void dec_status_effects(Game &game);
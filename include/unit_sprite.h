@@ -47,6 +47,7 @@ public:
   void update(Game &game);
   void draw(Game &game);
   void draw_at_dst(Game &game, bool _is_camera_rendered, Vec2 _dst_xy);
+  Rect get_tile_point_hit_box();
   void set_current_src(Game &game);
   void set_scaled_screen_dst(Game &game);
   void set_src_from_current_frame(Game &game, vector<SpriteSrc> &srcs,
@@ -13,6 +13,7 @@
 //#include <SDL_opengl.h>
 
 #include "constants.h"
+#include "entity_handle.h"
 
 using namespace std;
 
@@ -136,7 +137,7 @@ struct CharDst {
 };
 
 struct EntityInput {
-  boost::uuids::uuid guid;
+  EntityHandle handle;
   bool is_mouse_over = false;
   bool clicked = false;
   bool right_clicked = false;
@@ -155,17 +156,19 @@ Vec2 tile_point_to_world_point_move_grid(Vec2 idx);
 Vec2 world_point_to_tile_point(Vec2 world_point);
 Vec2 world_point_to_tile_point_move_grid(Vec2 world_point);
 int manhattan_distance(Vec2 v1, Vec2 v2);
+int chebyshev_distance(Vec2 v1, Vec2 v2);
 bool rect_contains_point(const Rect &r, const Vec2 &p);
 bool rect_contains_rect(const Rect &r1, const Rect &r2);
+Rect get_bounding_rect(const Rect &r1, const Rect &r2);
 Vec2 oned_to_twod_idx(int idx, int rows);
 int twod_to_oned_idx(Vec2 tile_point, int rows);
 Vec2 tile_point_to_tile_point_move_grid(Vec2 tile_point);
 Vec2 move_grid_point_to_tile_point(Vec2 move_grid_tile_point);
 void set_world_point_from_tile_point(Vec2 _tile_point, Rect &dst_to_set);
-bool is_player_unit_guid(vector<boost::uuids::uuid> &unit_guids,
-                         boost::uuids::uuid unit_guid);
-bool is_player_controlled_unit_guid(vector<boost::uuids::uuid> &unit_guids,
-                                    boost::uuids::uuid unit_guid);
+bool is_player_unit_handle(vector<EntityHandle> &unit_handles,
+                           EntityHandle unit_handle);
+bool is_player_controlled_unit_handle(vector<EntityHandle> &unit_handles,
+                                      EntityHandle unit_handle);
 int get_current_frame_idx(Uint32 current_time, Uint32 spawn_time, int size,
                           int anim_speed);
 vector<string> string_split(const string &s, char delim);
@@ -175,6 +178,7 @@ Vec2 get_unit_directional_target(Rect &acting_unit_tile_point_hit_box,
                                  Rect &receiving_unit_tile_point_hit_box);
 bool rect_contains_circle(Vec2 circle_center, int radius, Rect &rect);
 Faction get_opposite_faction(Faction faction);
+int get_available_move_size(int action_points, int move_indexes_this_turn);
 int get_path_ap_cost(size_t path_size, int move_indexes_this_turn,
                      int num_moves_this_turn);
 int dist(Vec2 v1, Vec2 v2);
@@ -0,0 +1,156 @@
+#include "asset_archive.h"
+#include "rapidjson/document.h"
+#include <dirent.h>
+#include <fstream>
+#include <iostream>
+#include <string.h>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+using namespace std;
+using namespace rapidjson;
+
+// packs the assets the game loads at startup into one archive, see
+// asset_archive.h. Run by building the assets_archive target, run it
+// again after editing assets.
+// usage: ./asset_packer assets_dir [assets.lpak]
+
+// directories under the assets directory that are packed, with the
+// extensions the game reads from them
+static const char *packed_dirs[] = {
+    "ui",
+    "tiles",
+    "units",
+    "abilities",
+    "buildings",
+    "misc",
+    "items",
+    "treasurechests",
+    "fonts/atlases",
+    "prefabs/items",
+    "prefabs/statuseffects",
+    "prefabs/abilities",
+    "prefabs/units",
+    "prefabs/treasurechests",
+};
+
+static const char *packed_extensions[] = {".png", ".fnt", ".json"};
+
+struct PrefabDir {
+  const char *dir;
+  AssetArchivePrefabKind prefab_kind;
+  // the prefab's name (an enum) in its json
+  const char *name_key;
+};
+
+static const PrefabDir prefab_dirs[] = {
+    {"prefabs/items", AssetArchivePrefabKind::Item, "item_name"},
+    {"prefabs/abilities", AssetArchivePrefabKind::Ability, "ability_name"},
+    {"prefabs/units", AssetArchivePrefabKind::Unit, "unit_name"},
+    {"prefabs/treasurechests", AssetArchivePrefabKind::TreasureChest,
+     "treasure_chest_name"},
+    {"prefabs/statuseffects", AssetArchivePrefabKind::StatusEffect,
+     "status_effect_name"},
+};
+
+static bool has_packed_extension(const string &name) {
+  for (auto ext : packed_extensions) {
+    auto ext_num_bytes = strlen(ext);
+    if (name.size() > ext_num_bytes &&
+        name.compare(name.size() - ext_num_bytes, ext_num_bytes, ext) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool read_file(const string &file_path, vector<char> &bytes) {
+  ifstream file(file_path, ios::binary | ios::ate);
+  if (!file.good()) {
+    return false;
+  }
+  bytes.resize((size_t)file.tellg());
+  file.seekg(0);
+  file.read(bytes.data(), bytes.size());
+  return true;
+}
+
+static void set_prefab_name(AssetArchiveFile &asset_file,
+                            const string &dir) {
+  for (auto &prefab_dir : prefab_dirs) {
+    if (dir != prefab_dir.dir) {
+      continue;
+    }
+    Document doc;
+    doc.Parse(asset_file.bytes.data(), asset_file.bytes.size());
+    if (doc.HasParseError() || !doc.IsObject() ||
+        !doc.HasMember(prefab_dir.name_key) ||
+        !doc[prefab_dir.name_key].IsInt()) {
+      cout << "asset_packer. Prefab without " << prefab_dir.name_key << " "
+           << asset_file.name << "\n";
+      abort();
+    }
+    asset_file.prefab_kind = prefab_dir.prefab_kind;
+    asset_file.prefab_name = doc[prefab_dir.name_key].GetInt();
+  }
+}
+
+// adds every packed file in assets_dir/dir and its subdirectories
+static void add_dir(const string &assets_dir, const string &dir,
+                    const string &packed_dir, vector<AssetArchiveFile> &files) {
+  auto dir_path = assets_dir + "/" + dir;
+  auto d = opendir(dir_path.c_str());
+  if (d == nullptr) {
+    cout << "asset_packer. Directory error " << dir_path << "\n";
+    abort();
+  }
+  while (auto f = readdir(d)) {
+    if (f->d_name[0] == '.') {
+      continue;
+    }
+    auto name = dir + "/" + f->d_name;
+    auto file_path = assets_dir + "/" + name;
+    struct stat file_stat;
+    if (stat(file_path.c_str(), &file_stat) != 0) {
+      continue;
+    }
+    if (S_ISDIR(file_stat.st_mode)) {
+      add_dir(assets_dir, name, packed_dir, files);
+      continue;
+    }
+    if (!has_packed_extension(name)) {
+      continue;
+    }
+    auto asset_file = AssetArchiveFile();
+    asset_file.name = name;
+    if (!read_file(file_path, asset_file.bytes)) {
+      cout << "asset_packer. File error " << file_path << "\n";
+      abort();
+    }
+    set_prefab_name(asset_file, packed_dir);
+    files.push_back(asset_file);
+  }
+  closedir(d);
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2 || argc > 3) {
+    cout << "usage: " << argv[0] << " assets_dir [assets.lpak]\n";
+    return 1;
+  }
+  auto assets_dir = string(argv[1]);
+  auto archive_file_path =
+      argc == 3 ? string(argv[2]) : assets_dir + "/assets.lpak";
+  auto files = vector<AssetArchiveFile>();
+  for (auto dir : packed_dirs) {
+    add_dir(assets_dir, dir, dir, files);
+  }
+  size_t num_bytes = 0;
+  for (auto &asset_file : files) {
+    num_bytes += asset_file.bytes.size();
+  }
+  asset_archive_write(files, archive_file_path.c_str());
+  cout << files.size() << " files (" << num_bytes << " bytes) -> "
+       << archive_file_path << "\n";
+  return 0;
+}
@@ -0,0 +1,156 @@
+#include "asset_archive.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <string.h>
+#include <sys/stat.h>
+
+bool AssetArchive::open(const char *file_path) {
+  entries.clear();
+  names = nullptr;
+  if (!is_little_endian_host() || !file.open(file_path)) {
+    return false;
+  }
+  if (file.num_bytes < sizeof(AssetArchiveHeader)) {
+    file.close();
+    return false;
+  }
+  memcpy(&header, file.data, sizeof(AssetArchiveHeader));
+  auto names_offset = sizeof(AssetArchiveHeader) +
+                      (size_t)header.num_entries * sizeof(AssetArchiveEntry);
+  if (memcmp(header.magic, ASSET_ARCHIVE_MAGIC, 4) != 0 ||
+      header.version != ASSET_ARCHIVE_VERSION ||
+      names_offset + header.names_num_bytes > file.num_bytes) {
+    cout << "AssetArchive::open. Not a version " << ASSET_ARCHIVE_VERSION
+         << " asset archive " << file_path << "\n";
+    file.close();
+    return false;
+  }
+  entries.resize(header.num_entries);
+  memcpy(entries.data(), file.data + sizeof(AssetArchiveHeader),
+         header.num_entries * sizeof(AssetArchiveEntry));
+  names = file.data + names_offset;
+  struct stat file_stat;
+  if (stat(file_path, &file_stat) == 0) {
+    modified_time = file_stat.st_mtime;
+  }
+  for (auto &entry : entries) {
+    if (entry.name_offset >= header.names_num_bytes ||
+        entry.offset + entry.num_bytes > file.num_bytes) {
+      cout << "AssetArchive::open. Entry out of range " << file_path << "\n";
+      entries.clear();
+      file.close();
+      return false;
+    }
+  }
+  return true;
+}
+
+bool AssetArchive::is_open() { return file.data != nullptr; }
+
+// file_path is the path the game loads the asset from, the entries are
+// sorted by name so it's a binary search.
+AssetBlob AssetArchive::find(const char *file_path) {
+  if (!is_open()) {
+    return AssetBlob();
+  }
+  auto name = get_asset_archive_name(file_path);
+  auto it = lower_bound(entries.begin(), entries.end(), name,
+                        [&](const AssetArchiveEntry &entry, const string &n) {
+                          return strcmp(get_name(entry), n.c_str()) < 0;
+                        });
+  if (it == entries.end() || name != get_name(*it)) {
+    return AssetBlob();
+  }
+  return get_blob(*it);
+}
+
+AssetBlob AssetArchive::get_blob(const AssetArchiveEntry &entry) {
+  auto blob = AssetBlob();
+  blob.data = file.data + entry.offset;
+  blob.num_bytes = entry.num_bytes;
+  return blob;
+}
+
+const char *AssetArchive::get_name(const AssetArchiveEntry &entry) {
+  return names + entry.name_offset;
+}
+
+// the editor saves prefabs to their loose files, those are read instead of
+// the archive until it is packed again.
+bool AssetArchive::is_loose_file_newer(const AssetArchiveEntry &entry) {
+  auto file_path = string(ASSET_ARCHIVE_ASSETS_DIR) + get_name(entry);
+  struct stat file_stat;
+  return stat(file_path.c_str(), &file_stat) == 0 &&
+         file_stat.st_mtime > modified_time;
+}
+
+// "../assets/ui/ui.png" -> "ui/ui.png"
+string get_asset_archive_name(const char *file_path) {
+  auto prefix_num_bytes = strlen(ASSET_ARCHIVE_ASSETS_DIR);
+  if (strncmp(file_path, ASSET_ARCHIVE_ASSETS_DIR, prefix_num_bytes) == 0) {
+    return string(file_path + prefix_num_bytes);
+  }
+  return string(file_path);
+}
+
+static void pad_to_alignment(vector<char> &bytes) {
+  while (bytes.size() % ASSET_ARCHIVE_ALIGNMENT != 0) {
+    bytes.push_back('\0');
+  }
+}
+
+void asset_archive_write(vector<AssetArchiveFile> &files,
+                         const char *file_path) {
+  if (!is_little_endian_host()) {
+    cout << "asset_archive_write. Only little endian hosts can write asset "
+            "archives.\n";
+    abort();
+  }
+  sort(files.begin(), files.end(),
+       [](const AssetArchiveFile &a, const AssetArchiveFile &b) {
+         return strcmp(a.name.c_str(), b.name.c_str()) < 0;
+       });
+  auto names = vector<char>();
+  auto entries = vector<AssetArchiveEntry>();
+  for (auto &asset_file : files) {
+    auto entry = AssetArchiveEntry();
+    entry.name_offset = names.size();
+    entry.prefab_kind = (int32_t)asset_file.prefab_kind;
+    entry.prefab_name = asset_file.prefab_name;
+    entry.reserved = 0;
+    entry.num_bytes = asset_file.bytes.size();
+    names.insert(names.end(), asset_file.name.begin(), asset_file.name.end());
+    names.push_back('\0');
+    entries.push_back(entry);
+  }
+  pad_to_alignment(names);
+  auto header = AssetArchiveHeader();
+  memcpy(header.magic, ASSET_ARCHIVE_MAGIC, 4);
+  header.version = ASSET_ARCHIVE_VERSION;
+  header.num_entries = entries.size();
+  header.names_num_bytes = names.size();
+
+  auto blobs_offset = sizeof(AssetArchiveHeader) +
+                      entries.size() * sizeof(AssetArchiveEntry) +
+                      names.size();
+  auto blobs = vector<char>();
+  // the toc and names are a multiple of 16 bytes so blobs_offset is too
+  for (size_t i = 0; i < files.size(); i++) {
+    pad_to_alignment(blobs);
+    entries[i].offset = blobs_offset + blobs.size();
+    blobs.insert(blobs.end(), files[i].bytes.begin(), files[i].bytes.end());
+  }
+
+  ofstream file(file_path, ios::binary);
+  if (!file.good()) {
+    cout << "asset_archive_write. File error " << file_path << "\n";
+    abort();
+  }
+  file.write((const char *)&header, sizeof(AssetArchiveHeader));
+  file.write((const char *)entries.data(),
+             entries.size() * sizeof(AssetArchiveEntry));
+  file.write(names.data(), names.size());
+  file.write(blobs.data(), blobs.size());
+  file.close();
+}
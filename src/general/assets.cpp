@@ -1,16 +1,37 @@
 #include "assets.h"
+#include "game.h"
 // linux only - couldn't get <filesystem> to compile
 // need to change this as soon as possible as all users
 // use this, it is not just for the editor.
 #include <dirent.h>
+#include <fstream>
+#include <sstream>
 #include <unordered_map>
 using namespace std;
 
-void Assets::start(Game &game) { update_all_assets_from_files(game); }
+// with an asset archive the prefabs are only indexed here and each is
+// decoded the first time it is asked for. The editor's reloads read the
+// loose files it edits.
+void Assets::start(Game &game) {
+  this->game = &game;
+  if (game.engine.asset_archive.is_open()) {
+    index_archive(game);
+  } else {
+    update_all_assets_from_files(game);
+  }
+}
 
 const Item &Assets::get_item(ItemName item_name) {
   auto idx = static_cast<int>(item_name);
   GAME_ASSERT(idx >= 0 && idx <= ITEM_NAME_LAST - 1);
+  if (!item_prefabs[idx].is_loaded) {
+    Document doc;
+    if (load_prefab(item_prefabs[idx], doc)) {
+      auto obj = doc.GetObject();
+      items[idx] = item_deserialize(*game, obj, false);
+      items[idx].guid = game->engine.get_guid();
+    }
+  }
   GAME_ASSERT(item_name == items[idx].item_name);
   return items[idx];
 }
@@ -18,6 +39,14 @@ const Item &Assets::get_item(ItemName item_name) {
 const Ability &Assets::get_ability(AbilityName ability_name) {
   auto idx = static_cast<int>(ability_name);
   GAME_ASSERT(idx >= 0 && idx <= ABILITY_NAME_LAST - 1);
+  if (!ability_prefabs[idx].is_loaded) {
+    Document doc;
+    if (load_prefab(ability_prefabs[idx], doc)) {
+      auto obj = doc.GetObject();
+      abilities[idx] = ability_deserialize(*game, obj, false);
+      abilities[idx].guid = game->engine.get_guid();
+    }
+  }
   GAME_ASSERT(ability_name == abilities[idx].ability_name);
   return abilities[idx];
 }
@@ -25,6 +54,14 @@ const Ability &Assets::get_ability(AbilityName ability_name) {
 const Unit &Assets::get_unit(UnitName unit_name) {
   auto idx = static_cast<int>(unit_name);
   GAME_ASSERT(idx >= 0 && idx <= UNIT_NAME_LAST - 1);
+  if (!unit_prefabs[idx].is_loaded) {
+    Document doc;
+    if (load_prefab(unit_prefabs[idx], doc)) {
+      auto obj = doc.GetObject();
+      units[idx] = unit_deserialize(*game, obj, false);
+      units[idx].guid = game->engine.get_guid();
+    }
+  }
   GAME_ASSERT(unit_name == units[idx].unit_name);
   return units[idx];
 }
@@ -33,10 +70,98 @@ const StatusEffect &
 Assets::get_status_effect(StatusEffectName status_effect_name) {
   auto idx = static_cast<int>(status_effect_name);
   GAME_ASSERT(idx >= 0 && idx <= STATUS_EFFECT_NAME_LAST - 1);
+  if (!status_effect_prefabs[idx].is_loaded) {
+    Document doc;
+    if (load_prefab(status_effect_prefabs[idx], doc)) {
+      auto obj = doc.GetObject();
+      status_effects[idx] = status_effect_deserialize(*game, obj, false);
+    }
+  }
   GAME_ASSERT(status_effect_name == status_effects[idx].status_effect_name);
   return status_effects[idx];
 }
 
+// parses the prefab into its own doc (game.serializer.doc may be in use by
+// whatever asked for the asset). False when the archive doesn't have it,
+// the asset stays default like a missing file. A loose file the editor
+// saved after the archive was packed is read instead.
+bool Assets::load_prefab(AssetPrefab &prefab, Document &doc) {
+  prefab.is_loaded = true;
+  if (prefab.entry_idx == -1) {
+    return false;
+  }
+  auto &archive = game->engine.asset_archive;
+  auto &entry = archive.entries[prefab.entry_idx];
+  if (archive.is_loose_file_newer(entry)) {
+    auto file_path =
+        string(ASSET_ARCHIVE_ASSETS_DIR) + archive.get_name(entry);
+    ifstream file(file_path);
+    stringstream buffer;
+    buffer << file.rdbuf();
+    doc.Parse(buffer.str().c_str());
+  } else {
+    auto blob = archive.get_blob(entry);
+    doc.Parse(blob.data, blob.num_bytes);
+  }
+  if (doc.HasParseError() || !doc.IsObject()) {
+    cout << "Assets::load_prefab. Parse error " << archive.get_name(entry)
+         << "\n";
+    abort();
+  }
+  return true;
+}
+
+template <size_t N>
+static void set_prefab_entry_idx(array<AssetPrefab, N> &prefabs,
+                                 int prefab_name, int entry_idx) {
+  if (prefab_name < 0 || prefab_name >= (int)N) {
+    cout << "Assets::index_archive. Prefab name out of range " << prefab_name
+         << "\n";
+    abort();
+  }
+  prefabs[prefab_name].entry_idx = entry_idx;
+}
+
+void Assets::index_archive(Game &game) {
+  set_prefabs_loaded(false);
+  auto &archive = game.engine.asset_archive;
+  for (int i = 0; i < (int)archive.entries.size(); i++) {
+    auto &entry = archive.entries[i];
+    switch ((AssetArchivePrefabKind)entry.prefab_kind) {
+    case AssetArchivePrefabKind::Item:
+      set_prefab_entry_idx(item_prefabs, entry.prefab_name, i);
+      break;
+    case AssetArchivePrefabKind::Ability:
+      set_prefab_entry_idx(ability_prefabs, entry.prefab_name, i);
+      break;
+    case AssetArchivePrefabKind::Unit:
+      set_prefab_entry_idx(unit_prefabs, entry.prefab_name, i);
+      break;
+    case AssetArchivePrefabKind::StatusEffect:
+      set_prefab_entry_idx(status_effect_prefabs, entry.prefab_name, i);
+      break;
+    // nothing asks for treasure chests by name, the editor reads them from
+    // their loose files
+    default:
+      break;
+    }
+  }
+  check_if_all_prefabs_exist(item_prefabs, "items");
+  check_if_all_prefabs_exist(ability_prefabs, "abilities");
+  check_if_all_prefabs_exist(unit_prefabs, "units");
+  check_if_all_prefabs_exist(status_effect_prefabs, "status effects");
+}
+
+// the prefabs are all loaded after update_all_assets_from_files.
+void Assets::set_prefabs_loaded(bool is_loaded) {
+  auto prefab = AssetPrefab();
+  prefab.is_loaded = is_loaded;
+  item_prefabs.fill(prefab);
+  ability_prefabs.fill(prefab);
+  unit_prefabs.fill(prefab);
+  status_effect_prefabs.fill(prefab);
+}
+
 void Assets::reserialize_all_assets(Game &game) {
   for (auto &entry : item_dict) {
     item_serialize_into_file(game, entry.second, entry.first.c_str());
@@ -70,6 +195,7 @@ void Assets::update_all_assets_from_files(Game &game) {
   unit_dict.clear();
   treasure_chest_dict.clear();
   status_effect_dict.clear();
+  set_prefabs_loaded(true);
   if (auto dir = opendir("../assets/prefabs/items")) {
     while (auto f = readdir(dir)) {
       if (!f->d_name || f->d_name[0] == '.') {
@@ -4,27 +4,37 @@
 #include "utils_game.h"
 #include <algorithm>
 
-void BattleAction::set_as_unit_move(boost::uuids::uuid _acting_unit_guid,
+void BattleAction::set_as_unit_move(EntityHandle _acting_unit_handle,
                                     Vec2 _tile_point) {
   action_type = BattleActionType::Move;
-  acting_unit_guid = _acting_unit_guid;
+  acting_unit_handle = _acting_unit_handle;
   tile_point = _tile_point;
 }
 
+void BattleAction::set_as_unit_move_along_path(
+    EntityHandle _acting_unit_handle, Vec2 _tile_point,
+    const vector<Vec2> &_path) {
+  action_type = BattleActionType::Move;
+  acting_unit_handle = _acting_unit_handle;
+  tile_point = _tile_point;
+  has_path = true;
+  path = _path;
+}
+
 void BattleAction::set_as_use_ability(
-    boost::uuids::uuid _acting_unit_guid,
-    vector<boost::uuids::uuid> _receiving_unit_guids, const Ability &_ability,
+    EntityHandle _acting_unit_handle,
+    vector<EntityHandle> _receiving_unit_handles, const Ability &_ability,
     Vec2 _ability_target_dst) {
   action_type = BattleActionType::UseAbility;
-  acting_unit_guid = _acting_unit_guid;
-  receiving_unit_guids = _receiving_unit_guids;
+  acting_unit_handle = _acting_unit_handle;
+  receiving_unit_handles = _receiving_unit_handles;
   ability = _ability;
   ability_target_dst = _ability_target_dst;
 }
 
-void BattleAction::set_as_end_turn(boost::uuids::uuid _acting_unit_guid) {
+void BattleAction::set_as_end_turn(EntityHandle _acting_unit_handle) {
   action_type = BattleActionType::EndTurn;
-  acting_unit_guid = _acting_unit_guid;
+  acting_unit_handle = _acting_unit_handle;
 }
 
 Battle::Battle(Game &game) { guid = game.engine.get_guid(); }
@@ -47,19 +57,20 @@ void Battle::update(Game &game) {
 
 // assumes units have been added in already
 void Battle::start(Game &game) {
-  GAME_ASSERT(unit_guids.size() > 0);
+  GAME_ASSERT(unit_handles.size() > 0);
   // shuffle units for random turn order
-  shuffle(unit_guids.begin(), unit_guids.end(), game.engine.rnd);
-  acting_unit_guid = unit_guids.at(0);
-  auto &acting_unit = game.map.unit_dict[acting_unit_guid];
-  if (!game.map.is_guid_in_all_player_units(acting_unit.guid)) {
+  shuffle(unit_handles.begin(), unit_handles.end(), game.engine.rnd);
+  acting_unit_handle = unit_handles.at(0);
+  auto &acting_unit = game.map.unit_dict[acting_unit_handle];
+  set_move_range_field(game, acting_unit);
+  if (!game.map.is_handle_in_all_player_units(acting_unit.handle)) {
     enqueue_ai_actions(game);
   }
 }
 
 void Battle::end_turn(Game &game) {
   // dec acting unit's status effects
-  auto &acting_unit = game.map.unit_dict[acting_unit_guid];
+  auto &acting_unit = game.map.unit_dict[acting_unit_handle];
   acting_unit.dec_status_effects(game);
   // dec all charge abilities once after turn ended
   dec_charging_actions(game);
@@ -71,11 +82,11 @@ void Battle::end_turn(Game &game) {
 void Battle::perform_next_battle_action(Game &game) {
   current_context = PerformAbilityContext::Default;
   if (action_queue.size() == 0) {
-    GAME_ASSERT(game.map.unit_dict.contains(acting_unit_guid));
-    auto &acting_unit = game.map.unit_dict[acting_unit_guid];
+    GAME_ASSERT(game.map.unit_dict.contains(acting_unit_handle));
+    auto &acting_unit = game.map.unit_dict[acting_unit_handle];
     // player unit is out of ap, end turn
     if (acting_unit.stats.action_points.current_equals_lower_bound() &&
-        game.map.is_guid_in_all_player_units(acting_unit.guid)) {
+        game.map.is_handle_in_all_player_units(acting_unit.handle)) {
       end_turn(game);
     }
     return;
@@ -137,9 +148,9 @@ void Battle::advance_turn(Game &game) {
   }
 
   size_t acting_unit_idx = 0;
-  for (size_t i = 0; i < unit_guids.size(); i++) {
-    auto unit_guid = unit_guids[i];
-    if (unit_guid == acting_unit_guid) {
+  for (size_t i = 0; i < unit_handles.size(); i++) {
+    auto unit_handle = unit_handles[i];
+    if (unit_handle == acting_unit_handle) {
       acting_unit_idx = i;
       break;
     }
@@ -153,11 +164,11 @@ void Battle::advance_turn(Game &game) {
       abort();
     }
     acting_unit_idx += 1;
-    if (acting_unit_idx > unit_guids.size() - 1) {
+    if (acting_unit_idx > unit_handles.size() - 1) {
       acting_unit_idx = 0;
     }
-    acting_unit_guid = unit_guids.at(acting_unit_idx);
-    auto &unit = game.map.unit_dict[acting_unit_guid];
+    acting_unit_handle = unit_handles.at(acting_unit_idx);
+    auto &unit = game.map.unit_dict[acting_unit_handle];
     // this acting_unit would be dead, keep searching
     if (unit.stats.hp.current_equals_lower_bound()) {
       continue;
@@ -166,19 +177,84 @@ void Battle::advance_turn(Game &game) {
     }
   }
 
-  auto &acting_unit = game.map.unit_dict[acting_unit_guid];
+  evict_flow_fields(game);
+  auto &acting_unit = game.map.unit_dict[acting_unit_handle];
   // restore ap
   acting_unit.stats.action_points.current = acting_unit.stats.action_points.max;
+  set_move_range_field(game, acting_unit);
   // if enemy or non player ally do ai actions
   if (acting_unit.faction == Faction::Enemy ||
-      !game.map.is_guid_in_all_player_units(acting_unit_guid)) {
+      !game.map.is_handle_in_all_player_units(acting_unit_handle)) {
     enqueue_ai_actions(game);
   }
 }
 
+// called when a turn starts and when the acting unit stops moving.
+void Battle::set_move_range_field(Game &game, Unit &acting_unit) {
+  move_range_field.set(
+      game.map.move_grid, game.map.occupancy_grid, acting_unit.handle,
+      acting_unit.sprite.get_tile_point_hit_box(),
+      acting_unit.sprite.tile_point_hit_box.get_xy(),
+      get_available_move_size(acting_unit.stats.action_points.current,
+                              acting_unit.move_indexes_this_turn));
+}
+
+// the field is rebuilt here if the unit was put somewhere else without
+// walking (a warp or a loaded save), its action points changed, the map
+// changed or a unit moved within its reach since it was built. units
+// walking elsewhere on the map don't rebuild it.
+MoveRangeField &Battle::get_move_range_field(Game &game, Unit &acting_unit) {
+  if (move_range_field.is_stale(
+          game.map.move_grid, game.map.occupancy_grid, acting_unit.handle,
+          acting_unit.sprite.tile_point_hit_box.get_xy(),
+          get_available_move_size(acting_unit.stats.action_points.current,
+                                  acting_unit.move_indexes_this_turn))) {
+    set_move_range_field(game, acting_unit);
+  }
+  return move_range_field;
+}
+
+// fields are rebuilt when the target has moved or the move grid changed
+// since they were built.
+FlowField &Battle::get_flow_field(Game &game, Unit &target_unit,
+                                  Vec2 hit_box_dims) {
+  auto target = target_unit.sprite.tile_point_hit_box.get_xy();
+  for (auto &flow_field : flow_fields) {
+    if (flow_field.target_unit_handle == target_unit.handle &&
+        flow_field.hit_box_dims == hit_box_dims) {
+      if (flow_field.is_stale(game.map.move_grid, target)) {
+        flow_field.set(game.map.move_grid, target_unit.handle, target,
+                       hit_box_dims);
+      }
+      return flow_field;
+    }
+  }
+  flow_fields.push_back(FlowField());
+  auto &flow_field = flow_fields.back();
+  flow_field.set(game.map.move_grid, target_unit.handle, target,
+                 hit_box_dims);
+  return flow_field;
+}
+
+// dead units and units that are no longer in the battle are never
+// targeted again.
+void Battle::evict_flow_fields(Game &game) {
+  for (int i = flow_fields.size() - 1; i >= 0; i--) {
+    auto unit_handle = flow_fields[i].target_unit_handle;
+    if (game.map.unit_dict.contains(unit_handle) &&
+        has_unit_handle(unit_handle)) {
+      auto &unit = game.map.unit_dict[unit_handle];
+      if (!unit.stats.hp.current_equals_lower_bound()) {
+        continue;
+      }
+    }
+    flow_fields.erase(flow_fields.begin() + i);
+  }
+}
+
 bool Battle::all_faction_units_dead(Game &game, Faction faction) {
-  for (auto unit_guid : unit_guids) {
-    auto &unit = game.map.unit_dict[unit_guid];
+  for (auto unit_handle : unit_handles) {
+    auto &unit = game.map.unit_dict[unit_handle];
     if (unit.faction == faction &&
         !unit.stats.hp.current_equals_lower_bound()) {
       return false;
@@ -195,8 +271,8 @@ bool Battle::is_battle_over(Game &game) {
 void Battle::end_battle(Game &game) {
   // set all units to not in battle, including enemies. Dead enemies
   // can't trigger battles so its fine.
-  for (auto unit_guid : unit_guids) {
-    auto &unit = game.map.unit_dict[unit_guid];
+  for (auto unit_handle : unit_handles) {
+    auto &unit = game.map.unit_dict[unit_handle];
     unit.in_battle = false;
     // restore ap and hp
     unit.stats.action_points.set_current_to_max();
@@ -227,16 +303,26 @@ void Battle::add_battle_action(Game &game, BattleAction &battle_action) {
 void Battle::perform_battle_action(Game &game, BattleAction &battle_action,
                                    PerformAbilityContext _ability_context) {
   if (battle_action.action_type == BattleActionType::Move) {
-    GAME_ASSERT(game.map.unit_dict.contains(battle_action.acting_unit_guid));
-    auto &acting_unit = game.map.unit_dict[battle_action.acting_unit_guid];
-    acting_unit.move_to(game, battle_action.tile_point, 0, false);
+    GAME_ASSERT(game.map.unit_dict.contains(battle_action.acting_unit_handle));
+    auto &acting_unit = game.map.unit_dict[battle_action.acting_unit_handle];
+    // the player's moves follow the path they were shown right away, ai
+    // moves can wait a frame for the path request service.
+    if (battle_action.has_path) {
+      acting_unit.stop_moving(game);
+      acting_unit.walk_path(game, battle_action.path, battle_action.tile_point,
+                            0);
+    } else if (game.map.is_handle_in_all_player_units(acting_unit.handle)) {
+      acting_unit.move_to(game, battle_action.tile_point, 0, false);
+    } else {
+      acting_unit.request_move_to(game, battle_action.tile_point, 0, false);
+    }
   } else if (battle_action.action_type == BattleActionType::UseAbility) {
-    GAME_ASSERT(game.map.unit_dict.contains(battle_action.acting_unit_guid));
-    auto &acting_unit = game.map.unit_dict[battle_action.acting_unit_guid];
+    GAME_ASSERT(game.map.unit_dict.contains(battle_action.acting_unit_handle));
+    auto &acting_unit = game.map.unit_dict[battle_action.acting_unit_handle];
     acting_unit.is_battle_acting = true;
     game.map.start_ability_timeout(
-        game, battle_action.acting_unit_guid,
-        battle_action.receiving_unit_guids, battle_action.ability,
+        game, battle_action.acting_unit_handle,
+        battle_action.receiving_unit_handles, battle_action.ability,
         battle_action.ability_target_dst, _ability_context);
   } else if (battle_action.action_type == BattleActionType::EndTurn) {
     end_turn(game);
@@ -254,12 +340,12 @@ void Battle::clear_action_queue() {
 }
 
 void Battle::enqueue_ai_actions(Game &game) {
-  GAME_ASSERT(game.map.unit_dict.contains(acting_unit_guid));
-  auto &acting_unit = game.map.unit_dict[acting_unit_guid];
+  GAME_ASSERT(game.map.unit_dict.contains(acting_unit_handle));
+  auto &acting_unit = game.map.unit_dict[acting_unit_handle];
 
   auto start = acting_unit.sprite.tile_point_hit_box.get_xy();
   auto closest_unit = get_closest_faction_unit(
-      game, acting_unit_guid, get_opposite_faction(acting_unit.faction));
+      game, acting_unit_handle, get_opposite_faction(acting_unit.faction));
   auto target = Vec2(0, 0);
   if (closest_unit.first) {
     auto &closest_u = game.map.unit_dict[closest_unit.second];
@@ -267,14 +353,35 @@ void Battle::enqueue_ai_actions(Game &game) {
   }
 
   auto ap_remaining = acting_unit.stats.action_points.current;
-  auto move_ap_cost_pair =
-      game.map.get_ap_of_move(game, acting_unit, start, target);
-  auto move_ap_cost = move_ap_cost_pair.first;
-  target = move_ap_cost_pair.second;
-  ap_remaining -= move_ap_cost;
-
   auto move_action = BattleAction();
-  move_action.set_as_unit_move(acting_unit.guid, target);
+  if (closest_unit.first) {
+    // ai units usually go for the same unit, they share its flow field.
+    auto &closest_u = game.map.unit_dict[closest_unit.second];
+    auto hit_box = acting_unit.sprite.get_tile_point_hit_box();
+    auto &flow_field =
+        get_flow_field(game, closest_u, Vec2(hit_box.w, hit_box.h));
+    flow_field.set_path(
+        game.map.occupancy_grid, hit_box,
+        get_available_move_size(acting_unit.stats.action_points.current,
+                                acting_unit.move_indexes_this_turn),
+        ai_move_path);
+    ap_remaining -= get_path_ap_cost(ai_move_path.size(),
+                                     acting_unit.move_indexes_this_turn,
+                                     acting_unit.num_moves_this_turn);
+    if (ai_move_path.size() > 0) {
+      target = ai_move_path[ai_move_path.size() - 1];
+    } else {
+      target = start;
+    }
+    move_action.set_as_unit_move_along_path(acting_unit.handle, target,
+                                            ai_move_path);
+  } else {
+    auto move_ap_cost_pair =
+        game.map.get_ap_of_move(game, acting_unit, start, target);
+    target = move_ap_cost_pair.second;
+    ap_remaining -= move_ap_cost_pair.first;
+    move_action.set_as_unit_move(acting_unit.handle, target);
+  }
   add_battle_action(game, move_action);
 
   if (closest_unit.first) {
@@ -283,12 +390,12 @@ void Battle::enqueue_ai_actions(Game &game) {
     auto rnd_int = game.engine.get_random_int(0, 100);
     if (rnd_int < 25) {
       ability_action.set_as_use_ability(
-          acting_unit.guid, vector<boost::uuids::uuid>{closest_unit.second},
+          acting_unit.handle, vector<EntityHandle>{closest_unit.second},
           game.assets.get_ability(AbilityName::Fire),
           closest_u.sprite.dst.get_xy());
     } else {
       ability_action.set_as_use_ability(
-          acting_unit.guid, vector<boost::uuids::uuid>{closest_unit.second},
+          acting_unit.handle, vector<EntityHandle>{closest_unit.second},
           get_default_attack_ability(game, acting_unit),
           closest_u.sprite.dst.get_xy());
     }
@@ -296,61 +403,55 @@ void Battle::enqueue_ai_actions(Game &game) {
   }
 
   auto end_turn_action = BattleAction();
-  end_turn_action.set_as_end_turn(acting_unit_guid);
+  end_turn_action.set_as_end_turn(acting_unit_handle);
   add_battle_action(game, end_turn_action);
 
   perform_next_battle_action(game);
 }
 
-pair<bool, boost::uuids::uuid>
+// closest by world distance between the units' dsts.
+pair<bool, EntityHandle>
 Battle::get_closest_faction_unit(Game &game,
-                                 boost::uuids::uuid _acting_unit_guid,
+                                 EntityHandle _acting_unit_handle,
                                  Faction faction_to_search_for) {
-  GAME_ASSERT(game.map.unit_dict.contains(_acting_unit_guid));
-  auto &acting_unit = game.map.unit_dict[_acting_unit_guid];
-  auto min_unit_found = false;
-  boost::uuids::uuid min_unit_guid;
-  auto min_dist = 1000000;
-  for (auto &unit_guid : unit_guids) {
-    if (unit_guid == _acting_unit_guid) {
-      continue;
-    }
-    auto &unit = game.map.unit_dict[unit_guid];
-    if (unit.faction == faction_to_search_for) {
-      auto dist =
-          manhattan_distance(acting_unit.sprite.tile_point_hit_box.get_xy(),
-                             unit.sprite.tile_point_hit_box.get_xy());
-      if (dist < min_dist) {
-        min_unit_found = true;
-        dist = min_dist;
-        min_unit_guid = unit.guid;
-      }
-    }
-  }
-  return make_pair(min_unit_found, min_unit_guid);
+  GAME_ASSERT(game.map.unit_dict.contains(_acting_unit_handle));
+  auto &acting_unit = game.map.unit_dict[_acting_unit_handle];
+  return game.map.unit_grid.get_closest(
+      acting_unit.sprite.dst.get_xy(), [&](EntityHandle unit_handle) {
+        if (unit_handle == _acting_unit_handle ||
+            !has_unit_handle(unit_handle)) {
+          return false;
+        }
+        return game.map.unit_dict[unit_handle].faction == faction_to_search_for;
+      });
 }
 
-vector<boost::uuids::uuid>
-Battle::get_receiving_unit_guids(Game &game, Ability &ability,
-                                 AbilityTarget &ability_target) {
+vector<EntityHandle>
+Battle::get_receiving_unit_handles(Game &game, Ability &ability,
+                                   AbilityTarget &ability_target) {
   if (ability.stats.aoe.current != 1) {
     return get_units_in_aoe(game, ability_target);
   } else if (game.map.unit_input.is_mouse_over) {
-    auto &receiving_unit = game.map.unit_dict[game.map.unit_input.guid];
-    return vector<boost::uuids::uuid>{receiving_unit.guid};
+    auto &receiving_unit = game.map.unit_dict[game.map.unit_input.handle];
+    return vector<EntityHandle>{receiving_unit.handle};
   }
 }
 
-vector<boost::uuids::uuid>
+vector<EntityHandle>
 Battle::get_units_in_aoe(Game &game, AbilityTarget &ability_target) {
-  auto receiving_units = vector<boost::uuids::uuid>();
-  for (auto unit_guid : unit_guids) {
-    auto &unit = game.map.unit_dict[unit_guid];
-    if (rect_contains_circle(ability_target.sprite.dst.get_center(),
-                             ability_target.sprite.dst.w / 2,
-                             unit.sprite.dst)) {
-      receiving_units.push_back(unit_guid);
+  auto receiving_units = vector<EntityHandle>();
+  game.map.unit_grid.query_circle(ability_target.sprite.dst.get_center(),
+                                  ability_target.sprite.dst.w / 2,
+                                  game.map.nearby_handles);
+  for (auto unit_handle : game.map.nearby_handles) {
+    if (has_unit_handle(unit_handle)) {
+      receiving_units.push_back(unit_handle);
     }
   }
   return receiving_units;
+}
+
+bool Battle::has_unit_handle(EntityHandle unit_handle) {
+  return find(unit_handles.begin(), unit_handles.end(), unit_handle) !=
+         unit_handles.end();
 }
\ No newline at end of file
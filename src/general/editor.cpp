@@ -166,9 +166,12 @@ void Editor::update(Game &game) {
     auto &tile_warp_point_to_map_sprite = tile_warp_point_to_map_sprites[i];
     auto &tile_warp_point_sprite = tile_warp_point_sprites[i];
     tile_obstacle_sprite.is_hidden = !game.map.tiles[i].is_obstacle;
-    // always hidden until these are used again
-    tile_warp_point_to_map_sprite.is_hidden = true;
-    tile_warp_point_sprite.is_hidden = !game.map.tiles[i].is_warp_point;
+    auto &tile = game.map.tiles[i];
+    auto is_warp_point_to_map =
+        tile.is_warp_point && tile.warps_to_map_file_path.size() > 0;
+    tile_warp_point_to_map_sprite.is_hidden = !is_warp_point_to_map;
+    tile_warp_point_sprite.is_hidden =
+        !tile.is_warp_point || is_warp_point_to_map;
     tile_obstacle_sprite.update(game);
     tile_warp_point_to_map_sprite.update(game);
     tile_warp_point_sprite.update(game);
@@ -273,8 +276,8 @@ void Editor::handle_input_events(Game &game) {
       auto tile_point = world_point_to_tile_point_move_grid(
           Vec2(game.engine.mouse_point_game_rect_scaled_camera));
       auto unit = unit_deserialize_from_file(game, prefab_file_path.c_str());
-      unit.set_tile_point_move_grid(tile_point);
-      game.map.unit_dict[unit.guid] = unit;
+      unit.set_tile_point_move_grid(game, tile_point);
+      game.map.add_unit(game, unit);
     } else if (game.engine.is_right_mouse_down) {
       editor_spawn_mode = EditorSpawnMode::None;
     }
@@ -285,7 +288,7 @@ void Editor::handle_input_events(Game &game) {
       auto treasure_chest =
           treasure_chest_deserialize_from_file(game, prefab_file_path.c_str());
       treasure_chest.set_tile_point(game, tile_point);
-      game.map.treasure_chest_dict[treasure_chest.guid] = treasure_chest;
+      game.map.add_treasure_chest(game, treasure_chest);
     } else if (game.engine.is_right_mouse_down) {
       editor_spawn_mode = EditorSpawnMode::None;
     }
@@ -295,7 +298,7 @@ void Editor::handle_input_events(Game &game) {
           Vec2(game.engine.mouse_point_game_rect_scaled_camera));
       auto item = item_deserialize_from_file(game, prefab_file_path.c_str());
       set_world_point_from_tile_point(tile_point, item.sprite.dst);
-      game.map.item_dict[item.guid] = item;
+      game.map.add_item(game, item);
     } else if (game.engine.is_right_mouse_down) {
       editor_spawn_mode = EditorSpawnMode::None;
     }
@@ -329,19 +332,33 @@ void Editor::handle_input_events(Game &game) {
         auto sprite = &game.map.tiles.at(tile_idx).sprite;
         if (tile_layer != -1) {
           assert(tile_layer <= (int)game.map.layers.size() - 1);
-          sprite = &game.map.layers.at(tile_layer).at(tile_idx);
+          auto &layer = game.map.layers.at(tile_layer);
+          sprite = layer.get_sprite(tile_idx);
+          // layers only store the tiles that have a sprite
+          if (game.engine.is_mouse_held_down && sprite == nullptr) {
+            auto layer_sprite = Sprite();
+            set_world_point_from_tile_point(tile_point, layer_sprite.dst);
+            sprite = &layer.add_sprite(tile_idx, layer_sprite);
+          } else if (game.engine.is_right_mouse_held_down) {
+            layer.remove_sprite(tile_idx);
+            sprite = nullptr;
+          }
         }
-        if (game.engine.is_mouse_held_down) {
+        if (sprite != nullptr && game.engine.is_mouse_held_down) {
           sprite->image = image;
           sprite->srcs.clear();
           sprite->srcs.push_back(
               SpriteSrc(ImageLocation(image, tilesheet_src)));
-        } else if (game.engine.is_right_mouse_held_down) {
+          game.map.expand_max_sprite_dims(*sprite);
+        } else if (sprite != nullptr &&
+                   game.engine.is_right_mouse_held_down) {
           sprite->srcs.clear();
-          if (tile_layer == -1) {
-            sprite->srcs.push_back(
-                SpriteSrc(ImageLocation(image, Rect(0, 0, 20, 20))));
-          }
+          sprite->srcs.push_back(
+              SpriteSrc(ImageLocation(image, Rect(0, 0, 20, 20))));
+        }
+        if (game.engine.is_mouse_held_down ||
+            game.engine.is_right_mouse_held_down) {
+          game.map.set_tile_sprites_changed(tile_point);
         }
       }
     }
@@ -349,16 +366,15 @@ void Editor::handle_input_events(Game &game) {
     auto tile_point = world_point_to_tile_point(
         Vec2(game.engine.mouse_point_game_rect_scaled_camera));
     auto tile_idx = twod_to_oned_idx(tile_point, game.map.rows);
-    auto &tile = game.map.tiles.at(tile_idx);
     auto &tile_obstacle_sprite = tile_obstacle_sprites.at(tile_idx);
     // sometimes the mouse can go out of the game rect so the tile idx would
     // be out of bounds.
     if (game.engine.mouse_in_game_rect && tile_idx >= 0 &&
         tile_idx <= (int)game.map.tiles.size() - 1) {
       if (game.engine.is_mouse_held_down) {
-        tile.is_obstacle = true;
+        game.map.set_tile_is_obstacle(tile_point, true);
       } else if (game.engine.is_right_mouse_held_down) {
-        tile.is_obstacle = false;
+        game.map.set_tile_is_obstacle(tile_point, false);
       }
     } else if (!game.engine.mouse_in_game_rect) {
       if (game.engine.is_right_mouse_down) {
@@ -367,7 +383,7 @@ void Editor::handle_input_events(Game &game) {
       }
     }
   } else if (editor_spawn_mode == EditorSpawnMode::TileWarpPointToMap) {
-    /*auto tile_point = world_point_to_tile_point(
+    auto tile_point = world_point_to_tile_point(
         Vec2(game.engine.mouse_point_game_rect_scaled_camera));
     auto tile_idx = twod_to_oned_idx(tile_point, game.map.rows);
     auto &tile = game.map.tiles.at(tile_idx);
@@ -378,21 +394,22 @@ void Editor::handle_input_events(Game &game) {
     if (game.engine.mouse_in_game_rect && tile_idx >= 0 &&
         tile_idx <= (int)game.map.tiles.size() - 1) {
       if (game.engine.is_mouse_held_down) {
-        tile.is_warp_point_to_map = true;
+        tile.is_warp_point = true;
         string formatted_map_file_path = "../assets/prefabs/maps/";
         formatted_map_file_path += warp_to_map_file_path;
         formatted_map_file_path += ".json";
         tile.warps_to_map_file_path = formatted_map_file_path;
         tile.warps_to_tile_point = warp_to_map_tile_point;
       } else if (game.engine.is_right_mouse_held_down) {
-        tile.is_warp_point_to_map = false;
+        tile.is_warp_point = false;
+        tile.warps_to_map_file_path = "";
       }
     } else if (!game.engine.mouse_in_game_rect) {
       if (game.engine.is_right_mouse_down) {
         editor_spawn_mode = EditorSpawnMode::None;
         in_warp_point_to_map_mode = false;
       }
-    }*/
+    }
   } else if (editor_spawn_mode == EditorSpawnMode::TileWarpPoint) {
     auto tile_point = world_point_to_tile_point(
         Vec2(game.engine.mouse_point_game_rect_scaled_camera));
@@ -406,8 +423,10 @@ void Editor::handle_input_events(Game &game) {
       if (game.engine.is_mouse_held_down) {
         tile.is_warp_point = true;
         tile.warps_to_tile_point = warp_to_map_tile_point;
+        tile.warps_to_map_file_path = "";
       } else if (game.engine.is_right_mouse_held_down) {
         tile.is_warp_point = false;
+        tile.warps_to_map_file_path = "";
       }
     } else if (!game.engine.mouse_in_game_rect) {
       if (game.engine.is_right_mouse_down) {
@@ -416,7 +435,7 @@ void Editor::handle_input_events(Game &game) {
       }
     }
   } else if (editor_spawn_mode == EditorSpawnMode::AiWalkPath) {
-    auto &unit = game.map.unit_dict.at(inspecting_prefab_guid);
+    auto &unit = game.map.unit_dict.at(inspecting_prefab_handle);
     if (game.engine.mouse_in_game_rect) {
       if (game.engine.is_mouse_down) {
         auto tile_point = world_point_to_tile_point_move_grid(
@@ -430,14 +449,14 @@ void Editor::handle_input_events(Game &game) {
   } else if (editor_spawn_mode == EditorSpawnMode::None) {
     if (game.engine.mouse_in_game_rect) {
       if (game.map.unit_input.clicked) {
-        inspecting_prefab_guid = game.map.unit_input.guid;
-        auto &unit = game.map.unit_dict.at(inspecting_prefab_guid);
+        inspecting_prefab_handle = game.map.unit_input.handle;
+        auto &unit = game.map.unit_dict.at(inspecting_prefab_handle);
         editor_inspect_mode = EditorInspectMode::Unit;
       } else if (game.map.treasure_chest_input.clicked) {
-        inspecting_prefab_guid = game.map.treasure_chest_input.guid;
+        inspecting_prefab_handle = game.map.treasure_chest_input.handle;
         editor_inspect_mode = EditorInspectMode::TreasureChest;
       } else if (game.map.item_input.clicked) {
-        inspecting_prefab_guid = game.map.item_input.guid;
+        inspecting_prefab_handle = game.map.item_input.handle;
         editor_inspect_mode = EditorInspectMode::Item;
       } else if (game.engine.is_mouse_up) {
         editor_inspect_mode = EditorInspectMode::Tile;
@@ -450,14 +469,14 @@ void Editor::handle_input_events(Game &game) {
       // only allow removing entities if not playing
       if (!game.editor_state.in_play_mode) {
         if (game.map.unit_input.right_clicked) {
-          game.map.erase_unit_guid(game, game.map.unit_input.guid);
+          game.map.erase_unit_handle(game, game.map.unit_input.handle);
           editor_inspect_mode = EditorInspectMode::None;
         } else if (game.map.treasure_chest_input.right_clicked) {
-          game.map.treasure_chest_dict.erase(
-              game.map.treasure_chest_input.guid);
+          game.map.erase_treasure_chest_handle(
+              game, game.map.treasure_chest_input.handle);
           editor_inspect_mode = EditorInspectMode::None;
         } else if (game.map.item_input.right_clicked) {
-          game.map.item_dict.erase(game.map.item_input.guid);
+          game.map.erase_item_handle(game, game.map.item_input.handle);
           editor_inspect_mode = EditorInspectMode::None;
         }
       }
@@ -477,9 +496,12 @@ void Editor::update_nav_window(Game &game) {
     game.editor_state.in_play_mode = !game.editor_state.in_play_mode;
     if (game.editor_state.in_play_mode) {
       prev_map = game.map;
+      prev_map.add_entity_guids(game.editor_state.saved_map_guids);
       prev_ui = game.ui;
       prev_camera = game.engine.camera;
     } else {
+      game.map.release_entity_handles(game);
+      game.editor_state.saved_map_guids.clear();
       game.map = prev_map;
       game.ui = prev_ui;
       game.engine.camera = prev_camera;
@@ -537,6 +559,11 @@ void Editor::update_nav_window(Game &game) {
       formatted_prefab_file_name += ".json";
       map_serialize_into_file(game, game.map,
                               formatted_prefab_file_name.c_str());
+      // the game loads the binary map when there is one
+      map_serialize_into_binary_file(
+          game, game.map,
+          get_binary_map_file_path(formatted_prefab_file_name).c_str());
+      game.map_loader.erase(formatted_prefab_file_name);
       game.assets.update_all_assets_from_files(game);
       formatted_prefab_file_name = "";
     }
@@ -574,8 +601,8 @@ void Editor::update_tilesheet_window(Game &game) {
       editor_spawn_mode = EditorSpawnMode::None;
     }
   }
-  /* InputTextString("Warp to map", &warp_to_map_file_path,
-                   ImGuiInputTextFlags_CallbackResize);*/
+  InputTextString("Warp to map", &warp_to_map_file_path,
+                  ImGuiInputTextFlags_CallbackResize);
   if (ImGui::InputInt("Warp to tile x", &warp_to_map_tile_point.x, 1)) {
     if (warp_to_map_tile_point.x < 0) {
       warp_to_map_tile_point.x = 0;
@@ -586,14 +613,19 @@ void Editor::update_tilesheet_window(Game &game) {
       warp_to_map_tile_point.y = 0;
     }
   }
-  /*if (ImGui::Checkbox("Warp point to other map mode##tiles",
+  if (ImGui::Checkbox("Warp point to other map mode##tiles",
                       &in_warp_point_to_map_mode)) {
     if (in_warp_point_to_map_mode) {
       editor_spawn_mode = EditorSpawnMode::TileWarpPointToMap;
     } else {
       editor_spawn_mode = EditorSpawnMode::None;
     }
-  }*/
+  }
+  ImGui::Text(("Map cache: " + to_string(game.map_loader.get_cache_size()) +
+               " maps, " +
+               to_string(game.map_loader.get_cache_num_bytes() / 1024) +
+               " / " + to_string(MAP_CACHE_MAX_BYTES / 1024) + " kb")
+                  .c_str());
   ImGui::Text("Tiles");
   if (ImGui::InputInt("Layer", &tile_layer, 1)) {
     if (tile_layer < -1) {
@@ -889,6 +921,9 @@ void Editor::update_inspect_tile(Game &game) {
         ("warps to tile x: " + to_string(tile.warps_to_tile_point.x)).c_str());
     ImGui::Text(
         ("warps to tile y: " + to_string(tile.warps_to_tile_point.y)).c_str());
+    if (tile.warps_to_map_file_path.size() > 0) {
+      ImGui::Text(("warps to map: " + tile.warps_to_map_file_path).c_str());
+    }
   }
 }
 
@@ -909,7 +944,7 @@ void Editor::update_inspect_unit(Game &game) {
   ImGui::Text(("is unit moving: " + to_string(unit.is_moving)).c_str());
   ImGui::Text(("is unit ai walking: " + to_string(unit.is_ai_walking)).c_str());
   ImGui::Text(("in dialog with unit handle: " +
-               to_string(unit.in_dialogue_with_unit_guid))
+               to_string(unit.in_dialogue_with_unit_handle.value))
                   .c_str());
   ImGui::Text(("Money: " + to_string(unit.coin.quantity)).c_str());
   if (ImGui::BeginCombo("Unit name##unit",
@@ -986,6 +1021,9 @@ void Editor::update_inspect_unit(Game &game) {
       unit.sprite.hitbox_dims.y = 0;
     }
   }
+  // does nothing if the unit is a prefab and not on the map
+  game.map.occupancy_grid.move_unit(unit.handle,
+                                    unit.sprite.get_tile_point_hit_box());
   ImGui::Text("hitbox sizes for gui stuff");
   if (ImGui::InputInt("hitbox width##unit input events",
                       &unit.sprite.hitbox_dims_input_events.x)) {
@@ -1605,8 +1643,8 @@ Unit &Editor::get_inspected_unit(Game &game) {
   // the item that was being inspected has been picked up by the player
   // and removed from the item_dict.
   if (!inspect_prefab_mode) {
-    if (game.map.unit_dict.contains(inspecting_prefab_guid)) {
-      return game.map.unit_dict.at(inspecting_prefab_guid);
+    if (game.map.unit_dict.contains(inspecting_prefab_handle)) {
+      return game.map.unit_dict.at(inspecting_prefab_handle);
     }
   }
 
@@ -1617,8 +1655,8 @@ Item &Editor::get_inspected_item(Game &game) {
   // the item that was being inspected has been picked up by the player
   // and removed from the item_dict.
   if (!inspect_prefab_mode) {
-    if (game.map.item_dict.contains(inspecting_prefab_guid)) {
-      return game.map.item_dict.at(inspecting_prefab_guid);
+    if (game.map.item_dict.contains(inspecting_prefab_handle)) {
+      return game.map.item_dict.at(inspecting_prefab_handle);
     }
   }
 
@@ -1629,8 +1667,8 @@ TreasureChest &Editor::get_inspected_treasure_chest(Game &game) {
   // the item that was being inspected has been picked up by the player
   // and removed from the item_dict.
   if (!inspect_prefab_mode) {
-    if (game.map.treasure_chest_dict.contains(inspecting_prefab_guid)) {
-      return game.map.treasure_chest_dict.at(inspecting_prefab_guid);
+    if (game.map.treasure_chest_dict.contains(inspecting_prefab_handle)) {
+      return game.map.treasure_chest_dict.at(inspecting_prefab_handle);
     }
   }
 
@@ -189,6 +189,9 @@ void Engine::start() {
   mt19937 mt(rd());
   rnd = mt;
 
+  // one mapped file instead of an open per image, font and prefab
+  asset_archive.open(ASSET_ARCHIVE_FILE_PATH);
+
   // load cursors
   load_cursors();
 
@@ -197,6 +200,7 @@ void Engine::start() {
 
   // load default shader
   load_default_shader();
+  load_static_map_shader();
 
   // load fonts
   load_fonts();
@@ -245,7 +249,11 @@ void Engine::change_cursor_to_end_of_frame_cursor() {
 }
 
 SDL_Cursor *Engine::load_cursor(const char *file_path) {
-  SDL_Surface *cursor_surface = IMG_Load(file_path);
+  auto blob = asset_archive.find(file_path);
+  auto rw = blob.data != nullptr
+                ? SDL_RWFromConstMem(blob.data, blob.num_bytes)
+                : SDL_RWFromFile(file_path, "rb");
+  SDL_Surface *cursor_surface = IMG_Load_RW(rw, 1);
   if (!cursor_surface) {
     printf("set cursor error");
     abort();
@@ -516,6 +524,87 @@ void Engine::present_render_buffer() {
   clear_render_buffer();
 }
 
+// buffers that stay on the gpu between frames. Vertices are world points,
+// begin_static_draw sets the camera and scale they are drawn with.
+void Engine::upload_static_buffers(GLuint &_vao, GLuint &_vbo, GLuint &_ubo,
+                                   vector<short> &_vertices,
+                                   vector<float> &_uvs) {
+  if (_vao == 0) {
+    glGenVertexArrays(1, &_vao);
+    glGenBuffers(1, &_vbo);
+    glGenBuffers(1, &_ubo);
+  }
+  glBindVertexArray(_vao);
+  glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(short) * _vertices.size(),
+               _vertices.data(), GL_STATIC_DRAW);
+  glVertexAttribPointer(0, 2, GL_SHORT, GL_FALSE, 2 * sizeof(short), 0);
+
+  glBindBuffer(GL_ARRAY_BUFFER, _ubo);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(float) * _uvs.size(), _uvs.data(),
+               GL_STATIC_DRAW);
+  glVertexAttribPointer(1, 2, GL_FLOAT, GL_TRUE, 2 * sizeof(GLfloat), 0);
+
+  glEnableVertexAttribArray(0);
+  glEnableVertexAttribArray(1);
+
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  // present_render_buffer expects the engine's vao to be bound
+  glBindVertexArray(vao);
+}
+
+// replaces num_vertices vertices (2 shorts, 2 uvs each) starting at
+// first_vertex.
+void Engine::update_static_buffers(GLuint _vbo, GLuint _ubo, int first_vertex,
+                                   short *_vertices, float *_uvs,
+                                   int num_vertices) {
+  glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+  glBufferSubData(GL_ARRAY_BUFFER, sizeof(short) * 2 * first_vertex,
+                  sizeof(short) * 2 * num_vertices, _vertices);
+  glBindBuffer(GL_ARRAY_BUFFER, _ubo);
+  glBufferSubData(GL_ARRAY_BUFFER, sizeof(float) * 2 * first_vertex,
+                  sizeof(float) * 2 * num_vertices, _uvs);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void Engine::delete_static_buffers(GLuint &_vao, GLuint &_vbo, GLuint &_ubo) {
+  if (_vao == 0) {
+    return;
+  }
+  glDeleteBuffers(1, &_vbo);
+  glDeleteBuffers(1, &_ubo);
+  glDeleteVertexArrays(1, &_vao);
+  _vao = 0;
+  _vbo = 0;
+  _ubo = 0;
+}
+
+// sends what is in the render buffer first so draw order is kept.
+void Engine::begin_static_draw(Vec2 camera_dst) {
+  if (num_draw_calls > 0) {
+    present_render_buffer();
+  }
+  set_active_shader(ShaderName::StaticMap);
+  glUniform2f(static_map_camera_location, camera_dst.x, camera_dst.y);
+  glUniform1f(static_map_scale_location, scale);
+}
+
+void Engine::draw_static_buffers(GLuint _vao, GLuint texture_id,
+                                 int first_vertex, int num_vertices) {
+  if (texture_id != current_texture_id) {
+    current_texture_id = texture_id;
+    glActiveTexture(GL_TEXTURE0);
+    bind_texture(texture_id);
+  }
+  glBindVertexArray(_vao);
+  glDrawArrays(GL_TRIANGLES, first_vertex, num_vertices);
+}
+
+void Engine::end_static_draw() {
+  glBindVertexArray(vao);
+  set_active_shader(ShaderName::Default);
+}
+
 void Engine::set_active_shader(ShaderName _shader_name) {
   glUseProgram(get_shader(_shader_name).shader_program_id);
 }
@@ -532,7 +621,7 @@ void Engine::set_active_image(Image &image) {
   clear_render_buffer();
   // set the new texture as active
   glActiveTexture(GL_TEXTURE0);
-  glBindTexture(GL_TEXTURE_2D, image.texture_id);
+  bind_texture(image.texture_id);
 }
 
 void Engine::load_images() {
@@ -550,32 +639,25 @@ void Engine::load_images() {
              "../assets/abilities/ability_targets.png");
 }
 
+// only the texture id and the dims (from the png's header) are needed up
+// front, the png is decoded and uploaded the first time the texture is
+// bound, so images the first map doesn't use are never decoded.
 Image Engine::load_image(ImageName _image_name, const char *_image_path) {
   GLuint texture_id;
   glGenTextures(1, &texture_id);
-  glBindTexture(GL_TEXTURE_2D, texture_id);
-
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
-  int width, height;
-  // load image using SOIL and store it on GPU
-  {
-    int n;
-    unsigned char *image = stbi_load(_image_path, &width, &height, &n, 0);
-
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA,
-                 GL_UNSIGNED_BYTE, image);
-
-    if (image == 0) {
-      printf("Failed to load texture image. %s\n", _image_path);
-      exit(1);
-    } else {
-      stbi_image_free(image);
-    }
+  int width, height, n;
+  auto blob = asset_archive.find(_image_path);
+  auto is_image =
+      blob.data != nullptr
+          ? stbi_info_from_memory((const stbi_uc *)blob.data, blob.num_bytes,
+                                  &width, &height, &n)
+          : stbi_info(_image_path, &width, &height, &n);
+  if (!is_image) {
+    printf("Failed to load texture image. %s\n", _image_path);
+    exit(1);
   }
+  unloaded_image_file_paths[texture_id] = string(_image_path);
 
   Image image;
   image.image_name = _image_name;
@@ -587,6 +669,58 @@ Image Engine::load_image(ImageName _image_name, const char *_image_path) {
   return image;
 }
 
+void Engine::bind_texture(GLuint texture_id) {
+  glBindTexture(GL_TEXTURE_2D, texture_id);
+  if (unloaded_image_file_paths.empty()) {
+    return;
+  }
+  auto it = unloaded_image_file_paths.find(texture_id);
+  if (it != unloaded_image_file_paths.end()) {
+    upload_image(it->second.c_str());
+    unloaded_image_file_paths.erase(it);
+  }
+}
+
+// decodes the image into the bound texture.
+void Engine::upload_image(const char *_image_path) {
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+  int width, height, n;
+  auto blob = asset_archive.find(_image_path);
+  unsigned char *image =
+      blob.data != nullptr
+          ? stbi_load_from_memory((const stbi_uc *)blob.data, blob.num_bytes,
+                                  &width, &height, &n, 0)
+          : stbi_load(_image_path, &width, &height, &n, 0);
+  if (image == 0) {
+    printf("Failed to load texture image. %s\n", _image_path);
+    exit(1);
+  }
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA,
+               GL_UNSIGNED_BYTE, image);
+  stbi_image_free(image);
+}
+
+// the file from the asset archive, or from disk when it isn't packed.
+bool Engine::read_asset_file(const char *file_path, string &contents) {
+  auto blob = asset_archive.find(file_path);
+  if (blob.data != nullptr) {
+    contents.assign(blob.data, blob.num_bytes);
+    return true;
+  }
+  ifstream file(file_path, ios::binary);
+  if (!file.good()) {
+    return false;
+  }
+  stringstream buffer;
+  buffer << file.rdbuf();
+  contents = buffer.str();
+  return true;
+}
+
 Image Engine::get_image(ImageName _image_name) {
   if (_image_name == ImageName::None) {
     "Engine::get_image. ImageName::None was passed in.\n";
@@ -644,6 +778,49 @@ void Engine::load_default_shader() {
   }
 }
 
+// the default shader with the camera offset and scale done on the gpu, used
+// for the baked map chunks.
+void Engine::load_static_map_shader() {
+  string vertexShader = "#version 330\n"
+                        "layout (location = 0) in vec2 vert;\n"
+                        "layout (location = 1) in vec2 _uv;\n"
+                        "uniform vec2 camera;\n"
+                        "uniform float scale;\n"
+                        "out vec2 uv;\n"
+                        "void main()\n"
+                        "{\n"
+                        "    uv = _uv;\n"
+                        "    vec2 p = (vert - camera) * scale;\n"
+                        "    gl_Position = vec4(p.x / " +
+                        to_string(window_resolution.x / 2) +
+                        " - 1.0, p.y / " + to_string(window_resolution.y / 2) +
+                        " - 1.0, 0.0, "
+                        "1.0);\n"
+                        "}\n";
+
+  string fragmentShader = "#version 330\n"
+                          "out vec4 color;\n"
+                          "in vec2 uv;\n"
+                          "uniform sampler2D tex;\n"
+                          "void main()\n"
+                          "{\n"
+                          "    color = texture(tex, uv);\n"
+                          "}\n";
+
+  auto shader_program_id =
+      getShaderProgramId(vertexShader.c_str(), fragmentShader.c_str());
+  static_map_camera_location =
+      glGetUniformLocation(shader_program_id, "camera");
+  static_map_scale_location = glGetUniformLocation(shader_program_id, "scale");
+  auto static_map_shader_idx = get_shader_idx(ShaderName::StaticMap);
+  auto static_map_shader = Shader(ShaderName::StaticMap, shader_program_id);
+  if (static_map_shader_idx != -1) {
+    shaders[static_map_shader_idx] = static_map_shader;
+  } else {
+    shaders.push_back(static_map_shader);
+  }
+}
+
 Shader Engine::get_shader(ShaderName _shader_name) {
   for (auto &shader : shaders) {
     if (shader.shader_name == _shader_name) {
@@ -714,12 +891,13 @@ void Engine::load_font(const char *_font_file_path_no_extension,
   auto base_file_path = string(_font_file_path_no_extension);
   auto fnt_file_path = base_file_path + ".fnt";
   auto png_file_path = base_file_path + ".png";
-  ifstream file(fnt_file_path.c_str());
-  if (!file.good()) {
+  string fnt;
+  if (!read_asset_file(fnt_file_path.c_str(), fnt)) {
     cout << "Engine::get_font_char_info_from_file. File error "
          << fnt_file_path.c_str() << "\n";
     abort();
   }
+  istringstream file(fnt);
   Font font;
   font.image = load_image(ImageName::FontAtlas, png_file_path.c_str());
   font.font_color = _font_color;
@@ -0,0 +1,25 @@
+#include "entity_handle.h"
+
+EntityHandle::EntityHandle(int idx, uint32_t generation) {
+  value = (generation << ENTITY_HANDLE_IDX_BITS) | (uint32_t)idx;
+}
+
+int EntityHandle::get_idx() const {
+  return (int)(value & ENTITY_HANDLE_IDX_MASK);
+}
+
+uint32_t EntityHandle::get_generation() const {
+  return value >> ENTITY_HANDLE_IDX_BITS;
+}
+
+bool EntityHandle::is_valid() const {
+  return value != INVALID_ENTITY_HANDLE_VALUE;
+}
+
+bool operator==(const EntityHandle &h1, const EntityHandle &h2) {
+  return h1.value == h2.value;
+}
+
+bool operator!=(const EntityHandle &h1, const EntityHandle &h2) {
+  return h1.value != h2.value;
+}
@@ -0,0 +1,67 @@
+#include "entity_registry.h"
+
+EntityRegistry::EntityRegistry() {
+  guids = vector<boost::uuids::uuid>();
+  generations = vector<uint32_t>();
+  free_idxs = vector<int>();
+}
+
+// the guid's handle, one is made for it if it doesn't have one yet.
+EntityHandle EntityRegistry::get_handle(boost::uuids::uuid guid) {
+  auto it = handles.find(guid);
+  if (it != handles.end()) {
+    return it->second;
+  }
+  int idx;
+  if (free_idxs.size() > 0) {
+    idx = free_idxs.back();
+    free_idxs.pop_back();
+    guids[idx] = guid;
+  } else {
+    idx = guids.size();
+    if ((uint32_t)idx >= ENTITY_HANDLE_IDX_MASK) {
+      cout << "EntityRegistry::get_handle. Out of entity handles." << endl;
+      abort();
+    }
+    guids.push_back(guid);
+    generations.push_back(0);
+  }
+  auto handle = EntityHandle(idx, generations[idx]);
+  handles[guid] = handle;
+  return handle;
+}
+
+// an invalid handle if the guid doesn't have one.
+EntityHandle EntityRegistry::find_handle(boost::uuids::uuid guid) {
+  auto it = handles.find(guid);
+  if (it == handles.end()) {
+    return EntityHandle();
+  }
+  return it->second;
+}
+
+boost::uuids::uuid EntityRegistry::get_guid(EntityHandle handle) {
+  GAME_ASSERT(contains(handle));
+  return guids[handle.get_idx()];
+}
+
+bool EntityRegistry::contains(EntityHandle handle) {
+  auto idx = handle.get_idx();
+  if (!handle.is_valid() || idx >= (int)guids.size()) {
+    return false;
+  }
+  auto it = handles.find(guids[idx]);
+  return it != handles.end() && it->second == handle;
+}
+
+void EntityRegistry::release(EntityHandle handle) {
+  if (!contains(handle)) {
+    return;
+  }
+  auto idx = handle.get_idx();
+  handles.erase(guids[idx]);
+  if (generations[idx] < ENTITY_HANDLE_MAX_GENERATION) {
+    generations[idx] += 1;
+    free_idxs.push_back(idx);
+  }
+}
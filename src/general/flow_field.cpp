@@ -0,0 +1,93 @@
+#include "flow_field.h"
+
+const Vec2 FLOW_FIELD_DIRS[8] = {Vec2(-1, -1), Vec2(-1, 0), Vec2(-1, 1),
+                                 Vec2(0, -1),  Vec2(0, 1),  Vec2(1, -1),
+                                 Vec2(1, 0),   Vec2(1, 1)};
+
+FlowField::FlowField() {}
+
+void FlowField::set(const MoveGrid &move_grid,
+                    EntityHandle _target_unit_handle, Vec2 _target,
+                    Vec2 _hit_box_dims) {
+  target_unit_handle = _target_unit_handle;
+  target = _target;
+  hit_box_dims = _hit_box_dims;
+  move_grid_version = move_grid.version;
+  rows = move_grid.rows;
+  cols = move_grid.cols;
+  costs.assign(rows * cols, FLOW_FIELD_UNREACHED);
+  directions.assign(rows * cols, FLOW_FIELD_NO_DIRECTION);
+  reached_idxs.clear();
+  if (!point_in_bounds(target)) {
+    return;
+  }
+  costs[get_idx(target)] = 0;
+  reached_idxs.push_back(get_idx(target));
+  for (int i = 0; i < (int)reached_idxs.size(); i++) {
+    auto idx = reached_idxs[i];
+    auto p = get_point(idx);
+    // the search runs from the target, directions point from a neighbour
+    // back onto p.
+    for (int j = 0; j < 8; j++) {
+      auto n = Vec2(p.x - FLOW_FIELD_DIRS[j].x, p.y - FLOW_FIELD_DIRS[j].y);
+      if (!point_in_bounds(n) || costs[get_idx(n)] != FLOW_FIELD_UNREACHED ||
+          !move_grid.rect_is_walkable(
+              Rect(n.x, n.y, hit_box_dims.x, hit_box_dims.y))) {
+        continue;
+      }
+      auto n_idx = get_idx(n);
+      costs[n_idx] = costs[idx] + 1;
+      directions[n_idx] = (int8_t)j;
+      reached_idxs.push_back(n_idx);
+    }
+  }
+}
+
+bool FlowField::is_stale(const MoveGrid &move_grid, Vec2 target_point) {
+  return move_grid_version != move_grid.version || !(target == target_point);
+}
+
+// follows the directions from the unit's position for at most max_steps
+// steps. The path stops before the first point where the unit would overlap
+// another unit, which is usually next to the target. Like PathFinder::path
+// it excludes the start.
+void FlowField::set_path(const OccupancyGrid &occupancy_grid,
+                         Rect unit_hit_box, int max_steps,
+                         vector<Vec2> &path) {
+  path.clear();
+  auto p = unit_hit_box.get_xy();
+  if (!point_in_bounds(p)) {
+    return;
+  }
+  for (int i = 0; i < max_steps; i++) {
+    auto dir = directions[get_idx(p)];
+    if (dir == FLOW_FIELD_NO_DIRECTION) {
+      break;
+    }
+    auto next_p =
+        Vec2(p.x + FLOW_FIELD_DIRS[dir].x, p.y + FLOW_FIELD_DIRS[dir].y);
+    auto moved_hit_box = unit_hit_box;
+    moved_hit_box.x = next_p.x;
+    moved_hit_box.y = next_p.y;
+    if (occupancy_grid.rect_is_occupied(moved_hit_box, unit_hit_box)) {
+      break;
+    }
+    path.push_back(next_p);
+    p = next_p;
+  }
+}
+
+int FlowField::get_cost(Vec2 p) {
+  if (!point_in_bounds(p)) {
+    return FLOW_FIELD_UNREACHED;
+  }
+  return costs[get_idx(p)];
+}
+
+bool FlowField::point_in_bounds(Vec2 p) {
+  return p.x >= 0 && p.x < rows && p.y >= 0 && p.y < cols;
+}
+
+int FlowField::get_idx(Vec2 p) { return p.x * cols + p.y; }
+
+Vec2 FlowField::get_point(int idx) { return Vec2(idx / cols, idx % cols); }
@@ -22,6 +22,8 @@ bool EditorState::no_editor_or_editor_and_in_play_mode() {
 
 void Game::start(std::string server, bool _is_host) {
   engine.start();
+  path_request_service.start();
+  map_loader.start(*this);
   // populate game flags vec with all false before loading into it
   for (size_t i = 0; i < static_cast<int>(GameFlag::Last); i++) {
     // treat GameFlag::None as truthy or as always being set. Useful for
@@ -104,15 +106,21 @@ void Game::update() {
   // intiially
   engine.set_cursor(CursorType::Default);
   map.update(*this);
-  // a map transition has been requested, transition to the new map.
-  // doing this after map.update because if done immediately (from map.update
-  // tween callback) everything will be invalidated as it is a new map now.
+  map_loader.prefetch_near_player(*this);
+  // a map transition has been requested, start loading the new map. The
+  // current map keeps going until the MapLoader is done.
   if (map_transition_request.transition_requested) {
-    map_transition(*this, map_transition_request.transition_to_map_file,
-                   map_transition_request.transition_to_map_tile_point);
+    map_loader.load(*this, map_transition_request.transition_to_map_file,
+                    map_transition_request.transition_to_map_tile_point);
+    map_transition_request.clear();
+  }
+  // swap in the loaded map. Doing this after map.update because if done
+  // immediately (from map.update tween callback) everything will be
+  // invalidated as it is a new map now.
+  if (map_loader.is_loaded()) {
+    map_loader.finish(*this);
     // update the new map so it can draw this frame
     map.update(*this);
-    map_transition_request.clear();
   }
   ui.update(*this);
   // set the cursor to whatever was set last using engine.set_cursor
@@ -126,6 +134,8 @@ void Game::draw() {
 }
 
 void Game::stop() {
+  path_request_service.stop();
+  map_loader.stop();
   game_client.Stop();
   game_server.Stop();
   ShutdownSteamDatagramConnectionSockets();
@@ -11,7 +11,7 @@ string GameEvent::serialize(Game &game) {
   game.serializer.serialize_string_val("guid", to_string(game.player.guid));
   switch (m_event_type) {
   case GameEventType::Move: {
-    game.serializer.serialize_string_val("unit_guid", to_string(m_unit_guid));
+    game.serializer.serialize_entity_handle(game, "unit_guid", m_unit_handle);
     game.serializer.serialize_int("x", m_tile_point.x);
     game.serializer.serialize_int("y", m_tile_point.y);
     game.serializer.serialize_bool("allow_units_to_path_through_each_other",
@@ -29,13 +29,13 @@ string GameEvent::serialize(Game &game) {
     break;
   }
   case GameEventType::CollectItemRequest: {
-    game.serializer.serialize_string_val("unit_guid", to_string(m_unit_guid));
-    game.serializer.serialize_string_val("item_guid", to_string(m_item_guid));
+    game.serializer.serialize_entity_handle(game, "unit_guid", m_unit_handle);
+    game.serializer.serialize_entity_handle(game, "item_guid", m_item_handle);
     break;
   }
   case GameEventType::CollectItemRespond: {
-    game.serializer.serialize_string_val("unit_guid", to_string(m_unit_guid));
-    game.serializer.serialize_string_val("item_guid", to_string(m_item_guid));
+    game.serializer.serialize_entity_handle(game, "unit_guid", m_unit_handle);
+    game.serializer.serialize_entity_handle(game, "item_guid", m_item_handle);
     break;
   }
   default: {
@@ -57,7 +57,8 @@ GameEvent GameEvent::deserialize(Game &game, const string &message) {
   event.m_sender_guid = obj["guid"].GetUint();
   switch (event.m_event_type) {
   case GameEventType::Move: {
-    event.m_unit_guid = game.engine.string_gen(obj["unit_guid"].GetString());
+    event.m_unit_handle = game.entity_registry.find_handle(
+        game.engine.string_gen(obj["unit_guid"].GetString()));
     event.m_tile_point.x = obj["x"].GetInt();
     event.m_tile_point.y = obj["y"].GetInt();
     event.m_allow_units_to_path_through_each_other =
@@ -73,13 +74,17 @@ GameEvent GameEvent::deserialize(Game &game, const string &message) {
     break;
   }
   case GameEventType::CollectItemRequest: {
-    event.m_unit_guid = game.engine.string_gen(obj["unit_guid"].GetString());
-    event.m_item_guid = game.engine.string_gen(obj["item_guid"].GetString());
+    event.m_unit_handle = game.entity_registry.find_handle(
+        game.engine.string_gen(obj["unit_guid"].GetString()));
+    event.m_item_handle = game.entity_registry.find_handle(
+        game.engine.string_gen(obj["item_guid"].GetString()));
     break;
   }
   case GameEventType::CollectItemRespond: {
-    event.m_unit_guid = game.engine.string_gen(obj["unit_guid"].GetString());
-    event.m_item_guid = game.engine.string_gen(obj["item_guid"].GetString());
+    event.m_unit_handle = game.entity_registry.find_handle(
+        game.engine.string_gen(obj["unit_guid"].GetString()));
+    event.m_item_handle = game.entity_registry.find_handle(
+        game.engine.string_gen(obj["item_guid"].GetString()));
     break;
   }
   default: {
@@ -92,14 +97,14 @@ GameEvent GameEvent::deserialize(Game &game, const string &message) {
 }
 
 string
-GameEvent::create_move_unit(Game &game, boost::uuids::uuid unit_guid,
+GameEvent::create_move_unit(Game &game, EntityHandle unit_handle,
                             Vec2 tile_point,
 
                             bool allow_units_to_path_through_each_other) {
   GameEvent event;
   event.m_event_type = GameEventType::Move;
   event.m_sender_guid = game.player.guid;
-  event.m_unit_guid = unit_guid;
+  event.m_unit_handle = unit_handle;
   event.m_tile_point = tile_point;
   event.m_allow_units_to_path_through_each_other =
       allow_units_to_path_through_each_other;
@@ -123,22 +128,22 @@ string GameEvent::player_handle_respond(Game &game, uint32_t receiver_guid,
   return event.serialize(game);
 }
 
-string GameEvent::collect_item_request(Game &game, boost::uuids::uuid unit_guid,
-                                       boost::uuids::uuid item_guid) {
+string GameEvent::collect_item_request(Game &game, EntityHandle unit_handle,
+                                       EntityHandle item_handle) {
   GameEvent event;
   event.m_event_type = GameEventType::CollectItemRequest;
   event.m_sender_guid = game.player.guid;
-  event.m_unit_guid = unit_guid;
-  event.m_item_guid = item_guid;
+  event.m_unit_handle = unit_handle;
+  event.m_item_handle = item_handle;
   return event.serialize(game);
 }
 
-string GameEvent::collect_item_respond(Game &game, boost::uuids::uuid unit_guid,
-                                       boost::uuids::uuid item_guid) {
+string GameEvent::collect_item_respond(Game &game, EntityHandle unit_handle,
+                                       EntityHandle item_handle) {
   GameEvent event;
   event.m_event_type = GameEventType::CollectItemRespond;
   event.m_sender_guid = game.player.guid;
-  event.m_unit_guid = unit_guid;
-  event.m_item_guid = item_guid;
+  event.m_unit_handle = unit_handle;
+  event.m_item_handle = item_handle;
   return event.serialize(game);
 }
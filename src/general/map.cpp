@@ -1,6 +1,7 @@
 #include "map.h"
 #include "game.h"
 #include "game_events.h"
+#include "map_reader.h"
 #include "rapidjson/document.h"
 #include "rapidjson/prettywriter.h" // for stringify JSON
 #include "rapidjson/stringbuffer.h"
@@ -8,18 +9,16 @@
 #include "tween.h"
 #include "utils.h"
 #include "utils_game.h"
+#include <atomic>
+#include <cmath>
 #include <fmt/format.h>
 #include <fstream>
 #include <iostream>
-#include <sstream>
 #include <string>
 
 Map::Map() {
   tiles = vector<Tile>();
-  layers = vector<vector<Sprite>>();
-  for (size_t i = 0; i < MAX_LAYERS; i++) {
-    layers.push_back(vector<Sprite>());
-  }
+  layers = vector<MapLayer>(MAX_LAYERS);
   rows = 0;
   cols = 0;
 }
@@ -27,12 +26,15 @@ Map::Map() {
 // deserialize calls this constructor
 Map::Map(Game &game) {
   tiles = vector<Tile>();
-  layers = vector<vector<Sprite>>();
-  for (size_t i = 0; i < MAX_LAYERS; i++) {
-    layers.push_back(vector<Sprite>());
-  }
+  layers = vector<MapLayer>(MAX_LAYERS);
   rows = 0;
   cols = 0;
+  set_ui(game);
+}
+
+// the map's own texts and icons. Maps loaded by the MapLoader are built
+// with Map() off the game thread and get these when they're swapped in.
+void Map::set_ui(Game &game) {
   move_point_icons = MovePointIcons(game);
   battle_move_action_point_text = Text(game, 10, FontColor::WhiteShadow, "",
                                        Vec2(0, 0), 150, TextAlignment::Left);
@@ -45,18 +47,8 @@ Map::Map(Game &game) {
 
 Map::Map(Game &game, int _rows, int _cols) {
   tiles = vector<Tile>();
-  layers = vector<vector<Sprite>>();
-  for (size_t i = 0; i < MAX_LAYERS; i++) {
-    layers.push_back(vector<Sprite>());
-  }
-  move_point_icons = MovePointIcons(game);
-  battle_move_action_point_text = Text(game, 10, FontColor::WhiteShadow, "",
-                                       Vec2(0, 0), 150, TextAlignment::Left);
-  battle_action_point_text = Text(game, 10, FontColor::WhiteShadow, "",
-                                  Vec2(0, 0), 150, TextAlignment::Left);
-  battle_action_point_description_text =
-      Text(game, 10, FontColor::WhiteShadow, "", Vec2(0, 0), 150,
-           TextAlignment::Left);
+  layers = vector<MapLayer>(MAX_LAYERS);
+  set_ui(game);
   rows = _rows;
   cols = _cols;
   rows_move_grid = _rows * MOVE_GRID_RATIO;
@@ -72,56 +64,58 @@ Map::Map(Game &game, int _rows, int _cols) {
       tile.sprite.dst.x = world_point.x;
       tile.sprite.dst.y = world_point.y;
       tiles.push_back(tile);
-
-      // populate all layers (leaves empty data for tiles that don't
-      // have layers but its more performant for rendering later, not sure
-      // if this approach is correct or not)
-      for (auto &layer_vec : layers) {
-        auto sprite = Sprite();
-        sprite.dst.x = world_point.x;
-        sprite.dst.y = world_point.y;
-        layer_vec.push_back(sprite);
-      }
     }
   }
+  for (auto &layer : layers) {
+    layer = MapLayer(rows * cols);
+  }
+
+  build_move_grid();
+  build_spatial_grids();
+  set_max_sprite_dims();
+  build_chunk_versions();
 
   add_all_player_units(game);
 
   auto u = Unit(game);
-  u.set_tile_point(Vec2(10, 10));
-  unit_dict[u.guid] = u;
+  u.set_tile_point(game, Vec2(10, 10));
+  add_unit(game, u);
 }
 
 void Map::process_game_events(Game &game) {
-  auto &acting_unit = unit_dict[player_unit_guids.at(0)];
+  auto &acting_unit = unit_dict[player_unit_handles.at(0)];
   while (!game_events.empty()) {
     GameEvent event = game_events.front();
     game_events.pop();
     switch (event.m_event_type) {
     case GameEventType::Move: {
-      unit_dict[event.m_unit_guid].move_to(
+      if (!unit_dict.contains(event.m_unit_handle)) {
+        break;
+      }
+      unit_dict[event.m_unit_handle].move_to(
           game, event.m_tile_point, 0,
           event.m_allow_units_to_path_through_each_other);
       break;
     }
     case GameEventType::CollectItemRequest: {
       fmt::print("Collect item request: {} -> {}\n",
-                 to_string(event.m_item_guid),
-                 item_dict.contains(event.m_item_guid));
-      if (game.player.is_host && item_dict.contains(event.m_item_guid) &&
-          !item_dict[event.m_item_guid].being_sent_to_player) {
-        fmt::print("Collect item request: {}\n", to_string(event.m_item_guid));
-        item_dict[event.m_item_guid].being_sent_to_player = true;
+                 event.m_item_handle.value,
+                 item_dict.contains(event.m_item_handle));
+      if (game.player.is_host && item_dict.contains(event.m_item_handle) &&
+          !item_dict[event.m_item_handle].being_sent_to_player) {
+        fmt::print("Collect item request: {}\n", event.m_item_handle.value);
+        item_dict[event.m_item_handle].being_sent_to_player = true;
         game.game_client.SendMessage(GameEvent::collect_item_respond(
-            game, event.m_unit_guid, event.m_item_guid));
+            game, event.m_unit_handle, event.m_item_handle));
       }
       break;
     }
     case GameEventType::CollectItemRespond: {
-      fmt::print("Collect item: {}\n", to_string(event.m_item_guid));
-      if (unit_dict.contains(event.m_unit_guid)) {
-        unit_dict[event.m_unit_guid].send_item_to_player(game,
-                                                         event.m_item_guid);
+      fmt::print("Collect item: {}\n", event.m_item_handle.value);
+      if (unit_dict.contains(event.m_unit_handle) &&
+          item_dict.contains(event.m_item_handle)) {
+        unit_dict[event.m_unit_handle].send_item_to_player(game,
+                                                           event.m_item_handle);
       }
       break;
     }
@@ -135,82 +129,108 @@ void Map::process_game_events(Game &game) {
 }
 
 void Map::update(Game &game) {
-  GAME_ASSERT(player_unit_guids.size() > 0);
-  item_guids_to_remove_at_end_of_frame.clear();
+  GAME_ASSERT(player_unit_handles.size() > 0);
+  item_handles_to_remove_at_end_of_frame.clear();
   battle_guids_to_remove_at_end_of_frame.clear();
   ability_handles_to_release_at_end_of_frame.clear();
   process_game_events(game);
+  deliver_path_results(game);
   // updates
   // clear some generic data (used by the editor)
   treasure_chest_input.clear();
   unit_input.clear();
   item_input.clear();
 
-  for (auto &tile : tiles) {
-    tile.update(game);
+  // tile and layer sprites are baked by game.map_renderer, only the visible
+  // range needs to be known here.
+  set_visible_tile_rect(game);
+  for (auto &treasure_chest : treasure_chest_dict.items) {
+    treasure_chest.update(game);
+    treasure_chest_grid.update(treasure_chest.handle,
+                               treasure_chest.get_bounding_dst());
   }
-  for (auto &layer_vec : layers) {
-    for (auto &sprite : layer_vec) {
-      sprite.update(game);
-    }
+  // keep the units in draw order, result is in the sorted_unit_handles vec
+  sort_unit_handles();
+  for (auto unit_handle : sorted_unit_handles) {
+    auto &unit = unit_dict[unit_handle];
+    unit.update(game);
+    unit_grid.update(unit_handle, unit.sprite.dst);
   }
-  for (auto &entry : treasure_chest_dict) {
-    // cout << "treasure chest guid " << entry.first << "\n";
-    auto key = entry.first;
-    auto &treasure_chest = entry.second;
-    treasure_chest.update(game);
+  for (auto &item : item_dict.items) {
+    item.update(game);
+    item_grid.update(item.handle, item.sprite.dst);
+  }
+
+  // the grids hold this frame's sprites now, including the ones that were
+  // added or moved by the updates above.
+  auto &mouse_point = game.engine.mouse_point_game_rect_scaled_camera;
+  treasure_chest_grid.query_point(mouse_point,
+                                  mouse_over_treasure_chest_handles);
+  unit_grid.query_point(mouse_point, mouse_over_unit_handles);
+  item_grid.query_point(mouse_point, mouse_over_item_handles);
+  for (auto handle : mouse_over_treasure_chest_handles) {
+    if (!treasure_chest_dict.contains(handle)) {
+      continue;
+    }
+    auto &treasure_chest = treasure_chest_dict[handle];
     if (!treasure_chest_input.is_mouse_over) {
-      treasure_chest_input.guid = key;
+      treasure_chest_input.handle = handle;
       treasure_chest_input.is_mouse_over =
           treasure_chest.sprite.input_events.is_mouse_over ||
           treasure_chest.opened_sprite.input_events.is_mouse_over;
     }
     if (treasure_chest.sprite.input_events.is_click ||
         treasure_chest.opened_sprite.input_events.is_click) {
-      treasure_chest_input.guid = key;
+      treasure_chest_input.handle = handle;
       treasure_chest_input.clicked = true;
     }
     if (treasure_chest.sprite.input_events.is_right_click ||
         treasure_chest.opened_sprite.input_events.is_right_click) {
-      treasure_chest_input.guid = key;
+      treasure_chest_input.handle = handle;
       treasure_chest_input.right_clicked = true;
     }
   }
-  // sort the units, result is in the set_sorted_unit_guid vec
-  set_sorted_unit_guids();
-  for (auto &guid : sorted_unit_guids) {
-    auto &unit = unit_dict[guid];
-    unit.update(game);
+  // in draw order like sorted_unit_handles
+  sort(mouse_over_unit_handles.begin(), mouse_over_unit_handles.end(),
+       [&](EntityHandle handle1, EntityHandle handle2) -> bool {
+         return unit_dict[handle1].sprite.dst.y >
+                unit_dict[handle2].sprite.dst.y;
+       });
+  for (auto handle : mouse_over_unit_handles) {
+    if (!unit_dict.contains(handle)) {
+      continue;
+    }
+    auto &unit = unit_dict[handle];
     // set is mouse over if not already set ( can be set from true to false
     // otherwise)
     if (!unit_input.is_mouse_over) {
-      unit_input.guid = guid;
+      unit_input.handle = handle;
       unit_input.is_mouse_over = unit.sprite.input_events.is_mouse_over;
     }
     if (unit.sprite.input_events.is_click) {
-      unit_input.guid = guid;
+      unit_input.handle = handle;
       unit_input.clicked = true;
     }
     if (unit.sprite.input_events.is_right_click) {
-      unit_input.guid = guid;
+      unit_input.handle = handle;
       unit_input.right_clicked = true;
     }
   }
-
-  for (auto &entry : item_dict) {
-    auto key = entry.first;
-    auto &item = entry.second;
-    item.update(game);
+  for (auto handle : mouse_over_item_handles) {
+    if (!item_dict.contains(handle)) {
+      continue;
+    }
+    auto &item = item_dict[handle];
     if (!item_input.is_mouse_over) {
-      item_input.guid = key;
+      item_input.handle = handle;
       item_input.is_mouse_over = item.sprite.input_events.is_mouse_over;
     }
     if (item.sprite.input_events.is_click) {
-      item_input.guid = key;
+      item_input.handle = handle;
       item_input.clicked = true;
     }
     if (item.sprite.input_events.is_right_click) {
-      item_input.guid = key;
+      item_input.handle = handle;
       item_input.right_clicked = true;
     }
   }
@@ -226,7 +246,7 @@ void Map::update(Game &game) {
   auto tmp_rect = Rect(0, 0, 0, 0);
   ability_timeout_tweens.update(game, tmp_rect);
 
-  auto &acting_unit = unit_dict[player_unit_guids.at(0)];
+  auto &acting_unit = unit_dict[player_unit_handles.at(0)];
   if (!acting_unit.in_battle) {
     if (treasure_chest_input.is_mouse_over || unit_input.is_mouse_over) {
       game.engine.set_cursor(CursorType::Hand);
@@ -284,8 +304,8 @@ void Map::update(Game &game) {
   game.engine.camera.keep_in_map_bounds(game, rows, cols);
 
   // handle any tween callbacks
-  for (auto item_guid : item_guids_to_remove_at_end_of_frame) {
-    item_dict.erase(item_guid);
+  for (auto item_handle : item_handles_to_remove_at_end_of_frame) {
+    erase_item_handle(game, item_handle);
   }
   for (auto ability_handle : ability_handles_to_release_at_end_of_frame) {
     abilities.release_handle(ability_handle);
@@ -295,49 +315,37 @@ void Map::update(Game &game) {
   }
 }
 
+// only the chunks of the visible tiles are drawn. The renderer is updated
+// here rather than in update so edits the editor made this frame show.
 void Map::draw(Game &game) {
-  for (auto &tile : tiles) {
-    tile.draw(game);
-  }
+  game.map_renderer.update(game, *this);
+  game.map_renderer.draw_tiles(game, *this);
   range_ability_target.draw(game);
   turn_order_ability_target.draw(game);
   displayed_ability_target.draw(game);
-  for (auto &layer_vec : layers) {
-    // layer draw order
-    for (int j = cols - 1; j >= 0; j--) {
-      for (int i = 0; i < rows; i++) {
-        auto idx = twod_to_oned_idx(Vec2(i, j), rows);
-        auto &sprite = layer_vec[idx];
-        sprite.draw(game);
-      }
-    }
-  }
-  for (auto &entry : treasure_chest_dict) {
-    auto key = entry.first;
-    auto &treasure_chest = entry.second;
+  game.map_renderer.draw_layers(game, *this);
+  for (auto &treasure_chest : treasure_chest_dict.items) {
     treasure_chest.draw(game);
   }
-  for (auto &guid : sorted_unit_guids) {
-    auto &unit = unit_dict[guid];
+  for (auto unit_handle : sorted_unit_handles) {
+    auto &unit = unit_dict[unit_handle];
     unit.unit_ui_before_unit.draw(game);
   }
-  for (auto &guid : sorted_unit_guids) {
-    auto &unit = unit_dict[guid];
+  for (auto unit_handle : sorted_unit_handles) {
+    auto &unit = unit_dict[unit_handle];
     unit.draw(game);
   }
   move_point_icons.draw(game);
 
-  for (auto &entry : item_dict) {
-    auto key = entry.first;
-    auto &item = entry.second;
+  for (auto &item : item_dict.items) {
     item.draw(game);
   }
-  for (auto &guid : sorted_unit_guids) {
-    auto &unit = unit_dict[guid];
+  for (auto unit_handle : sorted_unit_handles) {
+    auto &unit = unit_dict[unit_handle];
     unit.unit_ui_after_unit.draw(game);
   }
-  for (auto &guid : sorted_unit_guids) {
-    auto &unit = unit_dict[guid];
+  for (auto unit_handle : sorted_unit_handles) {
+    auto &unit = unit_dict[unit_handle];
     unit.unit_ui_last_layer.draw(game);
   }
   battle_move_action_point_text.draw(game);
@@ -350,6 +358,76 @@ void Map::draw(Game &game) {
   }
 }
 
+// the tiles on screen, found the same way Sprite::draw culls. Sprites are
+// drawn up and right from their tile point so the range is grown down and
+// left by max_sprite_dims.
+void Map::set_visible_tile_rect(Game &game) {
+  auto &camera_dst = game.engine.camera.dst;
+  visible_camera_dst = camera_dst;
+  auto view_w = game.engine.game_rect.w / (double)game.engine.scale;
+  auto view_h = game.engine.game_rect.h / (double)game.engine.scale;
+  auto min_x =
+      (int)floor((double)(camera_dst.x - max_sprite_dims.x) / TILE_SIZE);
+  auto min_y =
+      (int)floor((double)(camera_dst.y - max_sprite_dims.y) / TILE_SIZE);
+  auto max_x = (int)floor((camera_dst.x + view_w) / TILE_SIZE);
+  auto max_y = (int)floor((camera_dst.y + view_h) / TILE_SIZE);
+  min_x = max(min_x, 0);
+  min_y = max(min_y, 0);
+  max_x = min(max_x, rows - 1);
+  max_y = min(max_y, cols - 1);
+  visible_tile_rect = Rect(min_x, min_y, max(max_x - min_x + 1, 0),
+                           max(max_y - min_y + 1, 0));
+}
+
+void Map::set_max_sprite_dims() {
+  max_sprite_dims = Vec2(TILE_SIZE, TILE_SIZE);
+  for (auto &tile : tiles) {
+    expand_max_sprite_dims(tile.sprite);
+  }
+  for (auto &layer : layers) {
+    for (auto &sprite : layer.sprites) {
+      expand_max_sprite_dims(sprite);
+    }
+  }
+}
+
+// call when a tile or layer sprite's srcs change.
+void Map::expand_max_sprite_dims(const Sprite &sprite) {
+  for (auto &src : sprite.srcs) {
+    max_sprite_dims.x = max(max_sprite_dims.x, src.image_location.src.w);
+    max_sprite_dims.y = max(max_sprite_dims.y, src.image_location.src.h);
+  }
+}
+
+void Map::build_chunk_versions() {
+  chunk_rows = (rows + MAP_CHUNK_TILES - 1) / MAP_CHUNK_TILES;
+  chunk_cols = (cols + MAP_CHUNK_TILES - 1) / MAP_CHUNK_TILES;
+  chunk_versions = vector<uint32_t>(chunk_rows * chunk_cols);
+  for (auto &version : chunk_versions) {
+    version = get_next_map_chunk_version();
+  }
+}
+
+// call when a tile or layer sprite at tile_point is changed, added or
+// removed.
+void Map::set_tile_sprites_changed(Vec2 tile_point) {
+  chunk_versions.at(get_chunk_idx(tile_point)) = get_next_map_chunk_version();
+}
+
+int Map::get_chunk_idx(Vec2 tile_point) {
+  return (tile_point.x / MAP_CHUNK_TILES) * chunk_cols +
+         tile_point.y / MAP_CHUNK_TILES;
+}
+
+// versions are unique across maps, so a renderer never mistakes a chunk of a
+// newly loaded map for one it baked. 0 is never handed out. Atomic as maps
+// are also loaded on the MapLoader's thread.
+uint32_t get_next_map_chunk_version() {
+  static atomic<uint32_t> next_version(0);
+  return ++next_version;
+}
+
 void Map::update_battle_input(Game &game, Unit &acting_unit) {
   if (!game.ui.is_mouse_over_ui && acting_unit.is_ability_selected &&
       game.engine.is_right_mouse_up) {
@@ -361,7 +439,7 @@ void Map::update_battle_input(Game &game, Unit &acting_unit) {
   auto &battle = battle_dict[acting_unit.battle_guid];
   auto &ability = acting_unit.get_selected_ability(game);
   auto is_player_turn =
-      game.map.is_guid_in_all_player_units(battle.acting_unit_guid);
+      game.map.is_handle_in_all_player_units(battle.acting_unit_handle);
   game.ui.action_point_display.is_hidden = !is_player_turn;
   displayed_ability_target.is_hidden =
       game.ui.is_mouse_over_ui ||
@@ -394,7 +472,7 @@ void Map::update_battle_input(Game &game, Unit &acting_unit) {
   auto start = acting_unit.sprite.tile_point_hit_box.get_xy();
   auto target = mouse_tile_point_move_grid;
   if (unit_input.is_mouse_over) {
-    auto &receiving_unit = unit_dict[unit_input.guid];
+    auto &receiving_unit = unit_dict[unit_input.handle];
     target =
         get_unit_directional_target(acting_unit.sprite.tile_point_hit_box,
                                     receiving_unit.sprite.tile_point_hit_box);
@@ -413,7 +491,7 @@ void Map::battle_show_and_check_for_move(Game &game, Unit &acting_unit,
       is_ability_in_range(ability, acting_unit.sprite.dst.get_xy(),
                           game.engine.mouse_point_game_rect_scaled_camera);
   if (game.ui.is_mouse_over_ui || acting_unit.is_battle_acting ||
-      !game.map.is_guid_in_all_player_units(battle.acting_unit_guid)) {
+      !game.map.is_handle_in_all_player_units(battle.acting_unit_handle)) {
     move_point_icons.hide_all();
     if (game.ui.is_mouse_over_ui && !acting_unit.is_ability_selected) {
       game.ui.action_point_display.active = 0;
@@ -487,10 +565,12 @@ void Map::battle_show_and_check_for_move(Game &game, Unit &acting_unit,
       // regular move
       if (!acting_unit.is_ability_selected && !unit_input.is_mouse_over) {
         game.ui.action_point_display.active = 0;
+        // walk the path that was shown and costed
         auto battle_action = BattleAction();
-        battle_action.set_as_unit_move(
-            acting_unit.guid,
-            game.path_finder.path.at(game.path_finder.path.size() - 1));
+        battle_action.set_as_unit_move_along_path(
+            acting_unit.handle,
+            game.path_finder.path.at(game.path_finder.path.size() - 1),
+            game.path_finder.path);
         battle.add_battle_action(game, battle_action);
       }
       // ability is melee, move to get into range if necessary
@@ -504,17 +584,18 @@ void Map::battle_show_and_check_for_move(Game &game, Unit &acting_unit,
         // melee ability not in range, move to get into range
         if (!ability_in_range) {
           auto battle_action = BattleAction();
-          battle_action.set_as_unit_move(
-              acting_unit.guid,
-              game.path_finder.path.at(game.path_finder.path.size() - 1));
+          battle_action.set_as_unit_move_along_path(
+              acting_unit.handle,
+              game.path_finder.path.at(game.path_finder.path.size() - 1),
+              game.path_finder.path);
           battle.add_battle_action(game, battle_action);
         }
 
-        auto receiving_unit_guids = get_receiving_unit_guids(
+        auto receiving_unit_handles = get_receiving_unit_handles(
             game, ability, game.engine.mouse_point_game_rect_scaled_camera);
         auto use_ability_battle_action = BattleAction();
         use_ability_battle_action.set_as_use_ability(
-            acting_unit.guid, receiving_unit_guids, ability,
+            acting_unit.handle, receiving_unit_handles, ability,
             game.engine.mouse_point_game_rect_scaled);
         battle.add_battle_action(game, use_ability_battle_action);
       }
@@ -529,11 +610,11 @@ void Map::battle_show_and_check_for_move(Game &game, Unit &acting_unit,
         }
         acting_unit.is_ability_selected = false;
         game.ui.action_point_display.active = 0;
-        auto receiving_unit_guids = get_receiving_unit_guids(
+        auto receiving_unit_handles = get_receiving_unit_handles(
             game, ability, game.engine.mouse_point_game_rect_scaled_camera);
         auto use_ability_battle_action = BattleAction();
         use_ability_battle_action.set_as_use_ability(
-            acting_unit.guid, receiving_unit_guids, ability,
+            acting_unit.handle, receiving_unit_handles, ability,
             game.engine.mouse_point_game_rect_scaled);
         battle.add_battle_action(game, use_ability_battle_action);
       }
@@ -541,7 +622,7 @@ void Map::battle_show_and_check_for_move(Game &game, Unit &acting_unit,
       // end turn if a charge ability was used
       if (charge_ability_used) {
         auto end_turn_battle_action = BattleAction();
-        end_turn_battle_action.set_as_end_turn(acting_unit.guid);
+        end_turn_battle_action.set_as_end_turn(acting_unit.handle);
         battle.add_battle_action(game, end_turn_battle_action);
       }
 
@@ -556,19 +637,46 @@ void Map::battle_show_and_check_for_move(Game &game, Unit &acting_unit,
 // pathed to.
 pair<int, Vec2> Map::get_ap_of_move(Game &game, Unit &acting_unit, Vec2 start,
                                     Vec2 target) {
+  auto path_size = set_battle_path(game, acting_unit, start, target);
   auto actual_target = target;
-  game.path_finder.set_path(game, *this, acting_unit, start, target, false);
-  if (!game.path_finder.path_found) {
-    game.path_finder.set_path(game, *this, acting_unit, start,
-                              game.path_finder.closest_point_to_target, false);
-    actual_target = game.path_finder.closest_point_to_target;
+  if (game.path_finder.path.size() > 0) {
+    actual_target = game.path_finder.path[game.path_finder.path.size() - 1];
   }
-  return make_pair(get_path_ap_cost(game.path_finder.path.size(),
+  return make_pair(get_path_ap_cost(path_size,
                                     acting_unit.move_indexes_this_turn,
                                     acting_unit.num_moves_this_turn),
                    actual_target);
 }
 
+// sets game.path_finder.path to the target, or to the closest point to it,
+// and returns the number of move indexes the whole move would take. When
+// the unit isn't moving the battle's move range field answers this without
+// a search, past the field's range the rest of the path is estimated as a
+// straight line so the move shows as costing too many action points.
+// while the unit is moving the field is from where it started, so search.
+int Map::set_battle_path(Game &game, Unit &acting_unit, Vec2 start,
+                         Vec2 target) {
+  if (acting_unit.is_moving) {
+    game.path_finder.set_path(*this, acting_unit, start, target, false);
+    if (!game.path_finder.path_found) {
+      game.path_finder.set_path(*this, acting_unit, start,
+                                game.path_finder.closest_point_to_target,
+                                false);
+    }
+    return (int)game.path_finder.path.size();
+  }
+  GAME_ASSERT(battle_dict.contains(acting_unit.battle_guid));
+  auto &battle = battle_dict[acting_unit.battle_guid];
+  auto &move_range_field = battle.get_move_range_field(game, acting_unit);
+  auto closest_point = move_range_field.get_closest_point(target);
+  move_range_field.set_path(closest_point, game.path_finder.path);
+  auto path_size = (int)game.path_finder.path.size();
+  if (move_range_field.is_out_of_range(closest_point, target)) {
+    path_size += chebyshev_distance(closest_point, target);
+  }
+  return path_size;
+}
+
 void Map::update_ability_selected(Game &game, Unit &acting_unit,
                                   const Ability &ability) {
   if (game.ui.is_mouse_over_ui) {
@@ -585,32 +693,20 @@ void Map::update_ability_selected(Game &game, Unit &acting_unit,
     displayed_ability_target.update(game);
   }
 
-  auto receiving_unit_guids = get_receiving_unit_guids(
+  auto receiving_unit_handles = get_receiving_unit_handles(
       game, ability, game.engine.mouse_point_game_rect_scaled_camera);
-  for (auto unit_guid : receiving_unit_guids) {
-    auto &u = unit_dict[unit_guid];
+  for (auto unit_handle : receiving_unit_handles) {
+    auto &u = unit_dict[unit_handle];
     u.unit_ui_after_unit.crosshairs.set_is_hidden(false);
   }
 }
 
 void Map::update_battle_path(Game &game, Unit &acting_unit,
                              const Ability &ability, Vec2 start, Vec2 target) {
-  game.path_finder.set_path(game, *this, acting_unit, start, target, false);
-  if (!game.path_finder.path_found) {
-    game.path_finder.set_path(game, *this, acting_unit, start,
-                              game.path_finder.closest_point_to_target, false);
-  }
-  // if you have 5 ap, you can move a full 5 ap + 1 full move ap - 1 pixel
-  // so 5 ap means you can move 5 * MOVE_INDEXES_PER_ACTION_POINT +
-  // (MOVE_INDEXES_PER_ACTION_POINT - 1)
-  auto available_move_size = (acting_unit.stats.action_points.current *
-                              MOVE_INDEXES_PER_ACTION_POINT) +
-                             (MOVE_INDEXES_PER_ACTION_POINT - 1) -
-                             acting_unit.move_indexes_this_turn;
-  // can be < 0 becuase of the sub at the end
-  if (available_move_size < 0) {
-    available_move_size = 0;
-  }
+  set_battle_path(game, acting_unit, start, target);
+  auto available_move_size =
+      get_available_move_size(acting_unit.stats.action_points.current,
+                              acting_unit.move_indexes_this_turn);
 
   // not enough action points to the move the full path,
   // erase everything that is greater than the action points allow.
@@ -666,53 +762,46 @@ void Map::update_battle_ap_text(Game &game, Unit &acting_unit,
   battle_action_point_description_text.update(game);
 }
 
-vector<boost::uuids::uuid> Map::get_receiving_unit_guids(Game &game,
-                                                         const Ability &ability,
+vector<EntityHandle> Map::get_receiving_unit_handles(Game &game,
+                                                     const Ability &ability,
                                                          Vec2 target_dst) {
   if (ability.stats.aoe.current != 1) {
     return get_units_in_aoe(game, ability, target_dst);
   } else if (game.map.unit_input.is_mouse_over) {
     if (game.map.unit_input.is_mouse_over) {
-      return vector<boost::uuids::uuid>{game.map.unit_input.guid};
+      return vector<EntityHandle>{game.map.unit_input.handle};
     } else {
-      return vector<boost::uuids::uuid>();
+      return vector<EntityHandle>();
     }
   }
 
-  return vector<boost::uuids::uuid>();
+  return vector<EntityHandle>();
 }
 
-vector<boost::uuids::uuid>
+vector<EntityHandle>
 Map::get_units_in_aoe(Game &game, const Ability &ability, Vec2 target_dst) {
-  auto receiving_units = vector<boost::uuids::uuid>();
+  auto receiving_units = vector<EntityHandle>();
   get_receiving_units_ability_target = game.ability_targets.get_target(ability);
   get_receiving_units_ability_target.set_dst(game, target_dst);
   get_receiving_units_ability_target.update(game);
-  for (auto &entry : unit_dict) {
-    auto unit_guid = entry.first;
-    auto &unit = game.map.unit_dict[unit_guid];
-    if (rect_contains_circle(
-            get_receiving_units_ability_target.sprite.dst.get_center(),
-            get_receiving_units_ability_target.sprite.dst.w / 2,
-            unit.sprite.dst)) {
-      receiving_units.push_back(unit_guid);
-    }
-  }
+  unit_grid.query_circle(
+      get_receiving_units_ability_target.sprite.dst.get_center(),
+      get_receiving_units_ability_target.sprite.dst.w / 2, receiving_units);
   return receiving_units;
 }
 
 void Map::start_ability_timeout(
-    Game &game, boost::uuids::uuid acting_unit_guid,
-    vector<boost::uuids::uuid> &receiving_unit_guids, const Ability &ability,
+    Game &game, EntityHandle acting_unit_handle,
+    vector<EntityHandle> &receiving_unit_handles, const Ability &ability,
     Vec2 target_point, PerformAbilityContext _ability_context) {
-  GAME_ASSERT(unit_dict.contains(acting_unit_guid));
-  auto &acting_unit = unit_dict[acting_unit_guid];
+  GAME_ASSERT(unit_dict.contains(acting_unit_handle));
+  auto &acting_unit = unit_dict[acting_unit_handle];
   Uint32 duration = 500;
   auto start = Rect(0, 0, 0, 0);
   auto target = Rect(0, 0, 0, 0);
   auto callback = TweenCallback();
   callback.set_as_use_ability_timeout(
-      acting_unit_guid, receiving_unit_guids, ability.ability_name,
+      acting_unit_handle, receiving_unit_handles, ability.ability_name,
       ability.stats.damage.current, target_point, _ability_context);
   ability_timeout_tweens.tween_xys.push_back(TweenXY(
       start, target, game.engine.current_time, duration, 0, callback, []() {},
@@ -723,13 +812,13 @@ void Map::start_ability_timeout(
                                                           ability.display_name);
 }
 
-void Map::perform_ability(Game &game, boost::uuids::uuid acting_unit_guid,
-                          vector<boost::uuids::uuid> &_receiving_unit_guids,
+void Map::perform_ability(Game &game, EntityHandle acting_unit_handle,
+                          vector<EntityHandle> &_receiving_unit_handles,
                           const Ability &ability, Vec2 target_dst,
                           PerformAbilityContext _ability_context) {
-  GAME_ASSERT(unit_dict.contains(acting_unit_guid));
-  auto &acting_unit = unit_dict[acting_unit_guid];
-  if (_receiving_unit_guids.size() == 0) {
+  GAME_ASSERT(unit_dict.contains(acting_unit_handle));
+  auto &acting_unit = unit_dict[acting_unit_handle];
+  if (_receiving_unit_handles.size() == 0) {
     return;
   }
   if (acting_unit.in_battle) {
@@ -744,10 +833,10 @@ void Map::perform_ability(Game &game, boost::uuids::uuid acting_unit_guid,
   auto start = acting_unit.sprite.dst;
   auto target = acting_unit.sprite.dst;
   if (ability.stats.aoe.current == 1) {
-    GAME_ASSERT(_receiving_unit_guids.size() > 0);
-    GAME_ASSERT(unit_dict.contains(_receiving_unit_guids.at(0)));
-    auto &receiving_unit_guid = _receiving_unit_guids.at(0);
-    auto &receiving_unit = unit_dict[receiving_unit_guid];
+    GAME_ASSERT(_receiving_unit_handles.size() > 0);
+    GAME_ASSERT(unit_dict.contains(_receiving_unit_handles.at(0)));
+    auto &receiving_unit_handle = _receiving_unit_handles.at(0);
+    auto &receiving_unit = unit_dict[receiving_unit_handle];
     start = receiving_unit.sprite.dst;
     target = receiving_unit.sprite.dst;
   }
@@ -758,14 +847,14 @@ void Map::perform_ability(Game &game, boost::uuids::uuid acting_unit_guid,
     }
   }
 
-  auto receiving_unit_guids = _receiving_unit_guids;
+  auto receiving_unit_handles = _receiving_unit_handles;
 
   // if spawning multiple abilities, make sure only one of them is the final
   // ability, if you don't then advance turn will be called multiple times
   // in complete. We are not spawning multiple abilities yet however.
   auto callback = TweenCallback();
   callback.set_as_use_ability(
-      acting_unit_guid, receiving_unit_guids, ability_handle,
+      acting_unit_handle, receiving_unit_handles, ability_handle,
       abilities.items[ability_handle].stats.damage.current, target_dst,
       _ability_context);
   if (ability.is_projectile) {
@@ -788,10 +877,10 @@ void Map::update_non_battle_input(Game &game, Unit &acting_unit) {
   if (acting_unit.in_dialogue) {
     handle_in_dialogue(game, acting_unit);
   } else if (unit_input.clicked && !acting_unit.is_ability_selected) {
-    handle_on_unit_click(game, acting_unit, unit_input.guid);
+    handle_on_unit_click(game, acting_unit, unit_input.handle);
   } else if (treasure_chest_input.clicked && !acting_unit.is_ability_selected) {
     handle_on_treasure_chest_click(game, acting_unit,
-                                   treasure_chest_input.guid);
+                                   treasure_chest_input.handle);
   } else if (!(treasure_chest_input.is_mouse_over || unit_input.is_mouse_over ||
                acting_unit.is_ability_selected)) {
     auto mouse_tile_point_move_grid = world_point_to_tile_point_move_grid(
@@ -799,7 +888,7 @@ void Map::update_non_battle_input(Game &game, Unit &acting_unit) {
     if (game.engine.is_mouse_down) {
       // acting_unit.move_to(game, mouse_tile_point_move_grid, 0, [](){});
       game.game_client.SendMessage(GameEvent::create_move_unit(
-          game, acting_unit.guid, mouse_tile_point_move_grid, true));
+          game, acting_unit.handle, mouse_tile_point_move_grid, true));
     }
   }
 }
@@ -808,9 +897,10 @@ void Map::check_if_battle_start(Game &game, Unit &acting_unit) {
   if (acting_unit.in_battle) {
     return;
   }
-  for (auto &entry : unit_dict) {
-    auto &unit = entry.second;
-    if (unit.guid == acting_unit.guid) {
+  unit_grid.query_radius(acting_unit.sprite.dst.get_xy(), 100, nearby_handles);
+  for (auto &unit_handle : nearby_handles) {
+    auto &unit = unit_dict[unit_handle];
+    if (unit.handle == acting_unit.handle) {
       continue;
     }
     if (unit.faction != Faction::Enemy) {
@@ -819,32 +909,25 @@ void Map::check_if_battle_start(Game &game, Unit &acting_unit) {
     if (unit.stats.hp.current_equals_lower_bound()) {
       continue;
     }
-    auto delta_x = (double)(unit.sprite.dst.x - acting_unit.sprite.dst.x);
-    auto delta_y = (double)(unit.sprite.dst.y - acting_unit.sprite.dst.y);
-    auto delta_dist = sqrt(delta_x * delta_x + delta_y * delta_y);
-    if (delta_dist < 100) {
-      create_battle(game, acting_unit);
-    }
+    // create_battle reuses nearby_handles, one battle is enough anyway
+    create_battle(game, acting_unit);
+    return;
   }
 }
 
 void Map::create_battle(Game &game, Unit &acting_unit) {
   auto battle = Battle(game);
   // this loop will add the acting unit as well
-  for (auto &entry : unit_dict) {
-    auto &unit = entry.second;
+  unit_grid.query_radius(acting_unit.sprite.dst.get_xy(), 400, nearby_handles);
+  for (auto &unit_handle : nearby_handles) {
+    auto &unit = unit_dict[unit_handle];
     if (unit.stats.hp.current_equals_lower_bound()) {
       continue;
     }
-    auto delta_x = (double)(unit.sprite.dst.x - acting_unit.sprite.dst.x);
-    auto delta_y = (double)(unit.sprite.dst.y - acting_unit.sprite.dst.y);
-    auto delta_dist = sqrt(delta_x * delta_x + delta_y * delta_y);
-    if (delta_dist < 400) {
-      unit.in_battle = true;
-      unit.battle_guid = battle.guid;
-      unit.stop_moving(game);
-      battle.unit_guids.push_back(unit.guid);
-    }
+    unit.in_battle = true;
+    unit.battle_guid = battle.guid;
+    unit.stop_moving(game);
+    battle.unit_handles.push_back(unit.handle);
   }
   battle.start(game);
   battle_dict[battle.guid] = battle;
@@ -853,24 +936,21 @@ void Map::create_battle(Game &game, Unit &acting_unit) {
 
 void Map::pickup_nearby_items(Game &game, Unit &acting_unit) {
   // automatically pick up nearby items
-  for (auto &entry : item_dict) {
-    auto &item = entry.second;
-    auto delta_x = (double)(item.sprite.dst.x - acting_unit.sprite.dst.x);
-    auto delta_y = (double)(item.sprite.dst.y - acting_unit.sprite.dst.y);
-    auto delta_dist = sqrt(delta_x * delta_x + delta_y * delta_y);
-    if (delta_dist < 50 && !item.being_sent_to_player) {
-      game.game_client.SendMessage(
-          GameEvent::collect_item_request(game, acting_unit.guid, item.guid));
+  item_grid.query_radius(acting_unit.sprite.dst.get_xy(), 50, nearby_handles);
+  for (auto &item_handle : nearby_handles) {
+    auto &item = item_dict[item_handle];
+    if (!item.being_sent_to_player) {
+      game.game_client.SendMessage(GameEvent::collect_item_request(
+          game, acting_unit.handle, item.handle));
     }
   }
 }
 
-// unit is in dialogue with another unit if this function is called
 void Map::handle_in_dialogue(Game &game, Unit &acting_unit) {
   if (game.engine.is_mouse_up) {
-    auto &dialogue_unit = unit_dict[acting_unit.in_dialogue_with_unit_guid];
+    auto &dialogue_unit = unit_dict[acting_unit.in_dialogue_with_unit_handle];
     auto dialogue_over =
-        dialogue_unit.show_next_dialogue(game, acting_unit.guid);
+        dialogue_unit.show_next_dialogue(game, acting_unit.handle);
     if (dialogue_over) {
       dialogue_unit.in_dialogue = false;
       acting_unit.in_dialogue = false;
@@ -879,12 +959,12 @@ void Map::handle_in_dialogue(Game &game, Unit &acting_unit) {
 }
 
 void Map::handle_on_unit_click(Game &game, Unit &acting_unit,
-                               boost::uuids::uuid unit_guid) {
-  auto &clicked_unit = unit_dict[unit_guid];
+                               EntityHandle unit_handle) {
+  auto &clicked_unit = unit_dict[unit_handle];
   if (clicked_unit.is_shop) {
-    game.ui.shop_window.show_shop(unit_guid);
+    game.ui.shop_window.show_shop(unit_handle);
     acting_unit.stop_moving(game);
-  } else if (clicked_unit.guid != acting_unit.guid &&
+  } else if (clicked_unit.handle != acting_unit.handle &&
              clicked_unit.dialogues.size() > 0) {
     // have the unit move again towards the target when the dialogue
     // is over by subtracting path idx, it will do path idx + 1 again
@@ -895,17 +975,17 @@ void Map::handle_on_unit_click(Game &game, Unit &acting_unit,
       clicked_unit.ai_walk_path_idx = 0;
     }
     auto dialogue_over =
-        clicked_unit.show_next_dialogue(game, acting_unit.guid);
+        clicked_unit.show_next_dialogue(game, acting_unit.handle);
     clicked_unit.in_dialogue = true;
     acting_unit.in_dialogue = true;
-    acting_unit.in_dialogue_with_unit_guid = unit_input.guid;
+    acting_unit.in_dialogue_with_unit_handle = unit_input.handle;
     acting_unit.stop_moving(game);
   }
 }
 
 void Map::handle_on_treasure_chest_click(
-    Game &game, Unit &acting_unit, boost::uuids::uuid treasure_chest_guid) {
-  auto &treasure_chest = treasure_chest_dict[treasure_chest_guid];
+    Game &game, Unit &acting_unit, EntityHandle treasure_chest_handle) {
+  auto &treasure_chest = treasure_chest_dict[treasure_chest_handle];
   if (!treasure_chest.is_opened) {
     treasure_chest.is_opened = true;
     for (auto &item : treasure_chest.inventory.items) {
@@ -913,9 +993,9 @@ void Map::handle_on_treasure_chest_click(
       auto item_cpy = item;
       item_cpy.guid = game.engine.get_guid();
       item_cpy.sprite.dst = treasure_chest.sprite.dst;
-      item_dict[item_cpy.guid] = item_cpy;
+      add_item(game, item_cpy);
       game.game_client.SendMessage(GameEvent::collect_item_request(
-          game, acting_unit.guid, item_cpy.guid));
+          game, acting_unit.handle, item_cpy.handle));
     }
   }
 }
@@ -929,74 +1009,221 @@ bool Map::point_in_bounds_move_grid(Vec2 &p) {
          p.y <= cols_move_grid - 1;
 }
 
-bool Map::unit_occupies_tile_point_move_grid(
-    Game &game, const Rect &tile_point_hit_box,
-    boost::uuids::uuid acting_unit_guid) {
-  for (auto &entry : unit_dict) {
-    auto &unit = entry.second;
-    // skip the unit if it has the same tile point hit box as the skip
-    // tile point hit box. This is because I am not using handles and need
-    // a way to identify units.
-    if (unit.guid == acting_unit_guid) {
+void Map::build_move_grid() {
+  occupancy_grid = OccupancyGrid(rows_move_grid, cols_move_grid);
+  for (auto &unit : unit_dict.items) {
+    occupancy_grid.add_unit(unit.handle, unit.sprite.get_tile_point_hit_box());
+  }
+  move_grid = MoveGrid(rows_move_grid, cols_move_grid);
+  for (int i = 0; i < rows; i++) {
+    for (int j = 0; j < cols; j++) {
+      auto tile_point = Vec2(i, j);
+      if (tiles[twod_to_oned_idx(tile_point, rows)].is_obstacle) {
+        move_grid.set_tile_is_obstacle(tile_point, true, false);
+      }
+    }
+  }
+  move_grid.update_all_clearances();
+  path_cluster_graphs.clear();
+}
+
+void Map::build_spatial_grids() {
+  unit_grid = SpatialGrid(rows, cols);
+  item_grid = SpatialGrid(rows, cols);
+  treasure_chest_grid = SpatialGrid(rows, cols);
+  for (auto &unit : unit_dict.items) {
+    unit_grid.update(unit.handle, unit.sprite.dst);
+  }
+  for (auto &item : item_dict.items) {
+    item_grid.update(item.handle, item.sprite.dst);
+  }
+  for (auto &treasure_chest : treasure_chest_dict.items) {
+    treasure_chest_grid.update(treasure_chest.handle,
+                               treasure_chest.get_bounding_dst());
+  }
+}
+
+// use this instead of setting Tile::is_obstacle directly so the move grid
+// stays in sync, only the clearances around the tile are recomputed.
+void Map::set_tile_is_obstacle(Vec2 tile_point, bool is_obstacle) {
+  auto &tile = tiles[twod_to_oned_idx(tile_point, rows)];
+  if (tile.is_obstacle == is_obstacle) {
+    return;
+  }
+  tile.is_obstacle = is_obstacle;
+  move_grid.set_tile_is_obstacle(tile_point, is_obstacle);
+  for (auto &path_cluster_graph : path_cluster_graphs) {
+    path_cluster_graph.mark_tile_dirty(tile_point);
+  }
+}
+
+// results from the path request service are only applied here, before the
+// units update. A unit that asked again or stopped since has a different
+// ticket and the old result is dropped.
+void Map::deliver_path_results(Game &game) {
+  game.path_request_service.take_results(path_results);
+  for (auto &result : path_results) {
+    if (!unit_dict.contains(result.unit_handle)) {
       continue;
     }
-    if (rect_contains_rect(tile_point_hit_box,
-                           unit.sprite.tile_point_hit_box)) {
-      return true;
+    auto &unit = unit_dict[result.unit_handle];
+    if (unit.path_request_ticket != result.ticket) {
+      continue;
+    }
+    unit.follow_path_result(game, result);
+  }
+}
+
+// graphs are created the first time a hitbox size needs one, their
+// clusters are built when they are first searched.
+PathClusterGraph &Map::get_path_cluster_graph(Vec2 hit_box_dims) {
+  for (auto &path_cluster_graph : path_cluster_graphs) {
+    if (path_cluster_graph.hit_box_dims == hit_box_dims) {
+      return path_cluster_graph;
     }
   }
-  return false;
+  path_cluster_graphs.push_back(
+      PathClusterGraph(rows_move_grid, cols_move_grid, hit_box_dims));
+  return path_cluster_graphs.back();
 }
 
 // if you remove while iterating through the item_dict item.update()
 // calls sprite.update() calls tween.update() which can remove the item
 // from the item_dict. This invalidates the item_dict while iterating.
 // instead add it to a vec to be removed at the end of the frame.
-void Map::remove_item_guid_at_end_of_frame(boost::uuids::uuid item_guid) {
-  item_guids_to_remove_at_end_of_frame.push_back(item_guid);
+void Map::remove_item_handle_at_end_of_frame(EntityHandle item_handle) {
+  item_handles_to_remove_at_end_of_frame.push_back(item_handle);
 }
 
-void Map::set_sorted_unit_guids() {
-  // clear previous unit guids
-  sorted_unit_guids.clear();
-
-  // put all the unit guids into the sorted unit guid vec
-  for (auto &entry : unit_dict) {
-    auto key = entry.first;
-    sorted_unit_guids.push_back(key);
+// units are drawn from the highest y down. The order is kept from the
+// previous frame and units only move a few pixels between frames, so an
+// insertion sort over the nearly sorted vec is about linear. add_unit and
+// erase_unit_handle keep the vec in sync with the unit_dict.
+void Map::sort_unit_handles() {
+  for (int i = 1; i < (int)sorted_unit_handles.size(); i++) {
+    auto unit_handle = sorted_unit_handles[i];
+    auto y = unit_dict[unit_handle].sprite.dst.y;
+    int j = i - 1;
+    while (j >= 0 && unit_dict[sorted_unit_handles[j]].sprite.dst.y < y) {
+      sorted_unit_handles[j + 1] = sorted_unit_handles[j];
+      j--;
+    }
+    sorted_unit_handles[j + 1] = unit_handle;
   }
+}
 
-  // sort the unit guids
-  sort(sorted_unit_guids.begin(), sorted_unit_guids.end(),
-       [&](boost::uuids::uuid guid1, boost::uuids::uuid guid2) -> bool {
-         auto &unit1 = unit_dict[guid1];
-         auto &unit2 = unit_dict[guid2];
-         return unit1.sprite.dst.y > unit2.sprite.dst.y;
-       });
+void Map::insert_sorted_unit_handle(EntityHandle unit_handle) {
+  if (find(sorted_unit_handles.begin(), sorted_unit_handles.end(),
+           unit_handle) != sorted_unit_handles.end()) {
+    return;
+  }
+  auto y = unit_dict[unit_handle].sprite.dst.y;
+  auto it = upper_bound(sorted_unit_handles.begin(), sorted_unit_handles.end(),
+                        y, [&](int _y, EntityHandle handle) -> bool {
+                          return _y > unit_dict[handle].sprite.dst.y;
+                        });
+  sorted_unit_handles.insert(it, unit_handle);
 }
 
 Unit &Map::get_player_unit() {
-  GAME_ASSERT(player_unit_guids.size() > 0);
-  GAME_ASSERT(unit_dict.contains(player_unit_guids[0]));
-  return unit_dict[player_unit_guids[0]];
+  GAME_ASSERT(player_unit_handles.size() > 0);
+  GAME_ASSERT(unit_dict.contains(player_unit_handles[0]));
+  return unit_dict[player_unit_handles[0]];
 }
 
-bool Map::is_guid_in_all_player_units(boost::uuids::uuid unit_guid) {
-  return find(all_player_unit_guids.begin(), all_player_unit_guids.end(),
-              unit_guid) != all_player_unit_guids.end();
+bool Map::is_handle_in_all_player_units(EntityHandle unit_handle) {
+  return find(all_player_unit_handles.begin(), all_player_unit_handles.end(),
+              unit_handle) != all_player_unit_handles.end();
 }
 
-void Map::erase_unit_guid(Game &game, boost::uuids::uuid _unit_guid) {
-  unit_dict.erase(_unit_guid);
-  // remove from sorted unit guids so that [] doesn't add
-  // an erased unit back into the unit dict
-  for (int i = sorted_unit_guids.size() - 1; i >= 0; i--) {
-    auto unit_guid = sorted_unit_guids[i];
-    if (unit_guid == _unit_guid) {
-      sorted_unit_guids.erase(sorted_unit_guids.begin() + i);
+// use this instead of inserting into the unit_dict directly so the unit is
+// given its handle and added to the occupancy grid.
+void Map::add_unit(Game &game, Unit &unit) {
+  unit.handle = game.entity_registry.get_handle(unit.guid);
+  unit_dict.insert(unit.handle, unit);
+  insert_sorted_unit_handle(unit.handle);
+  occupancy_grid.add_unit(unit.handle, unit.sprite.get_tile_point_hit_box());
+  unit_grid.update(unit.handle, unit.sprite.dst);
+}
+
+void Map::erase_unit_handle(Game &game, EntityHandle _unit_handle) {
+  unit_dict.erase(_unit_handle);
+  occupancy_grid.remove_unit(_unit_handle);
+  unit_grid.erase(_unit_handle);
+  // remove from sorted unit handles so that the erased unit isn't looked
+  // up in the unit dict
+  for (int i = sorted_unit_handles.size() - 1; i >= 0; i--) {
+    auto unit_handle = sorted_unit_handles[i];
+    if (unit_handle == _unit_handle) {
+      sorted_unit_handles.erase(sorted_unit_handles.begin() + i);
       break;
     }
   }
+  release_entity_handle(game, _unit_handle);
+}
+
+void Map::add_item(Game &game, Item &item) {
+  item.handle = game.entity_registry.get_handle(item.guid);
+  item_dict.insert(item.handle, item);
+  item_grid.update(item.handle, item.sprite.dst);
+}
+
+void Map::erase_item_handle(Game &game, EntityHandle item_handle) {
+  item_dict.erase(item_handle);
+  item_grid.erase(item_handle);
+  release_entity_handle(game, item_handle);
+}
+
+void Map::add_treasure_chest(Game &game, TreasureChest &treasure_chest) {
+  treasure_chest.handle = game.entity_registry.get_handle(treasure_chest.guid);
+  treasure_chest_dict.insert(treasure_chest.handle, treasure_chest);
+  treasure_chest_grid.update(treasure_chest.handle,
+                             treasure_chest.get_bounding_dst());
+}
+
+void Map::erase_treasure_chest_handle(Game &game,
+                                      EntityHandle treasure_chest_handle) {
+  treasure_chest_dict.erase(treasure_chest_handle);
+  treasure_chest_grid.erase(treasure_chest_handle);
+  release_entity_handle(game, treasure_chest_handle);
+}
+
+// an entity erased from the map is gone for good unless it is also in the
+// map the editor's play mode goes back to, that map still uses its handle.
+void Map::release_entity_handle(Game &game, EntityHandle handle) {
+  if (!game.entity_registry.contains(handle) ||
+      game.editor_state.saved_map_guids.contains(
+          game.entity_registry.get_guid(handle))) {
+    return;
+  }
+  game.entity_registry.release(handle);
+}
+
+// for a map that is thrown away, like play mode's copy of the map.
+void Map::release_entity_handles(Game &game) {
+  for (auto &unit : unit_dict.items) {
+    release_entity_handle(game, unit.handle);
+  }
+  for (auto &item : item_dict.items) {
+    release_entity_handle(game, item.handle);
+  }
+  for (auto &treasure_chest : treasure_chest_dict.items) {
+    release_entity_handle(game, treasure_chest.handle);
+  }
+}
+
+void Map::add_entity_guids(
+    robin_hood::unordered_flat_set<boost::uuids::uuid, BoostUUIDHash>
+        &guids) {
+  for (auto &unit : unit_dict.items) {
+    guids.insert(unit.guid);
+  }
+  for (auto &item : item_dict.items) {
+    guids.insert(item.guid);
+  }
+  for (auto &treasure_chest : treasure_chest_dict.items) {
+    guids.insert(treasure_chest.guid);
+  }
 }
 
 void Map::add_all_player_units(Game &game) {
@@ -1006,81 +1233,85 @@ void Map::add_all_player_units(Game &game) {
   // units as well.
   for (size_t i = 0; i < PLAYER_CONTROLLED_UNITS_SIZE; i++) {
     auto unit = Unit(game);
-    unit_dict[unit.guid] = unit;
-    all_player_unit_guids.push_back(unit.guid);
+    add_unit(game, unit);
+    all_player_unit_handles.push_back(unit.handle);
   }
 
-  // add first unit to player unit guids
-  auto player_guid = all_player_unit_guids.at(0);
-  auto &player = unit_dict[player_guid];
-  player_unit_guids.push_back(player_guid);
+  // add first unit to player unit handles
+  auto player_handle = all_player_unit_handles.at(0);
+  auto &player = unit_dict[player_handle];
+  player_unit_handles.push_back(player_handle);
 }
 
-// can be made more efficient later if needed, focusing on geting it
-// working for now.
-void map_transition(Game &game, string &file_path,
-                    Vec2 warp_to_map_tile_point) {
-  if (file_path.size() == 0) {
-    cout << "Map::map_transition - file path is empty. path: "
-         << file_path.c_str() << "\n";
-    abort();
-  }
+// swaps map in as the game's map, the player units are moved over from the
+// current map to warp_to_map_tile_point. map is left empty.
+void map_transition(Game &game, Map &map, Vec2 warp_to_map_tile_point) {
   // save persistent data before loading the new map
-  auto player_unit_guids = game.map.player_unit_guids;
-  auto all_player_unit_guids = game.map.all_player_unit_guids;
+  auto player_unit_handles = game.map.player_unit_handles;
+  auto all_player_unit_handles = game.map.all_player_unit_handles;
   auto player_controlled_units = vector<Unit>();
-  for (auto &player_unit_guid : game.map.all_player_unit_guids) {
-    auto &player_unit = game.map.unit_dict[player_unit_guid];
+  for (auto &player_unit_handle : game.map.all_player_unit_handles) {
+    auto &player_unit = game.map.unit_dict[player_unit_handle];
     // clear any move tweens as we are moving them into the new map
     player_unit.stop_moving(game);
     player_unit.is_moving = false;
     player_unit.in_dialogue = false;
-    player_unit.set_tile_point(warp_to_map_tile_point);
+    player_unit.set_tile_point(game, warp_to_map_tile_point);
     player_controlled_units.push_back(player_unit);
   }
-  // get the new map
-  game.map = map_deserialize_from_file(game, file_path.c_str());
+  // swap in the new map
+  game.map = move(map);
+  map = Map();
   // add persistent data to the new map
-  game.map.player_unit_guids = player_unit_guids;
-  game.map.all_player_unit_guids = all_player_unit_guids;
+  game.map.player_unit_handles = player_unit_handles;
+  game.map.all_player_unit_handles = all_player_unit_handles;
   for (auto &player_unit : player_controlled_units) {
-    game.map.unit_dict[player_unit.guid] = player_unit;
+    game.map.add_unit(game, player_unit);
   }
 }
 
 void map_serialize(Game &game, Map &map, bool is_save_file) {
+  // tile and layer sprites are written as ids into the palette, it comes
+  // before the tiles so it can be read first.
+  auto palette = SpritePalette();
+  for (auto &tile : map.tiles) {
+    palette.add(tile.sprite);
+  }
+  for (auto &layer : map.layers) {
+    for (auto &sprite : layer.sprites) {
+      palette.add(sprite);
+    }
+  }
   game.serializer.writer.StartObject();
   game.serializer.serialize_int("rows", map.rows);
   game.serializer.serialize_int("cols", map.cols);
+  game.serializer.writer.String("sprite_palette");
+  sprite_palette_serialize(game, palette);
   game.serializer.writer.String("tiles");
   game.serializer.writer.StartArray();
   for (auto &tile : map.tiles) {
-    tile_serialize(game, tile);
+    tile_serialize(game, tile, &palette);
   }
   game.serializer.writer.EndArray();
   for (int i = 0; i < MAX_LAYERS; i++) {
     auto layer_key = "layer_" + to_string(i);
     game.serializer.writer.String(layer_key.c_str());
-    game.serializer.writer.StartArray();
-    for (auto &sprite : map.layers[0]) {
-      sprite_serialize(game, sprite);
-    }
-    game.serializer.writer.EndArray();
+    map_layer_serialize(game, map.layers[i], &palette);
   }
   if (is_save_file) {
     game.serializer.writer.String("all_player_unit_guids");
     game.serializer.writer.StartArray();
-    for (auto &player_unit_guid : map.all_player_unit_guids) {
-      game.serializer.writer.String(to_string(player_unit_guid).c_str());
+    for (auto &player_unit_handle : map.all_player_unit_handles) {
+      auto guid = game.entity_registry.get_guid(player_unit_handle);
+      game.serializer.writer.String(to_string(guid).c_str());
     }
     game.serializer.writer.EndArray();
   }
   game.serializer.writer.String("units");
   game.serializer.writer.StartArray();
-  for (auto &entry : map.unit_dict) {
-    auto &unit = entry.second;
-    if (!is_save_file && map.is_guid_in_all_player_units(unit.guid)) {
-      // skip serialization of this unit as its guid is a player guid
+  for (auto &unit : map.unit_dict.items) {
+    if (!is_save_file && map.is_handle_in_all_player_units(unit.handle)) {
+      // skip serialization of this unit as it is a player unit
       continue;
     }
     unit_serialize(game, unit);
@@ -1088,15 +1319,13 @@ void map_serialize(Game &game, Map &map, bool is_save_file) {
   game.serializer.writer.EndArray();
   game.serializer.writer.String("treasure_chests");
   game.serializer.writer.StartArray();
-  for (auto &entry : map.treasure_chest_dict) {
-    auto &treasure_chest = entry.second;
+  for (auto &treasure_chest : map.treasure_chest_dict.items) {
     treasure_chest_serialize(game, treasure_chest);
   }
   game.serializer.writer.EndArray();
   game.serializer.writer.String("items");
   game.serializer.writer.StartArray();
-  for (auto &entry : map.item_dict) {
-    auto &item = entry.second;
+  for (auto &item : map.item_dict.items) {
     item_serialize(game, item);
   }
   game.serializer.writer.EndArray();
@@ -1104,30 +1333,43 @@ void map_serialize(Game &game, Map &map, bool is_save_file) {
   // cout << "output " << game.serializer.sb.GetString() << "\n";
 }
 
-Map map_deserialize(Game &game, GenericObject<false, Value> &obj,
-                    bool is_save_file) {
-  Map map = Map(game);
+// the tiles and layers, most of a map file. Only reads static game data
+// (the images) so the MapLoader runs it on its thread.
+void map_deserialize_tiles(Game &game, GenericObject<false, Value> &obj,
+                           Map &map) {
   map.rows = obj["rows"].GetInt();
   map.cols = obj["cols"].GetInt();
   map.rows_move_grid = map.rows * MOVE_GRID_RATIO;
   map.cols_move_grid = map.cols * MOVE_GRID_RATIO;
+  // maps written before the palette have whole sprites
+  auto palette = SpritePalette();
+  if (obj.HasMember("sprite_palette")) {
+    auto palette_array = obj["sprite_palette"].GetArray();
+    palette = sprite_palette_deserialize(game, palette_array);
+  }
   auto tiles_array = obj["tiles"].GetArray();
   auto idx = 0;
   for (auto &tile_obj : tiles_array) {
     auto obj = tile_obj.GetObject();
-    map.tiles.push_back(tile_deserialize(game, obj));
+    map.tiles.push_back(tile_deserialize(game, obj, &palette));
     idx += 1;
   }
+  map.build_move_grid();
+  map.build_spatial_grids();
   for (int i = 0; i < MAX_LAYERS; i++) {
     auto layer_key = "layer_" + to_string(i);
     auto layers_array = obj[layer_key.c_str()].GetArray();
-    auto idx = 0;
-    for (auto &sprite_obj : layers_array) {
-      auto obj = sprite_obj.GetObject();
-      map.layers[i].push_back(sprite_deserialize(game, obj));
-      idx += 1;
-    }
+    map.layers[i] = map_layer_deserialize(game, layers_array,
+                                          map.rows * map.cols, &palette);
   }
+  map.set_max_sprite_dims();
+  map.build_chunk_versions();
+}
+
+// the units, treasure chests and items. They are given handles and new
+// units use the guid generator, so this runs on the game thread.
+void map_deserialize_entities(Game &game, GenericObject<false, Value> &obj,
+                              Map &map, bool is_save_file) {
   // save file expects all_player_guids to be present
   if (is_save_file) {
     if (!obj.HasMember("all_player_unit_guids")) {
@@ -1135,33 +1377,41 @@ Map map_deserialize(Game &game, GenericObject<false, Value> &obj,
               "all_player_unit_guids.\n";
       abort();
     }
-    // clear previous default unit guids placed in by maps constructor
+    // clear previous default unit handles placed in by maps constructor
     // as we are about to add the ones from the save file
-    map.all_player_unit_guids.clear();
+    map.all_player_unit_handles.clear();
     auto all_player_unit_guids_array = obj["all_player_unit_guids"].GetArray();
     for (auto &player_unit_guid_obj : all_player_unit_guids_array) {
       auto guid = game.engine.string_gen(player_unit_guid_obj.GetString());
-      map.all_player_unit_guids.push_back(guid);
+      map.all_player_unit_handles.push_back(
+          game.entity_registry.get_handle(guid));
     }
   }
   auto units_array = obj["units"].GetArray();
   for (auto &unit_obj : units_array) {
     auto obj = unit_obj.GetObject();
     auto unit = unit_deserialize(game, obj);
-    map.unit_dict[unit.guid] = unit;
+    map.add_unit(game, unit);
   }
   auto treasure_chests_array = obj["treasure_chests"].GetArray();
   for (auto &treasure_chest_obj : treasure_chests_array) {
     auto obj = treasure_chest_obj.GetObject();
     auto treasure_chest = treasure_chest_deserialize(game, obj);
-    map.treasure_chest_dict[treasure_chest.guid] = treasure_chest;
+    map.add_treasure_chest(game, treasure_chest);
   }
   auto items_array = obj["items"].GetArray();
   for (auto &item_obj : items_array) {
     auto obj = item_obj.GetObject();
     auto item = item_deserialize(game, obj);
-    map.item_dict[item.guid] = item;
+    map.add_item(game, item);
   }
+}
+
+Map map_deserialize(Game &game, GenericObject<false, Value> &obj,
+                    bool is_save_file) {
+  Map map = Map(game);
+  map_deserialize_tiles(game, obj, map);
+  map_deserialize_entities(game, obj, map, is_save_file);
   return map;
 }
 
@@ -1180,24 +1430,164 @@ void map_serialize_into_file(Game &game, Map &map, const char *file_path,
   file.close();
 }
 
+// the sprite of a MapFileSprite record, the same as sprite_deserialize
+// makes.
+static Sprite map_file_sprite_to_sprite(Game &game, MapFileSprite &record,
+                                        vector<MapFileSrc> &srcs,
+                                        Image &last_image) {
+  auto sprite = Sprite();
+  auto image_name = (ImageName)record.image_name;
+  if (image_name != ImageName::None) {
+    // most neighbouring sprites use the same image
+    if (last_image.image_name != image_name) {
+      last_image = game.engine.get_image(image_name);
+    }
+    sprite.image = last_image;
+  }
+  sprite.dst = Rect(record.dst_x, record.dst_y, record.dst_w, record.dst_h);
+  sprite.anim_speed = record.anim_speed;
+  if ((size_t)record.first_src + record.num_srcs > srcs.size()) {
+    cout << "map_file_sprite_to_sprite. Src run out of range.\n";
+    abort();
+  }
+  sprite.srcs.reserve(record.num_srcs);
+  for (uint32_t i = 0; i < record.num_srcs; i++) {
+    auto &src = srcs[record.first_src + i];
+    sprite.srcs.push_back(SpriteSrc(
+        ImageLocation(sprite.image, Rect(src.x, src.y, src.w, src.h))));
+  }
+  return sprite;
+}
+
+// the binary version of map_deserialize_tiles, also safe off the game
+// thread. The records are copied out of the file in bulk.
+void map_deserialize_tiles_binary(Game &game, MapFileView &view, Map &map) {
+  if (view.header.num_layers > MAX_LAYERS) {
+    cout << "map_deserialize_tiles_binary. Too many layers "
+         << view.header.num_layers << "\n";
+    abort();
+  }
+  map.rows = view.header.rows;
+  map.cols = view.header.cols;
+  map.rows_move_grid = map.rows * MOVE_GRID_RATIO;
+  map.cols_move_grid = map.cols * MOVE_GRID_RATIO;
+  auto srcs = vector<MapFileSrc>(view.header.num_srcs);
+  memcpy(srcs.data(), view.srcs, srcs.size() * sizeof(MapFileSrc));
+  auto tile_records = vector<MapFileTile>(map.rows * map.cols);
+  memcpy(tile_records.data(), view.tiles,
+         tile_records.size() * sizeof(MapFileTile));
+  auto last_image = Image();
+  map.tiles = vector<Tile>(tile_records.size());
+  for (size_t i = 0; i < tile_records.size(); i++) {
+    auto &record = tile_records[i];
+    auto &tile = map.tiles[i];
+    tile.sprite =
+        map_file_sprite_to_sprite(game, record.sprite, srcs, last_image);
+    tile.is_obstacle = record.is_obstacle;
+    tile.is_warp_point = record.is_warp_point;
+    tile.warps_to_tile_point =
+        Vec2(record.warps_to_tile_point_x, record.warps_to_tile_point_y);
+    tile.warps_to_map_file_path =
+        view.get_string(record.warps_to_map_file_path);
+  }
+  map.build_move_grid();
+  map.build_spatial_grids();
+  auto layer_records = vector<MapFileLayerSprite>();
+  for (int i = 0; i < MAX_LAYERS; i++) {
+    map.layers[i] = MapLayer(map.rows * map.cols);
+    if (i >= (int)view.layers.size()) {
+      continue;
+    }
+    layer_records.resize(view.layer_num_sprites[i]);
+    memcpy(layer_records.data(), view.layers[i],
+           layer_records.size() * sizeof(MapFileLayerSprite));
+    for (auto &record : layer_records) {
+      map.layers[i].add_sprite(
+          record.tile_idx,
+          map_file_sprite_to_sprite(game, record.sprite, srcs, last_image));
+    }
+  }
+  map.set_max_sprite_dims();
+  map.build_chunk_versions();
+}
+
+// the binary version of map_deserialize_entities, the entities are json in
+// the file.
+void map_deserialize_entities_binary(Game &game, MapFileView &view,
+                                     Map &map) {
+  Document doc;
+  for (auto &entity : view.units) {
+    doc.Parse(entity.json, entity.num_bytes);
+    auto obj = doc.GetObject();
+    auto unit = unit_deserialize(game, obj);
+    map.add_unit(game, unit);
+  }
+  for (auto &entity : view.treasure_chests) {
+    doc.Parse(entity.json, entity.num_bytes);
+    auto obj = doc.GetObject();
+    auto treasure_chest = treasure_chest_deserialize(game, obj);
+    map.add_treasure_chest(game, treasure_chest);
+  }
+  for (auto &entity : view.items) {
+    doc.Parse(entity.json, entity.num_bytes);
+    auto obj = doc.GetObject();
+    auto item = item_deserialize(game, obj);
+    map.add_item(game, item);
+  }
+}
+
+Map map_deserialize_from_binary_file(Game &game, const char *file_path) {
+  if (!is_little_endian_host()) {
+    cout << "map_deserialize_from_binary_file. Only little endian hosts can "
+            "read binary maps.\n";
+    abort();
+  }
+  auto file = MappedFile();
+  if (!file.open(file_path)) {
+    cout << "map_deserialize_from_binary_file. File error " << file_path
+         << "\n";
+    abort();
+  }
+  auto view = MapFileView();
+  if (!view.init(file.data, file.num_bytes)) {
+    cout << "map_deserialize_from_binary_file. Not a version "
+         << MAP_FILE_VERSION << " map file " << file_path << "\n";
+    abort();
+  }
+  Map map = Map(game);
+  map_deserialize_tiles_binary(game, view, map);
+  map_deserialize_entities_binary(game, view, map);
+  return map;
+}
+
+// goes through the json map_serialize writes so the two formats can't
+// drift apart.
+void map_serialize_into_binary_file(Game &game, Map &map,
+                                    const char *file_path) {
+  game.serializer.clear();
+  map_serialize(game, map);
+  Document doc;
+  doc.Parse(game.serializer.sb.GetString(), game.serializer.sb.GetSize());
+  auto obj = doc.GetObject();
+  map_file_write_from_json(obj, file_path);
+}
+
+// reads the file in one go and builds the map as it is parsed with a
+// MapReader, rather than parsing the whole file into a document first.
 Map map_deserialize_from_file(Game &game, const char *file_path,
                               bool is_save_file) {
-  ifstream file(file_path);
+  ifstream file(file_path, ios::binary | ios::ate);
   if (!file.good()) {
     cout << "map_deserialize_from_file. File error " << file_path << "\n";
     abort();
   }
-  stringstream buffer;
-  buffer.clear();
-  buffer << file.rdbuf();
-  // cout << "buff " << buffer.str().c_str() << "\n";
-  // clear as this is for individual units, not part of a nested struct (like
-  // map)
-  game.serializer.clear();
-  // parse
-  game.serializer.doc.Parse(buffer.str().c_str());
-  // unit object
-  auto obj = game.serializer.doc.GetObject();
-  // deserialize unit_obj into a Unit
-  return map_deserialize(game, obj, is_save_file);
+  auto size = (size_t)file.tellg();
+  file.seekg(0);
+  auto buffer = vector<char>(size);
+  file.read(buffer.data(), size);
+  Map map = Map(game);
+  auto reader = MapReader();
+  reader.read(game, buffer.data(), buffer.size(), map);
+  reader.read_entities(game, map, is_save_file);
+  return map;
 }
\ No newline at end of file
@@ -0,0 +1,404 @@
+#include "map_file.h"
+#include "rapidjson/stringbuffer.h"
+#include "rapidjson/writer.h"
+#include "robin_hood.h"
+#include <fstream>
+#include <iostream>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// reads a uint32 at data + offset if it fits in num_bytes, moving offset
+// past it.
+static bool read_uint32(const char *data, size_t num_bytes, size_t &offset,
+                        uint32_t &value) {
+  if (offset + sizeof(uint32_t) > num_bytes) {
+    return false;
+  }
+  memcpy(&value, data + offset, sizeof(uint32_t));
+  offset += sizeof(uint32_t);
+  return true;
+}
+
+// moves offset past count records of record_size bytes if they fit.
+static bool skip_records(size_t num_bytes, size_t &offset, size_t count,
+                         size_t record_size) {
+  if (count > (num_bytes - offset) / record_size) {
+    return false;
+  }
+  offset += count * record_size;
+  return true;
+}
+
+static bool read_entities(const char *data, size_t num_bytes, size_t &offset,
+                          vector<MapFileEntity> &entities) {
+  uint32_t count = 0;
+  if (!read_uint32(data, num_bytes, offset, count)) {
+    return false;
+  }
+  entities.clear();
+  for (uint32_t i = 0; i < count; i++) {
+    auto entity = MapFileEntity();
+    if (!read_uint32(data, num_bytes, offset, entity.num_bytes) ||
+        entity.num_bytes > num_bytes - offset) {
+      return false;
+    }
+    entity.json = data + offset;
+    offset += entity.num_bytes;
+    entities.push_back(entity);
+  }
+  return true;
+}
+
+// false if data isn't a whole map file of this version.
+bool MapFileView::init(const char *data, size_t num_bytes) {
+  if (num_bytes < sizeof(MapFileHeader)) {
+    return false;
+  }
+  memcpy(&header, data, sizeof(MapFileHeader));
+  if (memcmp(header.magic, MAP_FILE_MAGIC, 4) != 0 ||
+      header.version != MAP_FILE_VERSION || header.rows < 0 ||
+      header.cols < 0) {
+    return false;
+  }
+  size_t offset = sizeof(MapFileHeader);
+  srcs = data + offset;
+  if (!skip_records(num_bytes, offset, header.num_srcs, sizeof(MapFileSrc))) {
+    return false;
+  }
+  strings = data + offset;
+  if (header.strings_num_bytes % 4 != 0 ||
+      !skip_records(num_bytes, offset, header.strings_num_bytes, 1)) {
+    return false;
+  }
+  tiles = data + offset;
+  if (!skip_records(num_bytes, offset, (size_t)header.rows * header.cols,
+                    sizeof(MapFileTile))) {
+    return false;
+  }
+  layers.clear();
+  layer_num_sprites.clear();
+  for (uint32_t i = 0; i < header.num_layers; i++) {
+    uint32_t count = 0;
+    if (!read_uint32(data, num_bytes, offset, count)) {
+      return false;
+    }
+    layers.push_back(data + offset);
+    layer_num_sprites.push_back(count);
+    if (!skip_records(num_bytes, offset, count, sizeof(MapFileLayerSprite))) {
+      return false;
+    }
+  }
+  return read_entities(data, num_bytes, offset, units) &&
+         read_entities(data, num_bytes, offset, treasure_chests) &&
+         read_entities(data, num_bytes, offset, items);
+}
+
+string MapFileView::get_string(int32_t offset) {
+  if (offset == MAP_FILE_NO_STRING || offset < 0 ||
+      (uint32_t)offset >= header.strings_num_bytes) {
+    return "";
+  }
+  return string(strings + offset);
+}
+
+MappedFile::~MappedFile() { close(); }
+
+bool MappedFile::open(const char *file_path) {
+  close();
+#ifdef _WIN32
+  file_handle = CreateFileA(file_path, GENERIC_READ, FILE_SHARE_READ, nullptr,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file_handle == INVALID_HANDLE_VALUE) {
+    file_handle = nullptr;
+    return false;
+  }
+  LARGE_INTEGER file_size;
+  if (!GetFileSizeEx(file_handle, &file_size)) {
+    close();
+    return false;
+  }
+  num_bytes = (size_t)file_size.QuadPart;
+  if (num_bytes == 0) {
+    return true;
+  }
+  mapping_handle =
+      CreateFileMappingA(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (mapping_handle == nullptr) {
+    close();
+    return false;
+  }
+  data = (const char *)MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+#else
+  fd = ::open(file_path, O_RDONLY);
+  if (fd == -1) {
+    return false;
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0) {
+    close();
+    return false;
+  }
+  num_bytes = file_stat.st_size;
+  if (num_bytes == 0) {
+    return true;
+  }
+  auto mapped = mmap(nullptr, num_bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+  data = mapped == MAP_FAILED ? nullptr : (const char *)mapped;
+#endif
+  if (data == nullptr) {
+    close();
+    return false;
+  }
+  return true;
+}
+
+void MappedFile::close() {
+#ifdef _WIN32
+  if (data != nullptr) {
+    UnmapViewOfFile(data);
+  }
+  if (mapping_handle != nullptr) {
+    CloseHandle(mapping_handle);
+  }
+  if (file_handle != nullptr) {
+    CloseHandle(file_handle);
+  }
+  mapping_handle = nullptr;
+  file_handle = nullptr;
+#else
+  if (data != nullptr) {
+    munmap((void *)data, num_bytes);
+  }
+  if (fd != -1) {
+    ::close(fd);
+  }
+  fd = -1;
+#endif
+  data = nullptr;
+  num_bytes = 0;
+}
+
+bool is_little_endian_host() {
+  uint32_t value = 1;
+  uint8_t first_byte = 0;
+  memcpy(&first_byte, &value, 1);
+  return first_byte == 1;
+}
+
+// map.json -> map.lmap, the binary map sits next to the json one.
+string get_binary_map_file_path(const string &json_file_path) {
+  auto ext_idx = json_file_path.rfind(".json");
+  if (ext_idx == string::npos ||
+      ext_idx + strlen(".json") != json_file_path.size()) {
+    return json_file_path + MAP_FILE_EXTENSION;
+  }
+  return json_file_path.substr(0, ext_idx) + MAP_FILE_EXTENSION;
+}
+
+template <class T> static void append_record(vector<char> &bytes, T &record) {
+  auto ptr = (const char *)&record;
+  bytes.insert(bytes.end(), ptr, ptr + sizeof(T));
+}
+
+static void append_uint32(vector<char> &bytes, uint32_t value) {
+  append_record(bytes, value);
+}
+
+// collects the srcs and strings of the records, runs of srcs and strings
+// that were already added are shared.
+struct MapFileBuilder {
+  // the map's sprite_palette, null for maps written before it
+  Value *palette = nullptr;
+  vector<MapFileSrc> srcs = vector<MapFileSrc>();
+  robin_hood::unordered_flat_map<string, uint32_t> src_runs =
+      robin_hood::unordered_flat_map<string, uint32_t>();
+  vector<char> strings = vector<char>();
+  robin_hood::unordered_flat_map<string, int32_t> string_offsets =
+      robin_hood::unordered_flat_map<string, int32_t>();
+  MapFileSprite add_sprite(GenericObject<false, Value> &sprite_obj);
+  void add_sprite_image(MapFileSprite &sprite,
+                        GenericObject<false, Value> &image_obj);
+  int32_t add_string(const string &str);
+};
+
+MapFileSprite
+MapFileBuilder::add_sprite(GenericObject<false, Value> &sprite_obj) {
+  auto sprite = MapFileSprite();
+  auto dst_obj = sprite_obj["dst"].GetObject();
+  sprite.dst_x = dst_obj["x"].GetInt();
+  sprite.dst_y = dst_obj["y"].GetInt();
+  sprite.dst_w = dst_obj["w"].GetInt();
+  sprite.dst_h = dst_obj["h"].GetInt();
+  if (!sprite_obj.HasMember("palette_idx")) {
+    add_sprite_image(sprite, sprite_obj);
+    return sprite;
+  }
+  auto palette_idx = sprite_obj["palette_idx"].GetInt();
+  if (palette == nullptr || palette_idx < 0 ||
+      palette_idx >= (int)palette->Size()) {
+    cout << "MapFileBuilder::add_sprite. Palette idx out of range "
+         << palette_idx << "\n";
+    abort();
+  }
+  auto image_obj = (*palette)[palette_idx].GetObject();
+  add_sprite_image(sprite, image_obj);
+  return sprite;
+}
+
+// the image, anim speed and srcs, from the sprite or its palette entry.
+void MapFileBuilder::add_sprite_image(MapFileSprite &sprite,
+                                      GenericObject<false, Value> &image_obj) {
+  sprite.image_name = image_obj["image_name"].GetInt();
+  sprite.anim_speed = image_obj["anim_speed"].GetInt();
+  auto run = vector<MapFileSrc>();
+  for (auto &rect : image_obj["srcs"].GetArray()) {
+    auto src = MapFileSrc();
+    src.x = rect["x"].GetInt();
+    src.y = rect["y"].GetInt();
+    src.w = rect["w"].GetInt();
+    src.h = rect["h"].GetInt();
+    run.push_back(src);
+  }
+  sprite.num_srcs = run.size();
+  auto key = string((const char *)run.data(), run.size() * sizeof(MapFileSrc));
+  auto it = src_runs.find(key);
+  if (it != src_runs.end()) {
+    sprite.first_src = it->second;
+  } else {
+    sprite.first_src = srcs.size();
+    srcs.insert(srcs.end(), run.begin(), run.end());
+    src_runs[key] = sprite.first_src;
+  }
+}
+
+int32_t MapFileBuilder::add_string(const string &str) {
+  auto it = string_offsets.find(str);
+  if (it != string_offsets.end()) {
+    return it->second;
+  }
+  auto offset = (int32_t)strings.size();
+  strings.insert(strings.end(), str.begin(), str.end());
+  strings.push_back('\0');
+  string_offsets[str] = offset;
+  return offset;
+}
+
+static void append_entities(vector<char> &bytes, Value &array) {
+  append_uint32(bytes, array.Size());
+  for (auto &entity : array.GetArray()) {
+    StringBuffer sb;
+    Writer<StringBuffer> writer(sb);
+    entity.Accept(writer);
+    append_uint32(bytes, sb.GetSize());
+    bytes.insert(bytes.end(), sb.GetString(), sb.GetString() + sb.GetSize());
+  }
+}
+
+void map_file_write_from_json(GenericObject<false, Value> &obj,
+                              const char *file_path) {
+  if (!is_little_endian_host()) {
+    cout << "map_file_write_from_json. Only little endian hosts can write "
+            "binary maps.\n";
+    abort();
+  }
+  auto builder = MapFileBuilder();
+  auto header = MapFileHeader();
+  memcpy(header.magic, MAP_FILE_MAGIC, 4);
+  header.version = MAP_FILE_VERSION;
+  header.rows = obj["rows"].GetInt();
+  header.cols = obj["cols"].GetInt();
+  header.reserved = 0;
+  if (obj.HasMember("sprite_palette")) {
+    builder.palette = &obj["sprite_palette"];
+  }
+
+  auto tiles = vector<MapFileTile>();
+  for (auto &tile_value : obj["tiles"].GetArray()) {
+    auto tile_obj = tile_value.GetObject();
+    auto tile = MapFileTile();
+    auto sprite_obj = tile_obj["sprite"].GetObject();
+    tile.sprite = builder.add_sprite(sprite_obj);
+    auto warps_to_obj = tile_obj["warps_to_tile_point"].GetObject();
+    tile.warps_to_tile_point_x = warps_to_obj["x"].GetInt();
+    tile.warps_to_tile_point_y = warps_to_obj["y"].GetInt();
+    tile.warps_to_map_file_path = MAP_FILE_NO_STRING;
+    if (tile_obj.HasMember("warps_to_map_file_path")) {
+      tile.warps_to_map_file_path =
+          builder.add_string(tile_obj["warps_to_map_file_path"].GetString());
+    }
+    tile.is_obstacle = tile_obj["is_obstacle"].GetBool();
+    tile.is_warp_point = tile_obj["is_warp_point"].GetBool();
+    tile.padding[0] = 0;
+    tile.padding[1] = 0;
+    tiles.push_back(tile);
+  }
+  if ((int)tiles.size() != header.rows * header.cols) {
+    cout << "map_file_write_from_json. Expected " << header.rows * header.cols
+         << " tiles, got " << tiles.size() << "\n";
+    abort();
+  }
+
+  auto layers = vector<vector<MapFileLayerSprite>>();
+  for (int i = 0; obj.HasMember(("layer_" + to_string(i)).c_str()); i++) {
+    auto layer_key = "layer_" + to_string(i);
+    auto layer = vector<MapFileLayerSprite>();
+    auto idx = 0;
+    for (auto &value : obj[layer_key.c_str()].GetArray()) {
+      auto layer_obj = value.GetObject();
+      auto layer_sprite = MapFileLayerSprite();
+      if (layer_obj.HasMember("tile_idx")) {
+        auto sprite_obj = layer_obj["sprite"].GetObject();
+        layer_sprite.tile_idx = layer_obj["tile_idx"].GetInt();
+        layer_sprite.sprite = builder.add_sprite(sprite_obj);
+        layer.push_back(layer_sprite);
+      } else if (layer_obj["srcs"].Size() > 0) {
+        // older files have a sprite for every tile, most of them empty
+        layer_sprite.tile_idx = idx;
+        layer_sprite.sprite = builder.add_sprite(layer_obj);
+        layer.push_back(layer_sprite);
+      }
+      idx += 1;
+    }
+    layers.push_back(layer);
+  }
+  while (builder.strings.size() % 4 != 0) {
+    builder.strings.push_back('\0');
+  }
+  header.num_srcs = builder.srcs.size();
+  header.strings_num_bytes = builder.strings.size();
+  header.num_layers = layers.size();
+
+  auto bytes = vector<char>();
+  append_record(bytes, header);
+  for (auto &src : builder.srcs) {
+    append_record(bytes, src);
+  }
+  bytes.insert(bytes.end(), builder.strings.begin(), builder.strings.end());
+  for (auto &tile : tiles) {
+    append_record(bytes, tile);
+  }
+  for (auto &layer : layers) {
+    append_uint32(bytes, layer.size());
+    for (auto &layer_sprite : layer) {
+      append_record(bytes, layer_sprite);
+    }
+  }
+  append_entities(bytes, obj["units"]);
+  append_entities(bytes, obj["treasure_chests"]);
+  append_entities(bytes, obj["items"]);
+
+  ofstream file(file_path, ios::binary);
+  if (!file.good()) {
+    cout << "map_file_write_from_json. File error " << file_path << "\n";
+    abort();
+  }
+  file.write(bytes.data(), bytes.size());
+  file.close();
+}
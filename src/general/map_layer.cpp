@@ -0,0 +1,83 @@
+#include "map_layer.h"
+#include "game.h"
+
+MapLayer::MapLayer(int num_tiles) {
+  sprite_idxs = vector<int>(num_tiles, MAP_LAYER_EMPTY);
+  sprites = vector<Sprite>();
+  tile_idxs = vector<int>();
+}
+
+// nullptr if the tile has no sprite on this layer.
+Sprite *MapLayer::get_sprite(int tile_idx) {
+  auto sprite_idx = sprite_idxs[tile_idx];
+  if (sprite_idx == MAP_LAYER_EMPTY) {
+    return nullptr;
+  }
+  return &sprites[sprite_idx];
+}
+
+// replaces the tile's sprite if it already has one.
+Sprite &MapLayer::add_sprite(int tile_idx, Sprite sprite) {
+  auto sprite_idx = sprite_idxs[tile_idx];
+  if (sprite_idx != MAP_LAYER_EMPTY) {
+    sprites[sprite_idx] = sprite;
+    return sprites[sprite_idx];
+  }
+  sprite_idxs[tile_idx] = (int)sprites.size();
+  sprites.push_back(sprite);
+  tile_idxs.push_back(tile_idx);
+  return sprites.back();
+}
+
+// the last sprite is moved into the removed one's place.
+void MapLayer::remove_sprite(int tile_idx) {
+  auto sprite_idx = sprite_idxs[tile_idx];
+  if (sprite_idx == MAP_LAYER_EMPTY) {
+    return;
+  }
+  auto last_idx = (int)sprites.size() - 1;
+  if (sprite_idx != last_idx) {
+    sprites[sprite_idx] = sprites[last_idx];
+    tile_idxs[sprite_idx] = tile_idxs[last_idx];
+    sprite_idxs[tile_idxs[sprite_idx]] = sprite_idx;
+  }
+  sprites.pop_back();
+  tile_idxs.pop_back();
+  sprite_idxs[tile_idx] = MAP_LAYER_EMPTY;
+}
+
+// only the tiles with a sprite are written, each with its tile idx.
+void map_layer_serialize(Game &game, MapLayer &map_layer,
+                         SpritePalette *palette) {
+  game.serializer.writer.StartArray();
+  for (size_t i = 0; i < map_layer.sprites.size(); i++) {
+    game.serializer.writer.StartObject();
+    game.serializer.serialize_int("tile_idx", map_layer.tile_idxs[i]);
+    game.serializer.writer.String("sprite");
+    sprite_serialize(game, map_layer.sprites[i], palette);
+    game.serializer.writer.EndObject();
+  }
+  game.serializer.writer.EndArray();
+}
+
+MapLayer map_layer_deserialize(Game &game, GenericArray<false, Value> &array,
+                               int num_tiles, SpritePalette *palette) {
+  auto map_layer = MapLayer(num_tiles);
+  auto idx = 0;
+  for (auto &value : array) {
+    auto obj = value.GetObject();
+    if (obj.HasMember("tile_idx")) {
+      auto sprite_obj = obj["sprite"].GetObject();
+      map_layer.add_sprite(obj["tile_idx"].GetInt(),
+                           sprite_deserialize(game, sprite_obj, palette));
+    } else {
+      // older files have a sprite for every tile, most of them empty
+      auto sprite = sprite_deserialize(game, obj, palette);
+      if (sprite.srcs.size() > 0) {
+        map_layer.add_sprite(idx, sprite);
+      }
+    }
+    idx += 1;
+  }
+  return map_layer;
+}
@@ -0,0 +1,283 @@
+#include "map_loader.h"
+#include "game.h"
+#include <fstream>
+
+MapLoader::~MapLoader() { stop(); }
+
+void MapLoader::start(Game &game) {
+  if (worker.joinable()) {
+    return;
+  }
+  is_stopping = false;
+  worker = thread(&MapLoader::run_worker, this, ref(game));
+}
+
+// jobs that haven't been picked up are dropped along with the cache.
+void MapLoader::stop() {
+  {
+    lock_guard<mutex> lock(jobs_mutex);
+    is_stopping = true;
+  }
+  jobs_cv.notify_all();
+  if (worker.joinable()) {
+    worker.join();
+  }
+  jobs.clear();
+  cache.clear();
+  cache_num_bytes = 0;
+  is_transitioning = false;
+}
+
+// requests while a map is loading are ignored, the player is already on
+// their way to the first one. If the loader isn't started the map is loaded
+// right away.
+void MapLoader::load(Game &game, string &file_path,
+                     Vec2 _warp_to_map_tile_point) {
+  if (file_path.size() == 0) {
+    cout << "MapLoader::load - file path is empty. path: " << file_path.c_str()
+         << "\n";
+    abort();
+  }
+  if (is_transitioning) {
+    return;
+  }
+  {
+    lock_guard<mutex> lock(jobs_mutex);
+    is_transitioning = true;
+    transition_file_path = file_path;
+    warp_to_map_tile_point = _warp_to_map_tile_point;
+    if (find_entry(file_path) != nullptr || loading_file_path == file_path) {
+      return;
+    }
+    if (worker.joinable()) {
+      auto it = find(jobs.begin(), jobs.end(), file_path);
+      if (it != jobs.end()) {
+        jobs.erase(it);
+      }
+      jobs.push_front(file_path);
+    }
+  }
+  if (worker.joinable()) {
+    jobs_cv.notify_one();
+  } else {
+    add_entry(load_entry(game, file_path));
+  }
+}
+
+// loads the map in the background if it isn't cached or loading already.
+// Does nothing if the loader isn't started.
+void MapLoader::prefetch(string &file_path) {
+  if (!worker.joinable()) {
+    return;
+  }
+  {
+    lock_guard<mutex> lock(jobs_mutex);
+    if (find_entry(file_path) != nullptr || is_queued(file_path)) {
+      return;
+    }
+    jobs.push_back(file_path);
+  }
+  jobs_cv.notify_one();
+}
+
+// prefetches the maps of the warp points around the player's unit, only
+// looked for when the unit is on a new tile.
+void MapLoader::prefetch_near_player(Game &game) {
+  if (is_transitioning || game.map.player_unit_handles.size() == 0 ||
+      !game.map.unit_dict.contains(game.map.player_unit_handles[0])) {
+    return;
+  }
+  auto tile_point = game.map.get_player_unit().get_tile_point();
+  if (tile_point == prefetch_tile_point) {
+    return;
+  }
+  prefetch_tile_point = tile_point;
+  auto r = MAP_PREFETCH_TILE_RADIUS;
+  for (int x = max(0, tile_point.x - r);
+       x <= min(game.map.rows - 1, tile_point.x + r); x++) {
+    for (int y = max(0, tile_point.y - r);
+         y <= min(game.map.cols - 1, tile_point.y + r); y++) {
+      auto &tile = game.map.tiles[twod_to_oned_idx(Vec2(x, y), game.map.rows)];
+      if (tile.is_warp_point && tile.warps_to_map_file_path.size() > 0) {
+        prefetch(tile.warps_to_map_file_path);
+      }
+    }
+  }
+}
+
+bool MapLoader::is_loaded() {
+  if (!is_transitioning) {
+    return false;
+  }
+  lock_guard<mutex> lock(jobs_mutex);
+  return find_entry(transition_file_path) != nullptr;
+}
+
+void MapLoader::finish(Game &game) {
+  GAME_ASSERT(is_loaded());
+  shared_ptr<MapCacheEntry> entry = nullptr;
+  {
+    lock_guard<mutex> lock(jobs_mutex);
+    entry = find_entry(transition_file_path);
+    use_count += 1;
+    entry->last_used = use_count;
+    is_transitioning = false;
+  }
+  // the cached map is left as it is for the next visit
+  auto map = entry->map;
+  map.set_ui(game);
+  if (entry->is_binary) {
+    map_deserialize_entities_binary(game, entry->binary_view, map);
+  } else {
+    entry->reader.read_entities(game, map);
+  }
+  map_transition(game, map, warp_to_map_tile_point);
+  prefetch_tile_point = Vec2(-1, -1);
+}
+
+// call when the map file changes. A load of it already in flight still
+// lands in the cache.
+void MapLoader::erase(string &file_path) {
+  lock_guard<mutex> lock(jobs_mutex);
+  for (int i = 0; i < (int)cache.size(); i++) {
+    if (cache[i]->file_path == file_path) {
+      cache_num_bytes -= cache[i]->num_bytes;
+      cache.erase(cache.begin() + i);
+      return;
+    }
+  }
+}
+
+size_t MapLoader::get_cache_num_bytes() {
+  lock_guard<mutex> lock(jobs_mutex);
+  return cache_num_bytes;
+}
+
+int MapLoader::get_cache_size() {
+  lock_guard<mutex> lock(jobs_mutex);
+  return cache.size();
+}
+
+void MapLoader::run_worker(Game &game) {
+  while (true) {
+    string file_path;
+    {
+      unique_lock<mutex> lock(jobs_mutex);
+      jobs_cv.wait(lock, [&] { return is_stopping || jobs.size() > 0; });
+      if (is_stopping) {
+        return;
+      }
+      file_path = jobs.front();
+      jobs.pop_front();
+      if (find_entry(file_path) != nullptr) {
+        continue;
+      }
+      loading_file_path = file_path;
+    }
+    add_entry(load_entry(game, file_path));
+  }
+}
+
+// maps the binary map if there is one. Otherwise reads the whole json file
+// in one go and builds the map as it is parsed.
+// Touches nothing shared, runs on the worker.
+shared_ptr<MapCacheEntry> MapLoader::load_entry(Game &game,
+                                                string &file_path) {
+  auto entry = make_shared<MapCacheEntry>();
+  entry->file_path = file_path;
+  auto binary_file_path = get_binary_map_file_path(file_path);
+  if (is_little_endian_host() &&
+      entry->binary_file.open(binary_file_path.c_str())) {
+    if (!entry->binary_view.init(entry->binary_file.data,
+                                 entry->binary_file.num_bytes)) {
+      cout << "MapLoader::load_entry. Not a version " << MAP_FILE_VERSION
+           << " map file " << binary_file_path << "\n";
+      abort();
+    }
+    entry->is_binary = true;
+    map_deserialize_tiles_binary(game, entry->binary_view, entry->map);
+    entry->num_bytes =
+        entry->binary_file.num_bytes + get_map_num_bytes(entry->map);
+    return entry;
+  }
+  ifstream file(file_path, ios::binary | ios::ate);
+  if (!file.good()) {
+    cout << "MapLoader::load_entry. File error " << file_path << "\n";
+    abort();
+  }
+  auto size = (size_t)file.tellg();
+  file.seekg(0);
+  entry->buffer.resize(size);
+  file.read(entry->buffer.data(), size);
+  entry->reader.read(game, entry->buffer.data(), entry->buffer.size(),
+                     entry->map);
+  entry->num_bytes =
+      entry->buffer.capacity() + get_map_num_bytes(entry->map);
+  return entry;
+}
+
+// call with jobs_mutex held.
+shared_ptr<MapCacheEntry> MapLoader::find_entry(string &file_path) {
+  for (auto &entry : cache) {
+    if (entry->file_path == file_path) {
+      return entry;
+    }
+  }
+  return nullptr;
+}
+
+// call with jobs_mutex held.
+bool MapLoader::is_queued(string &file_path) {
+  return loading_file_path == file_path ||
+         find(jobs.begin(), jobs.end(), file_path) != jobs.end();
+}
+
+// drops the least recently used maps while the cache is over
+// MAP_CACHE_MAX_BYTES. The newest map and the one being transitioned to
+// are kept even if they alone are over it.
+void MapLoader::add_entry(shared_ptr<MapCacheEntry> entry) {
+  lock_guard<mutex> lock(jobs_mutex);
+  loading_file_path = "";
+  use_count += 1;
+  entry->last_used = use_count;
+  cache.push_back(entry);
+  cache_num_bytes += entry->num_bytes;
+  while (cache_num_bytes > MAP_CACHE_MAX_BYTES) {
+    int lru_idx = -1;
+    for (int i = 0; i < (int)cache.size(); i++) {
+      if (cache[i] == entry || (is_transitioning &&
+                                cache[i]->file_path == transition_file_path)) {
+        continue;
+      }
+      if (lru_idx == -1 || cache[i]->last_used < cache[lru_idx]->last_used) {
+        lru_idx = i;
+      }
+    }
+    if (lru_idx == -1) {
+      break;
+    }
+    cache_num_bytes -= cache[lru_idx]->num_bytes;
+    cache.erase(cache.begin() + lru_idx);
+  }
+}
+
+// roughly what a map's tiles, layers and move grid hold, used to cap the
+// MapLoader's cache.
+size_t get_map_num_bytes(Map &map) {
+  size_t num_bytes = sizeof(Map) + map.tiles.capacity() * sizeof(Tile);
+  for (auto &tile : map.tiles) {
+    num_bytes += tile.sprite.srcs.capacity() * sizeof(SpriteSrc) +
+                 tile.warps_to_map_file_path.capacity();
+  }
+  for (auto &layer : map.layers) {
+    num_bytes += layer.sprite_idxs.capacity() * sizeof(int) +
+                 layer.tile_idxs.capacity() * sizeof(int) +
+                 layer.sprites.capacity() * sizeof(Sprite);
+    for (auto &sprite : layer.sprites) {
+      num_bytes += sprite.srcs.capacity() * sizeof(SpriteSrc);
+    }
+  }
+  num_bytes += map.move_grid.walkable.capacity() * sizeof(uint64_t) +
+               map.move_grid.clearances.capacity() * sizeof(uint8_t);
+  return num_bytes;
+}
@@ -0,0 +1,442 @@
+#include "map_reader.h"
+#include "game.h"
+#include <iostream>
+#include <string.h>
+
+// reads the map in json into map, the map should be empty. Aborts if the
+// json isn't a map.
+bool MapReader::read(Game &_game, const char *_json, size_t num_bytes,
+                     Map &_map) {
+  game = &_game;
+  map = &_map;
+  json = _json;
+  depth = 0;
+  section = MapReaderSection::None;
+  for (auto &key : keys) {
+    key = MapReaderKey::None;
+  }
+  sprite_depth = 0;
+  MemoryStream json_stream = MemoryStream(json, num_bytes);
+  stream = &json_stream;
+  Reader reader;
+  auto result = reader.Parse(json_stream, *this);
+  stream = nullptr;
+  if (!result) {
+    cout << "MapReader::read. Parse error at " << result.Offset() << "\n";
+    abort();
+  }
+  if ((int)map->tiles.size() != map->rows * map->cols) {
+    cout << "MapReader::read. Expected " << map->rows * map->cols
+         << " tiles, got " << map->tiles.size() << "\n";
+    abort();
+  }
+  // layers missing from the file are empty
+  for (auto &layer : map->layers) {
+    if ((int)layer.sprite_idxs.size() != map->rows * map->cols) {
+      layer = MapLayer(map->rows * map->cols);
+    }
+  }
+  map->rows_move_grid = map->rows * MOVE_GRID_RATIO;
+  map->cols_move_grid = map->cols * MOVE_GRID_RATIO;
+  map->build_move_grid();
+  map->build_spatial_grids();
+  map->set_max_sprite_dims();
+  map->build_chunk_versions();
+  return true;
+}
+
+// the units, treasure chests and items. They are given handles and new
+// units use the guid generator, so this runs on the game thread.
+void MapReader::read_entities(Game &_game, Map &_map, bool is_save_file) {
+  // save file expects all_player_guids to be present
+  if (is_save_file) {
+    if (!has_all_player_unit_guids) {
+      cout << "MapReader::read_entities - is_save_file, json does not "
+              "contain all_player_unit_guids.\n";
+      abort();
+    }
+    // clear previous default unit handles placed in by maps constructor
+    // as we are about to add the ones from the save file
+    _map.all_player_unit_handles.clear();
+    for (auto &player_unit_guid : all_player_unit_guids) {
+      auto guid = _game.engine.string_gen(player_unit_guid);
+      _map.all_player_unit_handles.push_back(
+          _game.entity_registry.get_handle(guid));
+    }
+  }
+  for (auto &entity : units) {
+    Document doc;
+    doc.Parse(json + entity.offset, entity.num_bytes);
+    auto obj = doc.GetObject();
+    auto unit = unit_deserialize(_game, obj);
+    _map.add_unit(_game, unit);
+  }
+  for (auto &entity : treasure_chests) {
+    Document doc;
+    doc.Parse(json + entity.offset, entity.num_bytes);
+    auto obj = doc.GetObject();
+    auto treasure_chest = treasure_chest_deserialize(_game, obj);
+    _map.add_treasure_chest(_game, treasure_chest);
+  }
+  for (auto &entity : items) {
+    Document doc;
+    doc.Parse(json + entity.offset, entity.num_bytes);
+    auto obj = doc.GetObject();
+    auto item = item_deserialize(_game, obj);
+    _map.add_item(_game, item);
+  }
+}
+
+void MapReader::start_sprite() {
+  sprite_depth = depth;
+  reader_sprite.dst = Rect(0, 0, 0, 0);
+  reader_sprite.image_name = ImageName::None;
+  reader_sprite.anim_speed = 0;
+  reader_sprite.srcs.clear();
+  reader_sprite.palette_idx = -1;
+}
+
+// resolves the sprite read into sprite, the same as sprite_deserialize.
+void MapReader::end_sprite() {
+  sprite_depth = 0;
+  if (reader_sprite.palette_idx >= 0) {
+    if (reader_sprite.palette_idx >= (int)palette.sprites.size()) {
+      cout << "MapReader::end_sprite. Palette idx out of range "
+           << reader_sprite.palette_idx << "\n";
+      abort();
+    }
+    sprite = palette.sprites[reader_sprite.palette_idx];
+    sprite.dst = reader_sprite.dst;
+    return;
+  }
+  sprite = Sprite();
+  if (reader_sprite.image_name != ImageName::None) {
+    sprite.image = get_image(reader_sprite.image_name);
+  }
+  sprite.dst = reader_sprite.dst;
+  sprite.anim_speed = reader_sprite.anim_speed;
+  for (auto &src : reader_sprite.srcs) {
+    sprite.srcs.push_back(SpriteSrc(ImageLocation(sprite.image, src)));
+  }
+}
+
+Image MapReader::get_image(ImageName image_name) {
+  auto it = images.find((int)image_name);
+  if (it != images.end()) {
+    return it->second;
+  }
+  auto image = game->engine.get_image(image_name);
+  images[(int)image_name] = image;
+  return image;
+}
+
+static void set_rect_value(Rect &rect, MapReaderKey key, int value) {
+  switch (key) {
+  case MapReaderKey::X:
+    rect.x = value;
+    break;
+  case MapReaderKey::Y:
+    rect.y = value;
+    break;
+  case MapReaderKey::W:
+    rect.w = value;
+    break;
+  case MapReaderKey::H:
+    rect.h = value;
+    break;
+  default:
+    break;
+  }
+}
+
+void MapReader::set_int(int value) {
+  if (depth == 1) {
+    if (section == MapReaderSection::Rows) {
+      map->rows = value;
+    } else if (section == MapReaderSection::Cols) {
+      map->cols = value;
+    }
+    return;
+  }
+  if (depth >= MAP_READER_MAX_DEPTH) {
+    return;
+  }
+  auto key = keys[depth];
+  if (sprite_depth > 0) {
+    if (depth == sprite_depth) {
+      if (key == MapReaderKey::ImageName) {
+        reader_sprite.image_name = (ImageName)value;
+      } else if (key == MapReaderKey::AnimSpeed) {
+        reader_sprite.anim_speed = value;
+      } else if (key == MapReaderKey::PaletteIdx) {
+        reader_sprite.palette_idx = value;
+      }
+    } else if (depth == sprite_depth + 1 &&
+               keys[sprite_depth] == MapReaderKey::Dst) {
+      set_rect_value(reader_sprite.dst, key, value);
+    } else if (depth == sprite_depth + 2 &&
+               keys[sprite_depth] == MapReaderKey::Srcs) {
+      set_rect_value(reader_sprite.srcs.back(), key, value);
+    }
+  }
+  if (section == MapReaderSection::Tiles && depth == 4 &&
+      keys[3] == MapReaderKey::WarpsToTilePoint) {
+    if (key == MapReaderKey::X) {
+      tile.warps_to_tile_point.x = value;
+    } else if (key == MapReaderKey::Y) {
+      tile.warps_to_tile_point.y = value;
+    }
+  } else if (section == MapReaderSection::Layer && depth == 3 &&
+             key == MapReaderKey::TileIdx) {
+    layer_tile_idx = value;
+  }
+}
+
+bool MapReader::Bool(bool value) {
+  if (section == MapReaderSection::Tiles && depth == 3) {
+    if (keys[3] == MapReaderKey::IsObstacle) {
+      tile.is_obstacle = value;
+    } else if (keys[3] == MapReaderKey::IsWarpPoint) {
+      tile.is_warp_point = value;
+    }
+  }
+  return true;
+}
+
+bool MapReader::Int(int value) {
+  set_int(value);
+  return true;
+}
+
+bool MapReader::Uint(unsigned value) {
+  set_int((int)value);
+  return true;
+}
+
+bool MapReader::Int64(int64_t value) {
+  set_int((int)value);
+  return true;
+}
+
+bool MapReader::Uint64(uint64_t value) {
+  set_int((int)value);
+  return true;
+}
+
+// entities can have doubles (they are read again with serializer), the
+// tiles, layers and sprites only have ints.
+bool MapReader::Double(double value) {
+  if (section != MapReaderSection::None &&
+      section != MapReaderSection::Units &&
+      section != MapReaderSection::TreasureChests &&
+      section != MapReaderSection::Items) {
+    cout << "MapReader::Double. Unexpected double " << value
+         << " at depth " << depth << "\n";
+    abort();
+  }
+  return true;
+}
+
+bool MapReader::String(const char *str, SizeType len, bool copy) {
+  if (section == MapReaderSection::Tiles && depth == 3 &&
+      keys[3] == MapReaderKey::WarpsToMapFilePath) {
+    tile.warps_to_map_file_path = string(str, len);
+  } else if (section == MapReaderSection::AllPlayerUnitGuids && depth == 2) {
+    all_player_unit_guids.push_back(string(str, len));
+  }
+  return true;
+}
+
+static MapReaderSection get_section(const char *str, int &layer_idx) {
+  if (strcmp(str, "rows") == 0) {
+    return MapReaderSection::Rows;
+  } else if (strcmp(str, "cols") == 0) {
+    return MapReaderSection::Cols;
+  } else if (strcmp(str, "sprite_palette") == 0) {
+    return MapReaderSection::SpritePalette;
+  } else if (strcmp(str, "tiles") == 0) {
+    return MapReaderSection::Tiles;
+  } else if (strncmp(str, "layer_", 6) == 0) {
+    layer_idx = atoi(str + 6);
+    if (layer_idx < 0 || layer_idx >= MAX_LAYERS) {
+      cout << "MapReader. Layer out of range " << str << "\n";
+      abort();
+    }
+    return MapReaderSection::Layer;
+  } else if (strcmp(str, "all_player_unit_guids") == 0) {
+    return MapReaderSection::AllPlayerUnitGuids;
+  } else if (strcmp(str, "units") == 0) {
+    return MapReaderSection::Units;
+  } else if (strcmp(str, "treasure_chests") == 0) {
+    return MapReaderSection::TreasureChests;
+  } else if (strcmp(str, "items") == 0) {
+    return MapReaderSection::Items;
+  }
+  return MapReaderSection::None;
+}
+
+static MapReaderKey get_key(const char *str, SizeType len) {
+  if (len == 1) {
+    switch (str[0]) {
+    case 'x':
+      return MapReaderKey::X;
+    case 'y':
+      return MapReaderKey::Y;
+    case 'w':
+      return MapReaderKey::W;
+    case 'h':
+      return MapReaderKey::H;
+    default:
+      return MapReaderKey::None;
+    }
+  }
+  if (strcmp(str, "dst") == 0) {
+    return MapReaderKey::Dst;
+  } else if (strcmp(str, "srcs") == 0) {
+    return MapReaderKey::Srcs;
+  } else if (strcmp(str, "sprite") == 0) {
+    return MapReaderKey::Sprite;
+  } else if (strcmp(str, "palette_idx") == 0) {
+    return MapReaderKey::PaletteIdx;
+  } else if (strcmp(str, "image_name") == 0) {
+    return MapReaderKey::ImageName;
+  } else if (strcmp(str, "anim_speed") == 0) {
+    return MapReaderKey::AnimSpeed;
+  } else if (strcmp(str, "is_obstacle") == 0) {
+    return MapReaderKey::IsObstacle;
+  } else if (strcmp(str, "is_warp_point") == 0) {
+    return MapReaderKey::IsWarpPoint;
+  } else if (strcmp(str, "warps_to_tile_point") == 0) {
+    return MapReaderKey::WarpsToTilePoint;
+  } else if (strcmp(str, "warps_to_map_file_path") == 0) {
+    return MapReaderKey::WarpsToMapFilePath;
+  } else if (strcmp(str, "tile_idx") == 0) {
+    return MapReaderKey::TileIdx;
+  }
+  return MapReaderKey::None;
+}
+
+bool MapReader::Key(const char *str, SizeType len, bool copy) {
+  if (depth == 1) {
+    section = get_section(str, layer_idx);
+  } else if (depth < MAP_READER_MAX_DEPTH &&
+             section != MapReaderSection::Units &&
+             section != MapReaderSection::TreasureChests &&
+             section != MapReaderSection::Items) {
+    keys[depth] = get_key(str, len);
+  }
+  return true;
+}
+
+bool MapReader::StartObject() {
+  depth += 1;
+  switch (section) {
+  case MapReaderSection::SpritePalette:
+    if (depth == 3) {
+      start_sprite();
+    }
+    break;
+  case MapReaderSection::Tiles:
+    if (depth == 3) {
+      tile = Tile();
+    } else if (depth == 4 && keys[3] == MapReaderKey::Sprite) {
+      start_sprite();
+    }
+    break;
+  case MapReaderSection::Layer:
+    // older files have a whole sprite for every tile rather than a tile
+    // idx and a sprite
+    if (depth == 3) {
+      layer_tile_idx = -1;
+      start_sprite();
+    } else if (depth == 4 && keys[3] == MapReaderKey::Sprite) {
+      start_sprite();
+    }
+    break;
+  case MapReaderSection::Units:
+  case MapReaderSection::TreasureChests:
+  case MapReaderSection::Items:
+    // the Reader has just taken the '{'
+    if (depth == 3) {
+      entity_offset = stream->Tell() - 1;
+    }
+    break;
+  default:
+    break;
+  }
+  if (sprite_depth > 0 && depth == sprite_depth + 2 &&
+      keys[sprite_depth] == MapReaderKey::Srcs) {
+    reader_sprite.srcs.push_back(Rect(0, 0, 0, 0));
+  }
+  return true;
+}
+
+bool MapReader::EndObject(SizeType member_count) {
+  if (sprite_depth > 0 && depth == sprite_depth) {
+    end_sprite();
+  }
+  switch (section) {
+  case MapReaderSection::SpritePalette:
+    if (depth == 3) {
+      palette.sprites.push_back(sprite);
+    }
+    break;
+  case MapReaderSection::Tiles:
+    if (depth == 3) {
+      map->tiles.push_back(tile);
+    } else if (depth == 4 && keys[3] == MapReaderKey::Sprite) {
+      tile.sprite = sprite;
+    }
+    break;
+  case MapReaderSection::Layer:
+    if (depth == 3) {
+      if (layer_tile_idx >= 0) {
+        map->layers[layer_idx].add_sprite(layer_tile_idx, sprite);
+      } else if (sprite.srcs.size() > 0) {
+        map->layers[layer_idx].add_sprite(layer_entry_idx, sprite);
+      }
+      layer_entry_idx += 1;
+    }
+    break;
+  case MapReaderSection::Units:
+  case MapReaderSection::TreasureChests:
+  case MapReaderSection::Items:
+    if (depth == 3) {
+      auto entity = MapReaderEntity();
+      entity.offset = entity_offset;
+      entity.num_bytes = stream->Tell() - entity_offset;
+      if (section == MapReaderSection::Units) {
+        units.push_back(entity);
+      } else if (section == MapReaderSection::TreasureChests) {
+        treasure_chests.push_back(entity);
+      } else {
+        items.push_back(entity);
+      }
+    }
+    break;
+  default:
+    break;
+  }
+  depth -= 1;
+  return true;
+}
+
+bool MapReader::StartArray() {
+  depth += 1;
+  if (depth == 2) {
+    if (section == MapReaderSection::Tiles) {
+      map->tiles.reserve(map->rows * map->cols);
+    } else if (section == MapReaderSection::Layer) {
+      map->layers[layer_idx] = MapLayer(map->rows * map->cols);
+      layer_entry_idx = 0;
+    } else if (section == MapReaderSection::AllPlayerUnitGuids) {
+      has_all_player_unit_guids = true;
+    }
+  }
+  return true;
+}
+
+bool MapReader::EndArray(SizeType element_count) {
+  depth -= 1;
+  return true;
+}
@@ -0,0 +1,222 @@
+#include "map_renderer.h"
+#include "game.h"
+#include "map.h"
+#include <algorithm>
+
+bool operator==(const MapAnimationClockKey &k1,
+                const MapAnimationClockKey &k2) {
+  return k1.num_frames == k2.num_frames && k1.anim_speed == k2.anim_speed &&
+         k1.phase == k2.phase;
+}
+
+// the src a sprite draws for frame_idx, with its vertices set to the
+// sprite's world point.
+static SpriteSrc get_baked_src(Sprite &sprite, int frame_idx) {
+  auto src = sprite.srcs[frame_idx];
+  auto dst = sprite.dst;
+  dst.w = src.image_location.src.w;
+  dst.h = src.image_location.src.h;
+  src.update(dst);
+  return src;
+}
+
+// bakes the visible chunks that changed since they were last baked and
+// moves the animated sprites of the rest along.
+void MapRenderer::update(Game &game, Map &map) {
+  update_clocks(game);
+  auto num_chunks = (int)map.chunk_versions.size();
+  for (int i = num_chunks; i < (int)meshes.size(); i++) {
+    game.engine.delete_static_buffers(meshes[i].vao, meshes[i].vbo,
+                                      meshes[i].ubo);
+  }
+  meshes.resize(num_chunks);
+  auto r = get_visible_chunk_rect(map);
+  for (int cx = r.x; cx < r.x + r.w; cx++) {
+    for (int cy = r.y; cy < r.y + r.h; cy++) {
+      auto chunk_idx = cx * map.chunk_cols + cy;
+      if (meshes[chunk_idx].version != map.chunk_versions[chunk_idx]) {
+        bake(game, map, chunk_idx);
+      } else {
+        update_animations(game, map, meshes[chunk_idx]);
+      }
+    }
+  }
+}
+
+void MapRenderer::draw_tiles(Game &game, Map &map) {
+  auto r = get_visible_chunk_rect(map);
+  if (r.w == 0 || r.h == 0) {
+    return;
+  }
+  game.engine.begin_static_draw(map.visible_camera_dst);
+  for (int cx = r.x; cx < r.x + r.w; cx++) {
+    for (int cy = r.y; cy < r.y + r.h; cy++) {
+      draw_stage(game, map, cx * map.chunk_cols + cy, MAP_CHUNK_TILE_STAGE);
+    }
+  }
+  game.engine.end_static_draw();
+}
+
+// each layer is drawn over the whole visible range before the next one.
+void MapRenderer::draw_layers(Game &game, Map &map) {
+  auto r = get_visible_chunk_rect(map);
+  if (r.w == 0 || r.h == 0) {
+    return;
+  }
+  game.engine.begin_static_draw(map.visible_camera_dst);
+  for (int l = 0; l < (int)map.layers.size(); l++) {
+    for (int cy = r.y + r.h - 1; cy >= r.y; cy--) {
+      for (int cx = r.x; cx < r.x + r.w; cx++) {
+        draw_stage(game, map, cx * map.chunk_cols + cy, l + 1);
+      }
+    }
+  }
+  game.engine.end_static_draw();
+}
+
+void MapRenderer::draw_stage(Game &game, Map &map, int chunk_idx, int stage) {
+  auto &mesh = meshes[chunk_idx];
+  for (int k = mesh.stage_batch_idxs[stage];
+       k < mesh.stage_batch_idxs[stage + 1]; k++) {
+    auto &batch = mesh.batches[k];
+    game.engine.draw_static_buffers(mesh.vao, batch.texture_id,
+                                    batch.first_vertex, batch.num_vertices);
+  }
+}
+
+// sprites are added in the order Map::draw used to draw them, tiles along
+// x then y and each layer from the top row down.
+void MapRenderer::bake(Game &game, Map &map, int chunk_idx) {
+  auto &mesh = meshes[chunk_idx];
+  mesh.version = map.chunk_versions[chunk_idx];
+  mesh.batches.clear();
+  mesh.stage_batch_idxs.clear();
+  mesh.animations.clear();
+  vertices.clear();
+  uvs.clear();
+  auto min_x = (chunk_idx / map.chunk_cols) * MAP_CHUNK_TILES;
+  auto min_y = (chunk_idx % map.chunk_cols) * MAP_CHUNK_TILES;
+  auto max_x = min(min_x + MAP_CHUNK_TILES, map.rows);
+  auto max_y = min(min_y + MAP_CHUNK_TILES, map.cols);
+  mesh.stage_batch_idxs.push_back(mesh.batches.size());
+  for (int i = min_x; i < max_x; i++) {
+    for (int j = min_y; j < max_y; j++) {
+      auto idx = twod_to_oned_idx(Vec2(i, j), map.rows);
+      add_sprite(game, mesh, map.tiles[idx].sprite, MAP_CHUNK_TILE_STAGE, idx);
+    }
+  }
+  for (int l = 0; l < (int)map.layers.size(); l++) {
+    mesh.stage_batch_idxs.push_back(mesh.batches.size());
+    for (int j = max_y - 1; j >= min_y; j--) {
+      for (int i = min_x; i < max_x; i++) {
+        auto idx = twod_to_oned_idx(Vec2(i, j), map.rows);
+        auto sprite = map.layers[l].get_sprite(idx);
+        if (sprite != nullptr) {
+          add_sprite(game, mesh, *sprite, l + 1, idx);
+        }
+      }
+    }
+  }
+  mesh.stage_batch_idxs.push_back(mesh.batches.size());
+  game.engine.upload_static_buffers(mesh.vao, mesh.vbo, mesh.ubo, vertices,
+                                    uvs);
+}
+
+// quads that follow each other in a stage and share a texture are drawn
+// with one call.
+void MapRenderer::add_sprite(Game &game, MapChunkMesh &mesh, Sprite &sprite,
+                             int stage, int tile_idx) {
+  // an empty sprite for a tile layer won't have any srcs
+  if (sprite.srcs.size() == 0 || sprite.is_hidden) {
+    return;
+  }
+  auto clock_idx = get_clock_idx(game, sprite);
+  auto frame_idx = clocks[clock_idx].frame_idx;
+  auto src = get_baked_src(sprite, frame_idx);
+  auto first_vertex = (int)vertices.size() / 2;
+  vertices.insert(vertices.end(), src.vertices, src.vertices + 12);
+  uvs.insert(uvs.end(), src.uvs, src.uvs + 12);
+  if ((int)mesh.batches.size() > mesh.stage_batch_idxs.back() &&
+      mesh.batches.back().texture_id == sprite.image.texture_id) {
+    mesh.batches.back().num_vertices += 6;
+  } else {
+    auto batch = MapChunkBatch();
+    batch.texture_id = sprite.image.texture_id;
+    batch.first_vertex = first_vertex;
+    batch.num_vertices = 6;
+    mesh.batches.push_back(batch);
+  }
+  if (sprite.srcs.size() > 1) {
+    auto animation = MapChunkAnimation();
+    animation.stage = stage;
+    animation.tile_idx = tile_idx;
+    animation.quad_idx = first_vertex / 6;
+    animation.clock_idx = clock_idx;
+    animation.frame_idx = frame_idx;
+    mesh.animations.push_back(animation);
+  }
+}
+
+void MapRenderer::update_animations(Game &game, Map &map, MapChunkMesh &mesh) {
+  for (auto &animation : mesh.animations) {
+    auto frame_idx = clocks[animation.clock_idx].frame_idx;
+    if (frame_idx == animation.frame_idx) {
+      continue;
+    }
+    animation.frame_idx = frame_idx;
+    auto &sprite = *get_sprite(map, animation.stage, animation.tile_idx);
+    auto src = get_baked_src(sprite, frame_idx);
+    game.engine.update_static_buffers(mesh.vbo, mesh.ubo,
+                                      animation.quad_idx * 6, src.vertices,
+                                      src.uvs, 6);
+  }
+}
+
+void MapRenderer::update_clocks(Game &game) {
+  for (auto &clock : clocks) {
+    clock.frame_idx =
+        get_current_frame_idx(game.engine.current_time, clock.key.phase,
+                              clock.key.num_frames, clock.key.anim_speed);
+  }
+}
+
+// the sprite's clock, one is made for it if there isn't one yet.
+int MapRenderer::get_clock_idx(Game &game, Sprite &sprite) {
+  auto key = MapAnimationClockKey();
+  key.num_frames = sprite.srcs.size();
+  key.anim_speed = sprite.anim_speed;
+  auto cycle = sprite.anim_speed * key.num_frames;
+  key.phase = cycle > 0 ? sprite.spawn_time % cycle : 0;
+  auto it = clock_idxs.find(key);
+  if (it != clock_idxs.end()) {
+    return it->second;
+  }
+  auto clock = MapAnimationClock();
+  clock.key = key;
+  clock.frame_idx =
+      get_current_frame_idx(game.engine.current_time, key.phase,
+                            key.num_frames, key.anim_speed);
+  clocks.push_back(clock);
+  clock_idxs[key] = clocks.size() - 1;
+  return clocks.size() - 1;
+}
+
+Sprite *MapRenderer::get_sprite(Map &map, int stage, int tile_idx) {
+  if (stage == MAP_CHUNK_TILE_STAGE) {
+    return &map.tiles[tile_idx].sprite;
+  }
+  return map.layers[stage - 1].get_sprite(tile_idx);
+}
+
+// the chunks that overlap the map's visible tiles.
+Rect MapRenderer::get_visible_chunk_rect(Map &map) {
+  auto &r = map.visible_tile_rect;
+  if (r.w <= 0 || r.h <= 0) {
+    return Rect(0, 0, 0, 0);
+  }
+  auto min_x = r.x / MAP_CHUNK_TILES;
+  auto min_y = r.y / MAP_CHUNK_TILES;
+  auto max_x = (r.x + r.w - 1) / MAP_CHUNK_TILES;
+  auto max_y = (r.y + r.h - 1) / MAP_CHUNK_TILES;
+  return Rect(min_x, min_y, max_x - min_x + 1, max_y - min_y + 1);
+}
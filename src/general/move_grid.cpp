@@ -0,0 +1,129 @@
+#include "move_grid.h"
+#include <algorithm>
+#include <atomic>
+
+// atomic as maps are also loaded on the MapLoader's thread.
+uint32_t get_next_walkability_version() {
+  static atomic<uint32_t> next_version(0);
+  return ++next_version;
+}
+
+MoveGrid::MoveGrid() {
+  rows = 0;
+  cols = 0;
+  version = get_next_walkability_version();
+  walkable = vector<uint64_t>();
+  clearances = vector<uint8_t>();
+}
+
+MoveGrid::MoveGrid(int _rows, int _cols) {
+  rows = _rows;
+  cols = _cols;
+  version = get_next_walkability_version();
+  auto num_points = rows * cols;
+  // everything starts walkable, obstacles are set from the tiles.
+  walkable = vector<uint64_t>((num_points + 63) / 64, ~(uint64_t)0);
+  clearances = vector<uint8_t>(num_points, 0);
+  update_all_clearances();
+}
+
+int MoveGrid::get_idx(Vec2 p) const { return p.x * cols + p.y; }
+
+bool MoveGrid::point_in_bounds(Vec2 p) const {
+  return p.x >= 0 && p.x < rows && p.y >= 0 && p.y < cols;
+}
+
+bool MoveGrid::is_walkable(Vec2 p) const {
+  if (!point_in_bounds(p)) {
+    return false;
+  }
+  auto idx = get_idx(p);
+  return (walkable[idx >> 6] >> (idx & 63)) & 1;
+}
+
+int MoveGrid::get_clearance(Vec2 p) const {
+  if (!point_in_bounds(p)) {
+    return 0;
+  }
+  return clearances[get_idx(p)];
+}
+
+// covers the rect with squares the size of its shortest side (the last
+// square on each axis overlaps the one before it), a 10x20 unit hitbox is
+// two lookups.
+bool MoveGrid::rect_is_walkable(const Rect &rect) const {
+  auto w = max(rect.w, 1);
+  auto h = max(rect.h, 1);
+  auto side = min(min(w, h), MOVE_GRID_MAX_CLEARANCE);
+  for (auto x = 0;; x += side) {
+    x = min(x, w - side);
+    for (auto y = 0;; y += side) {
+      y = min(y, h - side);
+      if (get_clearance(Vec2(rect.x + x, rect.y + y)) < side) {
+        return false;
+      }
+      if (y == h - side) {
+        break;
+      }
+    }
+    if (x == w - side) {
+      break;
+    }
+  }
+  return true;
+}
+
+void MoveGrid::set_walkable(Vec2 p, bool is_walkable) {
+  version = get_next_walkability_version();
+  auto idx = get_idx(p);
+  auto bit = (uint64_t)1 << (idx & 63);
+  if (is_walkable) {
+    walkable[idx >> 6] |= bit;
+  } else {
+    walkable[idx >> 6] &= ~bit;
+  }
+}
+
+void MoveGrid::set_tile_is_obstacle(Vec2 tile_point, bool is_obstacle,
+                                    bool update_clearances_after) {
+  auto start = tile_point_to_tile_point_move_grid(tile_point);
+  auto tile_area = Rect(start.x, start.y, MOVE_GRID_RATIO, MOVE_GRID_RATIO);
+  for (int x = tile_area.x; x < tile_area.x + tile_area.w; x++) {
+    for (int y = tile_area.y; y < tile_area.y + tile_area.h; y++) {
+      if (point_in_bounds(Vec2(x, y))) {
+        set_walkable(Vec2(x, y), !is_obstacle);
+      }
+    }
+  }
+  if (update_clearances_after) {
+    update_clearances(tile_area);
+  }
+}
+
+// clearance(p) = 1 + min(clearance of the points right, above and
+// diagonally up right of p), so only points below and left of a change
+// (within the clearance cap) can change. Those are recomputed from the top
+// right so every point reads already updated values.
+void MoveGrid::update_clearances(Rect area) {
+  auto x_start = max(area.x - MOVE_GRID_MAX_CLEARANCE + 1, 0);
+  auto y_start = max(area.y - MOVE_GRID_MAX_CLEARANCE + 1, 0);
+  auto x_end = min(area.x + area.w, rows) - 1;
+  auto y_end = min(area.y + area.h, cols) - 1;
+  for (int x = x_end; x >= x_start; x--) {
+    for (int y = y_end; y >= y_start; y--) {
+      auto p = Vec2(x, y);
+      auto clearance = 0;
+      if (is_walkable(p)) {
+        clearance = 1 + min(min(get_clearance(Vec2(x + 1, y)),
+                                get_clearance(Vec2(x, y + 1))),
+                            get_clearance(Vec2(x + 1, y + 1)));
+        clearance = min(clearance, MOVE_GRID_MAX_CLEARANCE);
+      }
+      clearances[get_idx(p)] = (uint8_t)clearance;
+    }
+  }
+}
+
+void MoveGrid::update_all_clearances() {
+  update_clearances(Rect(0, 0, rows, cols));
+}
@@ -0,0 +1,162 @@
+#include "move_range_field.h"
+#include <algorithm>
+
+MoveRangeField::MoveRangeField() {}
+
+// units block the search the same way they do for battle paths, the unit
+// itself is ignored.
+void MoveRangeField::set(const MoveGrid &move_grid,
+                         const OccupancyGrid &occupancy_grid,
+                         EntityHandle _unit_handle, Rect hit_box,
+                         Vec2 _origin, int _max_steps) {
+  if (rows != move_grid.rows || cols != move_grid.cols ||
+      (int)steps.size() != move_grid.rows * move_grid.cols) {
+    rows = move_grid.rows;
+    cols = move_grid.cols;
+    steps.assign(rows * cols, MOVE_RANGE_UNKNOWN);
+    came_from.assign(rows * cols, -1);
+    is_range_edge.assign(rows * cols, 0);
+    touched_idxs.clear();
+  }
+  for (auto idx : touched_idxs) {
+    steps[idx] = MOVE_RANGE_UNKNOWN;
+    came_from[idx] = -1;
+    is_range_edge[idx] = 0;
+  }
+  touched_idxs.clear();
+  reached_idxs.clear();
+  unit_handle = _unit_handle;
+  origin = _origin;
+  max_steps = max(_max_steps, 0);
+  move_grid_version = move_grid.version;
+  area = Rect(origin.x - max_steps - 1, origin.y - max_steps - 1,
+              2 * (max_steps + 1) + hit_box.w, 2 * (max_steps + 1) + hit_box.h);
+  area_occupancy_version = occupancy_grid.get_area_version(area);
+  closest_point_target = Vec2(-1, -1);
+  is_valid = true;
+  if (!point_in_bounds(origin)) {
+    return;
+  }
+  auto ignored_hit_box = occupancy_grid.get_unit_hit_box(unit_handle);
+  auto origin_idx = get_idx(origin);
+  steps[origin_idx] = 0;
+  touched_idxs.push_back(origin_idx);
+  reached_idxs.push_back(origin_idx);
+  for (int i = 0; i < (int)reached_idxs.size(); i++) {
+    auto idx = reached_idxs[i];
+    auto p = get_point(idx);
+    auto is_at_max_steps = steps[idx] == max_steps;
+    for (int dx = -1; dx <= 1; dx++) {
+      for (int dy = -1; dy <= 1; dy++) {
+        auto n = Vec2(p.x + dx, p.y + dy);
+        if ((dx == 0 && dy == 0) || !point_in_bounds(n)) {
+          continue;
+        }
+        auto n_idx = get_idx(n);
+        if (steps[n_idx] == MOVE_RANGE_UNKNOWN) {
+          auto moved_hit_box = hit_box;
+          moved_hit_box.x = n.x;
+          moved_hit_box.y = n.y;
+          auto is_passable =
+              move_grid.rect_is_walkable(moved_hit_box) &&
+              !occupancy_grid.rect_is_occupied(moved_hit_box, ignored_hit_box);
+          if (!is_passable) {
+            steps[n_idx] = MOVE_RANGE_BLOCKED;
+            touched_idxs.push_back(n_idx);
+            continue;
+          }
+          if (is_at_max_steps) {
+            // left unknown so other edge points test it too
+            is_range_edge[idx] = 1;
+            continue;
+          }
+          steps[n_idx] = steps[idx] + 1;
+          came_from[n_idx] = idx;
+          touched_idxs.push_back(n_idx);
+          reached_idxs.push_back(n_idx);
+        }
+      }
+    }
+  }
+}
+
+void MoveRangeField::invalidate() { is_valid = false; }
+
+bool MoveRangeField::is_stale(const MoveGrid &move_grid,
+                              const OccupancyGrid &occupancy_grid,
+                              EntityHandle _unit_handle, Vec2 _origin,
+                              int _max_steps) {
+  return !is_valid || unit_handle != _unit_handle || !(origin == _origin) ||
+         max_steps != max(_max_steps, 0) ||
+         move_grid_version != move_grid.version ||
+         area_occupancy_version != occupancy_grid.get_area_version(area);
+}
+
+bool MoveRangeField::is_reachable(Vec2 p) { return get_steps(p) >= 0; }
+
+int MoveRangeField::get_steps(Vec2 p) {
+  if (!point_in_bounds(p)) {
+    return MOVE_RANGE_UNKNOWN;
+  }
+  return steps[get_idx(p)];
+}
+
+// the target if it can be reached, otherwise the reachable point closest to
+// it (fewest steps on ties), like PathFinder::closest_point_to_target.
+Vec2 MoveRangeField::get_closest_point(Vec2 target) {
+  if (is_reachable(target) || reached_idxs.empty()) {
+    return target;
+  }
+  if (closest_point_target == target) {
+    return closest_point;
+  }
+  auto closest_dist = -1;
+  auto closest_steps = 0;
+  for (auto idx : reached_idxs) {
+    auto p = get_point(idx);
+    auto dist = manhattan_distance(p, target);
+    if (closest_dist == -1 || dist < closest_dist ||
+        (dist == closest_dist && steps[idx] < closest_steps)) {
+      closest_dist = dist;
+      closest_steps = steps[idx];
+      closest_point = p;
+    }
+  }
+  closest_point_target = target;
+  return closest_point;
+}
+
+// true if the target might be reachable with more action points, going
+// past reachable_point (from get_closest_point).
+bool MoveRangeField::is_out_of_range(Vec2 reachable_point, Vec2 target) {
+  if (reachable_point == target || !is_reachable(reachable_point)) {
+    return false;
+  }
+  return is_range_edge[get_idx(reachable_point)];
+}
+
+// excludes the origin and ends with the target, like PathFinder::path.
+// the origin as the target gives a path of just the origin.
+void MoveRangeField::set_path(Vec2 target, vector<Vec2> &path) {
+  path.clear();
+  if (!is_reachable(target)) {
+    return;
+  }
+  if (target == origin) {
+    path.push_back(target);
+    return;
+  }
+  auto origin_idx = get_idx(origin);
+  for (int idx = get_idx(target); idx != origin_idx; idx = came_from[idx]) {
+    path.push_back(get_point(idx));
+  }
+  reverse(path.begin(), path.end());
+}
+
+bool MoveRangeField::point_in_bounds(Vec2 p) {
+  return p.x >= 0 && p.x < rows && p.y >= 0 && p.y < cols;
+}
+
+int MoveRangeField::get_idx(Vec2 p) { return p.x * cols + p.y; }
+
+Vec2 MoveRangeField::get_point(int idx) { return Vec2(idx / cols, idx % cols); }
@@ -0,0 +1,187 @@
+#include "occupancy_grid.h"
+#include "move_grid.h"
+#include <algorithm>
+
+OccupancyGrid::OccupancyGrid() {
+  rows = 0;
+  cols = 0;
+  tile_rows = 0;
+  tile_cols = 0;
+  version = get_next_walkability_version();
+  counts = vector<uint16_t>();
+  tile_counts = vector<uint16_t>();
+  tile_versions = vector<uint32_t>();
+}
+
+OccupancyGrid::OccupancyGrid(int _rows, int _cols) {
+  rows = _rows;
+  cols = _cols;
+  tile_rows = (rows + MOVE_GRID_RATIO - 1) / MOVE_GRID_RATIO;
+  tile_cols = (cols + MOVE_GRID_RATIO - 1) / MOVE_GRID_RATIO;
+  version = get_next_walkability_version();
+  counts = vector<uint16_t>(rows * cols, 0);
+  tile_counts = vector<uint16_t>(tile_rows * tile_cols, 0);
+  tile_versions = vector<uint32_t>(tile_rows * tile_cols, version);
+}
+
+// re-adding a unit that is already in the grid moves it.
+void OccupancyGrid::add_unit(EntityHandle unit_handle, Rect hit_box) {
+  if (contains_unit(unit_handle)) {
+    move_unit(unit_handle, hit_box);
+    return;
+  }
+  unit_hit_boxes[unit_handle] = hit_box;
+  add_rect(hit_box, 1);
+}
+
+void OccupancyGrid::remove_unit(EntityHandle unit_handle) {
+  auto iter = unit_hit_boxes.find(unit_handle);
+  if (iter == unit_hit_boxes.end()) {
+    return;
+  }
+  add_rect(iter->second, -1);
+  unit_hit_boxes.erase(iter);
+}
+
+// units that were never added are ignored, set_tile_point is called on
+// units before they are added to a map.
+void OccupancyGrid::move_unit(EntityHandle unit_handle, Rect hit_box) {
+  auto iter = unit_hit_boxes.find(unit_handle);
+  if (iter == unit_hit_boxes.end()) {
+    return;
+  }
+  auto &prev_hit_box = iter->second;
+  if (prev_hit_box.x == hit_box.x && prev_hit_box.y == hit_box.y &&
+      prev_hit_box.w == hit_box.w && prev_hit_box.h == hit_box.h) {
+    return;
+  }
+  add_rect(prev_hit_box, -1);
+  prev_hit_box = hit_box;
+  add_rect(hit_box, 1);
+}
+
+bool OccupancyGrid::contains_unit(EntityHandle unit_handle) const {
+  return unit_hit_boxes.find(unit_handle) != unit_hit_boxes.end();
+}
+
+// an empty rect if the unit is not in the grid.
+Rect OccupancyGrid::get_unit_hit_box(EntityHandle unit_handle) const {
+  auto iter = unit_hit_boxes.find(unit_handle);
+  if (iter == unit_hit_boxes.end()) {
+    return Rect(0, 0, 0, 0);
+  }
+  return iter->second;
+}
+
+bool OccupancyGrid::rect_is_occupied(
+    const Rect &rect, EntityHandle ignored_unit_handle) const {
+  return rect_is_occupied(rect, get_unit_hit_box(ignored_unit_handle));
+}
+
+// a point is occupied by someone other than the ignored unit if more units
+// cover it than the ignored unit accounts for. Tiles are checked first and
+// only the tiles that have another unit in them are checked point by point.
+bool OccupancyGrid::rect_is_occupied(const Rect &rect,
+                                     const Rect &ignored_hit_box) const {
+  auto clipped_rect = clip_rect(rect);
+  if (clipped_rect.w <= 0 || clipped_rect.h <= 0) {
+    return false;
+  }
+  auto clipped_ignored_hit_box = clip_rect(ignored_hit_box);
+  auto ignored_tile_area = get_tile_area(clipped_ignored_hit_box);
+  auto tile_area = get_tile_area(clipped_rect);
+  for (int tx = tile_area.x; tx < tile_area.x + tile_area.w; tx++) {
+    for (int ty = tile_area.y; ty < tile_area.y + tile_area.h; ty++) {
+      auto tile_count = (int)tile_counts[tx * tile_cols + ty];
+      if (clipped_ignored_hit_box.w > 0 && clipped_ignored_hit_box.h > 0 &&
+          half_open_rect_contains(ignored_tile_area, tx, ty)) {
+        tile_count -= 1;
+      }
+      if (tile_count <= 0) {
+        continue;
+      }
+      auto x_start = max(clipped_rect.x, tx * MOVE_GRID_RATIO);
+      auto x_end = min(clipped_rect.x + clipped_rect.w,
+                       (tx + 1) * MOVE_GRID_RATIO);
+      auto y_start = max(clipped_rect.y, ty * MOVE_GRID_RATIO);
+      auto y_end = min(clipped_rect.y + clipped_rect.h,
+                       (ty + 1) * MOVE_GRID_RATIO);
+      for (int x = x_start; x < x_end; x++) {
+        for (int y = y_start; y < y_end; y++) {
+          auto count = (int)counts[x * cols + y];
+          if (half_open_rect_contains(clipped_ignored_hit_box, x, y)) {
+            count -= 1;
+          }
+          if (count > 0) {
+            return true;
+          }
+        }
+      }
+    }
+  }
+  return false;
+}
+
+void OccupancyGrid::add_rect(const Rect &rect, int amount) {
+  version = get_next_walkability_version();
+  auto clipped_rect = clip_rect(rect);
+  if (clipped_rect.w <= 0 || clipped_rect.h <= 0) {
+    return;
+  }
+  for (int x = clipped_rect.x; x < clipped_rect.x + clipped_rect.w; x++) {
+    for (int y = clipped_rect.y; y < clipped_rect.y + clipped_rect.h; y++) {
+      counts[x * cols + y] += amount;
+    }
+  }
+  auto tile_area = get_tile_area(clipped_rect);
+  for (int tx = tile_area.x; tx < tile_area.x + tile_area.w; tx++) {
+    for (int ty = tile_area.y; ty < tile_area.y + tile_area.h; ty++) {
+      tile_counts[tx * tile_cols + ty] += amount;
+      tile_versions[tx * tile_cols + ty] = version;
+    }
+  }
+}
+
+// the newest version of the tiles rect covers, 0 when it is off the grid.
+uint32_t OccupancyGrid::get_area_version(const Rect &rect) const {
+  auto clipped_rect = clip_rect(rect);
+  if (clipped_rect.w <= 0 || clipped_rect.h <= 0) {
+    return 0;
+  }
+  auto area_version = (uint32_t)0;
+  auto tile_area = get_tile_area(clipped_rect);
+  for (int tx = tile_area.x; tx < tile_area.x + tile_area.w; tx++) {
+    for (int ty = tile_area.y; ty < tile_area.y + tile_area.h; ty++) {
+      area_version = max(area_version, tile_versions[tx * tile_cols + ty]);
+    }
+  }
+  return area_version;
+}
+
+// rect_contains_point includes the right and top edges, hitboxes don't.
+bool OccupancyGrid::half_open_rect_contains(const Rect &rect, int x,
+                                            int y) const {
+  return x >= rect.x && x < rect.x + rect.w && y >= rect.y &&
+         y < rect.y + rect.h;
+}
+
+Rect OccupancyGrid::clip_rect(const Rect &rect) const {
+  auto x_start = max(rect.x, 0);
+  auto y_start = max(rect.y, 0);
+  auto x_end = min(rect.x + rect.w, rows);
+  auto y_end = min(rect.y + rect.h, cols);
+  return Rect(x_start, y_start, x_end - x_start, y_end - y_start);
+}
+
+// the tiles a clipped, non empty rect touches.
+Rect OccupancyGrid::get_tile_area(const Rect &clipped_rect) const {
+  if (clipped_rect.w <= 0 || clipped_rect.h <= 0) {
+    return Rect(0, 0, 0, 0);
+  }
+  auto tx_start = clipped_rect.x / MOVE_GRID_RATIO;
+  auto ty_start = clipped_rect.y / MOVE_GRID_RATIO;
+  auto tx_end = (clipped_rect.x + clipped_rect.w - 1) / MOVE_GRID_RATIO;
+  auto ty_end = (clipped_rect.y + clipped_rect.h - 1) / MOVE_GRID_RATIO;
+  return Rect(tx_start, ty_start, tx_end - tx_start + 1,
+              ty_end - ty_start + 1);
+}
@@ -0,0 +1,341 @@
+#include "path_cluster_graph.h"
+#include <algorithm>
+
+PathClusterNode::PathClusterNode() {
+  p = Vec2(0, 0);
+  partner = Vec2(0, 0);
+}
+
+PathClusterNode::PathClusterNode(Vec2 _p, Vec2 _partner) {
+  p = _p;
+  partner = _partner;
+}
+
+PathClusterGraph::PathClusterGraph() {}
+
+PathClusterGraph::PathClusterGraph(int _rows, int _cols, Vec2 _hit_box_dims) {
+  hit_box_dims = _hit_box_dims;
+  rows = _rows;
+  cols = _cols;
+  cluster_rows = (rows + PATH_CLUSTER_SIZE - 1) / PATH_CLUSTER_SIZE;
+  cluster_cols = (cols + PATH_CLUSTER_SIZE - 1) / PATH_CLUSTER_SIZE;
+  clusters = vector<PathCluster>(cluster_rows * cluster_cols);
+  for (int cx = 0; cx < cluster_rows; cx++) {
+    for (int cy = 0; cy < cluster_cols; cy++) {
+      auto &cluster = clusters[cx * cluster_cols + cy];
+      auto x = cx * PATH_CLUSTER_SIZE;
+      auto y = cy * PATH_CLUSTER_SIZE;
+      cluster.area = Rect(x, y, min(PATH_CLUSTER_SIZE, rows - x),
+                          min(PATH_CLUSTER_SIZE, cols - y));
+    }
+  }
+  // the last two keys are the start and target of the current search.
+  auto num_keys = (int)clusters.size() * PATH_CLUSTER_MAX_NODES + 2;
+  key_generations = vector<uint32_t>(num_keys, 0);
+  g_costs = vector<int>(num_keys, 0);
+  came_from = vector<int>(num_keys, -1);
+  is_closed = vector<uint8_t>(num_keys, 0);
+  cluster_distances =
+      vector<int>(PATH_CLUSTER_SIZE * PATH_CLUSTER_SIZE, -1);
+}
+
+// A* over the cluster nodes. start and target are linked to the nodes of
+// their own clusters with a search inside the cluster, and to each other
+// if they share a cluster. Edge costs are real step counts so the
+// chebyshev heuristic never overestimates.
+bool PathClusterGraph::set_waypoints(const MoveGrid &move_grid, Vec2 start,
+                                     Vec2 target) {
+  waypoints.clear();
+  waypoints_found = false;
+  if (clusters.empty() || !move_grid.point_in_bounds(start) ||
+      !move_grid.point_in_bounds(target)) {
+    return false;
+  }
+  rebuild_dirty_clusters(move_grid);
+  auto start_cluster_idx = get_cluster_idx(start);
+  auto target_cluster_idx = get_cluster_idx(target);
+  set_costs_to_nodes(move_grid, start_cluster_idx, start, start_costs);
+  auto direct_cost = -1;
+  if (start_cluster_idx == target_cluster_idx) {
+    direct_cost = get_cluster_distance(clusters[start_cluster_idx], target);
+  }
+  set_costs_to_nodes(move_grid, target_cluster_idx, target, target_costs);
+
+  search_generation += 1;
+  if (search_generation == 0) {
+    fill(key_generations.begin(), key_generations.end(), 0);
+    search_generation = 1;
+  }
+  open_keys = priority_queue<pair<int, int>, vector<pair<int, int>>,
+                             greater<pair<int, int>>>();
+  auto start_key = (int)clusters.size() * PATH_CLUSTER_MAX_NODES;
+  auto target_key = start_key + 1;
+  open_key(start_key, -1, 0, start, target);
+
+  while (!open_keys.empty()) {
+    auto key = open_keys.top().second;
+    open_keys.pop();
+    if (is_closed[key]) {
+      continue;
+    }
+    is_closed[key] = 1;
+    if (key == target_key) {
+      waypoints_found = true;
+      break;
+    }
+    auto g_cost = g_costs[key];
+    if (key == start_key) {
+      auto &cluster = clusters[start_cluster_idx];
+      for (int i = 0; i < (int)cluster.nodes.size(); i++) {
+        if (start_costs[i] >= 0) {
+          open_key(start_cluster_idx * PATH_CLUSTER_MAX_NODES + i, key,
+                   g_cost + start_costs[i], cluster.nodes[i].p, target);
+        }
+      }
+      if (direct_cost >= 0) {
+        open_key(target_key, key, g_cost + direct_cost, target, target);
+      }
+      continue;
+    }
+    auto cluster_idx = key / PATH_CLUSTER_MAX_NODES;
+    auto node_idx = key % PATH_CLUSTER_MAX_NODES;
+    auto &cluster = clusters[cluster_idx];
+    auto num_nodes = (int)cluster.nodes.size();
+    auto &node = cluster.nodes[node_idx];
+    if (cluster_idx == target_cluster_idx && target_costs[node_idx] >= 0) {
+      open_key(target_key, key, g_cost + target_costs[node_idx], target,
+               target);
+    }
+    for (int j = 0; j < num_nodes; j++) {
+      auto cost = cluster.costs[node_idx * num_nodes + j];
+      if (j != node_idx && cost >= 0) {
+        open_key(cluster_idx * PATH_CLUSTER_MAX_NODES + j, key,
+                 g_cost + cost, cluster.nodes[j].p, target);
+      }
+    }
+    // the one step across the border into the neighbouring cluster.
+    auto partner_cluster_idx = get_cluster_idx(node.partner);
+    auto partner_idx = find_node_idx(partner_cluster_idx, node.partner, node.p);
+    if (partner_idx != -1) {
+      open_key(partner_cluster_idx * PATH_CLUSTER_MAX_NODES + partner_idx, key,
+               g_cost + 1, node.partner, target);
+    }
+  }
+  if (!waypoints_found) {
+    return false;
+  }
+  for (int key = target_key; key != start_key; key = came_from[key]) {
+    auto p = get_key_point(key, start, target);
+    if (waypoints.empty() || !(waypoints.back() == p)) {
+      waypoints.push_back(p);
+    }
+  }
+  reverse(waypoints.begin(), waypoints.end());
+  return true;
+}
+
+void PathClusterGraph::open_key(int key, int parent_key, int g_cost, Vec2 p,
+                                Vec2 target) {
+  if (key_generations[key] == search_generation) {
+    if (is_closed[key] || g_cost >= g_costs[key]) {
+      return;
+    }
+  } else {
+    key_generations[key] = search_generation;
+    is_closed[key] = 0;
+  }
+  g_costs[key] = g_cost;
+  came_from[key] = parent_key;
+  open_keys.push(make_pair(g_cost + chebyshev_distance(p, target), key));
+}
+
+// a hitbox anchored anywhere from w - 1 points left of the tile to the
+// tile's last point overlaps it, so those clusters and their neighbours
+// (whose border nodes pair with them) need rebuilding.
+void PathClusterGraph::mark_tile_dirty(Vec2 tile_point) {
+  if (clusters.empty()) {
+    return;
+  }
+  auto x_start = tile_point.x * MOVE_GRID_RATIO - (hit_box_dims.x - 1);
+  auto y_start = tile_point.y * MOVE_GRID_RATIO - (hit_box_dims.y - 1);
+  auto x_end = tile_point.x * MOVE_GRID_RATIO + MOVE_GRID_RATIO - 1;
+  auto y_end = tile_point.y * MOVE_GRID_RATIO + MOVE_GRID_RATIO - 1;
+  auto cx_start = max(0, max(0, x_start) / PATH_CLUSTER_SIZE - 1);
+  auto cy_start = max(0, max(0, y_start) / PATH_CLUSTER_SIZE - 1);
+  auto cx_end =
+      min(cluster_rows - 1, min(rows - 1, x_end) / PATH_CLUSTER_SIZE + 1);
+  auto cy_end =
+      min(cluster_cols - 1, min(cols - 1, y_end) / PATH_CLUSTER_SIZE + 1);
+  for (int cx = cx_start; cx <= cx_end; cx++) {
+    for (int cy = cy_start; cy <= cy_end; cy++) {
+      clusters[cx * cluster_cols + cy].is_dirty = true;
+    }
+  }
+}
+
+void PathClusterGraph::rebuild_dirty_clusters(const MoveGrid &move_grid) {
+  for (int i = 0; i < (int)clusters.size(); i++) {
+    if (clusters[i].is_dirty) {
+      build_cluster(move_grid, i);
+    }
+  }
+}
+
+void PathClusterGraph::build_cluster(const MoveGrid &move_grid,
+                                     int cluster_idx) {
+  auto &cluster = clusters[cluster_idx];
+  auto cx = cluster_idx / cluster_cols;
+  auto cy = cluster_idx % cluster_cols;
+  auto &area = cluster.area;
+  cluster.nodes.clear();
+  if (cx > 0) {
+    add_border_nodes(move_grid, cluster, Vec2(area.x, area.y), Vec2(0, 1),
+                     Vec2(-1, 0), area.h);
+  }
+  if (cx < cluster_rows - 1) {
+    add_border_nodes(move_grid, cluster, Vec2(area.x + area.w - 1, area.y),
+                     Vec2(0, 1), Vec2(1, 0), area.h);
+  }
+  if (cy > 0) {
+    add_border_nodes(move_grid, cluster, Vec2(area.x, area.y), Vec2(1, 0),
+                     Vec2(0, -1), area.w);
+  }
+  if (cy < cluster_cols - 1) {
+    add_border_nodes(move_grid, cluster, Vec2(area.x, area.y + area.h - 1),
+                     Vec2(1, 0), Vec2(0, 1), area.w);
+  }
+  auto num_nodes = (int)cluster.nodes.size();
+  cluster.costs.assign(num_nodes * num_nodes, -1);
+  for (int i = 0; i < num_nodes; i++) {
+    set_cluster_distances(move_grid, cluster, cluster.nodes[i].p);
+    for (int j = 0; j < num_nodes; j++) {
+      cluster.costs[i * num_nodes + j] =
+          get_cluster_distance(cluster, cluster.nodes[j].p);
+    }
+  }
+  cluster.is_dirty = false;
+}
+
+// an entrance is a run of border points where the hitbox fits on both
+// sides of the border.
+void PathClusterGraph::add_border_nodes(const MoveGrid &move_grid,
+                                        PathCluster &cluster,
+                                        Vec2 border_start, Vec2 along,
+                                        Vec2 across, int length) {
+  auto run_start = -1;
+  for (int i = 0; i <= length; i++) {
+    auto is_open = false;
+    if (i < length) {
+      auto p = Vec2(border_start.x + along.x * i, border_start.y + along.y * i);
+      auto partner = Vec2(p.x + across.x, p.y + across.y);
+      is_open = is_passable(move_grid, p) && is_passable(move_grid, partner);
+    }
+    if (is_open && run_start == -1) {
+      run_start = i;
+    } else if (!is_open && run_start != -1) {
+      auto run_end = i - 1;
+      vector<int> offsets;
+      if (run_end - run_start + 1 >= PATH_CLUSTER_LONG_ENTRANCE) {
+        offsets = {run_start, run_end};
+      } else {
+        offsets = {(run_start + run_end) / 2};
+      }
+      for (auto offset : offsets) {
+        GAME_ASSERT((int)cluster.nodes.size() < PATH_CLUSTER_MAX_NODES);
+        auto p = Vec2(border_start.x + along.x * offset,
+                      border_start.y + along.y * offset);
+        cluster.nodes.push_back(
+            PathClusterNode(p, Vec2(p.x + across.x, p.y + across.y)));
+      }
+      run_start = -1;
+    }
+  }
+}
+
+// breadth first search from a point without leaving the cluster, steps
+// are 8-connected and uniform cost like PathFinder.
+void PathClusterGraph::set_cluster_distances(const MoveGrid &move_grid,
+                                             const PathCluster &cluster,
+                                             Vec2 from) {
+  auto &area = cluster.area;
+  fill(cluster_distances.begin(), cluster_distances.end(), -1);
+  cluster_queue.clear();
+  if (!is_passable(move_grid, from)) {
+    return;
+  }
+  auto from_idx = (from.x - area.x) * area.h + (from.y - area.y);
+  cluster_distances[from_idx] = 0;
+  cluster_queue.push_back(from_idx);
+  for (int i = 0; i < (int)cluster_queue.size(); i++) {
+    auto idx = cluster_queue[i];
+    auto x = idx / area.h;
+    auto y = idx % area.h;
+    for (int dx = -1; dx <= 1; dx++) {
+      for (int dy = -1; dy <= 1; dy++) {
+        auto nx = x + dx;
+        auto ny = y + dy;
+        if ((dx == 0 && dy == 0) || nx < 0 || ny < 0 || nx >= area.w ||
+            ny >= area.h) {
+          continue;
+        }
+        auto n_idx = nx * area.h + ny;
+        if (cluster_distances[n_idx] != -1 ||
+            !is_passable(move_grid, Vec2(area.x + nx, area.y + ny))) {
+          continue;
+        }
+        cluster_distances[n_idx] = cluster_distances[idx] + 1;
+        cluster_queue.push_back(n_idx);
+      }
+    }
+  }
+}
+
+int PathClusterGraph::get_cluster_distance(const PathCluster &cluster,
+                                           Vec2 p) {
+  auto &area = cluster.area;
+  return cluster_distances[(p.x - area.x) * area.h + (p.y - area.y)];
+}
+
+void PathClusterGraph::set_costs_to_nodes(const MoveGrid &move_grid,
+                                          int cluster_idx, Vec2 from,
+                                          vector<int> &costs) {
+  auto &cluster = clusters[cluster_idx];
+  set_cluster_distances(move_grid, cluster, from);
+  costs.resize(cluster.nodes.size());
+  for (int i = 0; i < (int)cluster.nodes.size(); i++) {
+    costs[i] = get_cluster_distance(cluster, cluster.nodes[i].p);
+  }
+}
+
+// only obstacles count, the hitbox is anchored bottom left at p.
+bool PathClusterGraph::is_passable(const MoveGrid &move_grid, Vec2 p) {
+  return move_grid.rect_is_walkable(
+      Rect(p.x, p.y, hit_box_dims.x, hit_box_dims.y));
+}
+
+int PathClusterGraph::get_cluster_idx(Vec2 p) {
+  return (p.x / PATH_CLUSTER_SIZE) * cluster_cols + (p.y / PATH_CLUSTER_SIZE);
+}
+
+int PathClusterGraph::find_node_idx(int cluster_idx, Vec2 p, Vec2 partner) {
+  auto &nodes = clusters[cluster_idx].nodes;
+  for (int i = 0; i < (int)nodes.size(); i++) {
+    if (nodes[i].p == p && nodes[i].partner == partner) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+Vec2 PathClusterGraph::get_key_point(int key, Vec2 start, Vec2 target) {
+  auto start_key = (int)clusters.size() * PATH_CLUSTER_MAX_NODES;
+  if (key == start_key) {
+    return start;
+  }
+  if (key == start_key + 1) {
+    return target;
+  }
+  return clusters[key / PATH_CLUSTER_MAX_NODES]
+      .nodes[key % PATH_CLUSTER_MAX_NODES]
+      .p;
+}
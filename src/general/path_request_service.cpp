@@ -0,0 +1,164 @@
+#include "path_request_service.h"
+#include "map.h"
+#include "unit.h"
+
+PathRequestService::~PathRequestService() { stop(); }
+
+// leaves one core for the game thread.
+void PathRequestService::start() {
+  if (workers.size() > 0) {
+    return;
+  }
+  auto num_workers = (int)thread::hardware_concurrency() - 1;
+  num_workers = max(1, min(num_workers, PATH_REQUEST_MAX_WORKERS));
+  is_stopping = false;
+  path_workers = vector<PathWorker>(num_workers);
+  for (int i = 0; i < num_workers; i++) {
+    workers.emplace_back(&PathRequestService::run_worker, this, i);
+  }
+}
+
+// requests that haven't been picked up by a worker are dropped.
+void PathRequestService::stop() {
+  {
+    lock_guard<mutex> lock(requests_mutex);
+    is_stopping = true;
+  }
+  requests_cv.notify_all();
+  for (auto &worker : workers) {
+    worker.join();
+  }
+  workers.clear();
+  path_workers.clear();
+  requests = queue<PathRequest>();
+}
+
+// the search starts from start, which should be where the unit will be when
+// the result is delivered. If the service isn't started the search runs
+// right away, the result is still delivered by take_results.
+int PathRequestService::request_path(
+    Map &map, Unit &unit, Vec2 start, Vec2 target,
+    bool allow_units_to_path_through_each_other, PathFinderMode mode) {
+  auto request = PathRequest();
+  request.ticket = next_ticket;
+  next_ticket = next_ticket == INT32_MAX ? 0 : next_ticket + 1;
+  request.unit_handle = unit.handle;
+  request.start = start;
+  request.target = target;
+  request.hit_box = unit.sprite.get_tile_point_hit_box();
+  request.ignored_hit_box = map.occupancy_grid.get_unit_hit_box(unit.handle);
+  request.mode = mode;
+  request.allow_units_to_path_through_each_other =
+      allow_units_to_path_through_each_other;
+  if (move_grid_snapshot == nullptr ||
+      move_grid_snapshot->version != map.move_grid.version) {
+    move_grid_snapshot = make_shared<const MoveGrid>(map.move_grid);
+  }
+  request.move_grid = move_grid_snapshot;
+  if (!allow_units_to_path_through_each_other) {
+    auto &occupancy_grid = map.occupancy_grid;
+    if (occupancy_snapshot == nullptr ||
+        occupancy_snapshot->version != occupancy_grid.version) {
+      auto snapshot = make_shared<OccupancySnapshot>();
+      snapshot->version = occupancy_grid.version;
+      snapshot->rows = occupancy_grid.rows;
+      snapshot->cols = occupancy_grid.cols;
+      snapshot->unit_hit_boxes.reserve(occupancy_grid.unit_hit_boxes.size());
+      for (auto &unit_entry : occupancy_grid.unit_hit_boxes) {
+        snapshot->unit_hit_boxes.push_back(
+            make_pair(unit_entry.first, unit_entry.second));
+      }
+      occupancy_snapshot = snapshot;
+    }
+    request.occupancy_snapshot = occupancy_snapshot;
+  }
+
+  if (workers.size() == 0) {
+    auto result = find_path(request, game_thread_path_worker);
+    lock_guard<mutex> lock(requests_mutex);
+    results.push_back(result);
+    return request.ticket;
+  }
+
+  {
+    lock_guard<mutex> lock(requests_mutex);
+    requests.push(request);
+  }
+  requests_cv.notify_one();
+  return request.ticket;
+}
+
+// moves every finished result into _results.
+void PathRequestService::take_results(vector<PathResult> &_results) {
+  _results.clear();
+  lock_guard<mutex> lock(requests_mutex);
+  swap(_results, results);
+}
+
+void PathRequestService::run_worker(int worker_idx) {
+  auto &path_worker = path_workers[worker_idx];
+  while (true) {
+    auto request = PathRequest();
+    {
+      unique_lock<mutex> lock(requests_mutex);
+      requests_cv.wait(lock,
+                       [this]() { return is_stopping || !requests.empty(); });
+      if (is_stopping) {
+        return;
+      }
+      request = requests.front();
+      requests.pop();
+    }
+    auto result = find_path(request, path_worker);
+    lock_guard<mutex> lock(requests_mutex);
+    results.push_back(result);
+  }
+}
+
+// a new grid is only made when the map size changed, otherwise the last
+// snapshot's hitboxes are taken out and the request's put in.
+void PathRequestService::set_occupancy_grid(const PathRequest &request,
+                                            PathWorker &path_worker) {
+  auto &snapshot = request.occupancy_snapshot;
+  if (path_worker.occupancy_snapshot == snapshot) {
+    return;
+  }
+  auto &occupancy_grid = path_worker.occupancy_grid;
+  if (occupancy_grid.rows != snapshot->rows ||
+      occupancy_grid.cols != snapshot->cols) {
+    occupancy_grid = OccupancyGrid(snapshot->rows, snapshot->cols);
+  } else if (path_worker.occupancy_snapshot != nullptr) {
+    for (auto &unit_entry : path_worker.occupancy_snapshot->unit_hit_boxes) {
+      occupancy_grid.remove_unit(unit_entry.first);
+    }
+  }
+  for (auto &unit_entry : snapshot->unit_hit_boxes) {
+    occupancy_grid.add_unit(unit_entry.first, unit_entry.second);
+  }
+  path_worker.occupancy_snapshot = snapshot;
+}
+
+// only reads the request's snapshots, safe to call from any thread.
+PathResult PathRequestService::find_path(const PathRequest &request,
+                                         PathWorker &path_worker) {
+  auto &path_finder = path_worker.path_finder;
+  auto occupancy_grid = (const OccupancyGrid *)nullptr;
+  if (request.occupancy_snapshot != nullptr) {
+    set_occupancy_grid(request, path_worker);
+    occupancy_grid = &path_worker.occupancy_grid;
+  }
+  path_finder.find_path(*request.move_grid, occupancy_grid, request.hit_box,
+                        request.ignored_hit_box, request.start,
+                        request.target, request.mode);
+  auto result = PathResult();
+  result.ticket = request.ticket;
+  result.unit_handle = request.unit_handle;
+  result.start = request.start;
+  result.target = request.target;
+  result.allow_units_to_path_through_each_other =
+      request.allow_units_to_path_through_each_other;
+  result.path_found = path_finder.path_found;
+  result.closest_point_to_target = path_finder.closest_point_to_target;
+  result.path = path_finder.path;
+  return result;
+}
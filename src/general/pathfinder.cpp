@@ -1,98 +1,363 @@
 #include "pathfinder.h"
-#include "game.h"
-#include "map.h"
-#include "unit.h"
+#include <algorithm>
+#include <cmath>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 
 NodeF::NodeF() {
-  p = Vec2(0, 0);
+  idx = 0;
   f = 0;
+  h = 0;
 }
 
-NodeF::NodeF(Vec2 _p, int _f) {
-  p = _p;
+NodeF::NodeF(int _idx, int _f, int _h) {
+  idx = _idx;
   f = _f;
+  h = _h;
 }
 
 PathFinder::PathFinder() {
+  path_found = false;
   path = vector<Vec2>();
-  pq = priority_queue<NodeF, vector<NodeF>, CompareNodeF>();
-  closed_set = unordered_map<Vec2, bool, Vec2HashFunction>();
-  came_from = unordered_map<Vec2, Vec2, Vec2HashFunction>();
-  g_cost_map = unordered_map<Vec2, int, Vec2HashFunction>();
+  nodes_expanded = 0;
+  rows_move_grid = 0;
+  cols_move_grid = 0;
+  search_generation = 0;
+  node_generations = vector<uint32_t>();
+  g_costs = vector<int>();
+  came_from = vector<int>();
+  heap_positions = vector<int>();
+  open_heap = vector<NodeF>();
+  passable_generations = vector<uint32_t>();
+  passable_values = vector<uint8_t>();
+  move_grid = nullptr;
+  occupancy_grid = nullptr;
+  hit_box = Rect(0, 0, 0, 0);
+  ignored_hit_box = Rect(0, 0, 0, 0);
+  unsmoothed_path = vector<Vec2>();
+  walkable_jump_bits_version = 0;
+  walkable_jump_bits_hit_box_dims = Vec2(0, 0);
+  walkable_jump_bits = JumpBits();
+  unit_jump_bits = JumpBits();
+  jump_bits = nullptr;
+}
+
+// string pulling. From each corner the path is cut straight to the furthest
+// point (up to PATH_SMOOTHING_MAX_LOOKAHEAD ahead) that can be seen from it,
+// and cells is rewritten as the move grid points along those lines, so it
+// is still one point per step and never longer. corner_idxs are the indexes
+// in cells where a line ends, the last one is the end of the path. Adjacent
+// points are always kept, so paths that go through units stay valid.
+void PathFinder::smooth_path(const MoveGrid &_move_grid,
+                             const OccupancyGrid *_occupancy_grid,
+                             Rect _hit_box, Rect _ignored_hit_box, Vec2 start,
+                             vector<Vec2> &cells, vector<int> &corner_idxs) {
+  corner_idxs.clear();
+  if (cells.size() == 0) {
+    return;
+  }
+  move_grid = &_move_grid;
+  occupancy_grid = _occupancy_grid;
+  hit_box = _hit_box;
+  ignored_hit_box = _ignored_hit_box;
+  start_search(_move_grid.rows, _move_grid.cols);
+  unsmoothed_path = cells;
+  cells.clear();
+  auto corner = start;
+  auto num_points = (int)unsmoothed_path.size();
+  auto i = 0;
+  while (i < num_points) {
+    auto furthest_i = i;
+    for (int j = i + 1;
+         j < num_points && j - i < PATH_SMOOTHING_MAX_LOOKAHEAD; j++) {
+      if (has_line_of_sight(corner, unsmoothed_path[j])) {
+        furthest_i = j;
+      }
+    }
+    add_line_cells(corner, unsmoothed_path[furthest_i], cells);
+    corner_idxs.push_back((int)cells.size() - 1);
+    corner = unsmoothed_path[furthest_i];
+    i = furthest_i + 1;
+  }
+}
+
+// string pulling on the cluster graph's waypoints, a waypoint is dropped
+// when the one after it can be seen from the last waypoint kept, so the
+// refined path doesn't zig-zag through entrance midpoints. Only walls are
+// checked, units move before the unit gets there and the refining searches
+// go around them.
+void PathFinder::smooth_waypoints(const MoveGrid &_move_grid, Rect _hit_box,
+                                  Vec2 start, vector<Vec2> &waypoints) {
+  if (waypoints.size() < 2) {
+    return;
+  }
+  move_grid = &_move_grid;
+  occupancy_grid = nullptr;
+  hit_box = _hit_box;
+  ignored_hit_box = Rect(0, 0, 0, 0);
+  start_search(_move_grid.rows, _move_grid.cols);
+  auto corner = start;
+  auto num_kept = 0;
+  auto num_waypoints = (int)waypoints.size();
+  for (int i = 0; i < num_waypoints; i++) {
+    auto is_last = i == num_waypoints - 1;
+    if (is_last || !has_line_of_sight(corner, waypoints[i + 1])) {
+      corner = waypoints[i];
+      waypoints[num_kept] = corner;
+      num_kept += 1;
+    }
+  }
+  waypoints.resize(num_kept);
+}
+
+bool PathFinder::has_line_of_sight(Vec2 from, Vec2 to) {
+  auto steps = chebyshev_distance(from, to);
+  for (int i = 1; i <= steps; i++) {
+    auto p = Vec2(from.x + (int)lround((double)(to.x - from.x) * i / steps),
+                  from.y + (int)lround((double)(to.y - from.y) * i / steps));
+    if (!is_passable(p)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// the points on the line excluding from, one per step.
+void PathFinder::add_line_cells(Vec2 from, Vec2 to, vector<Vec2> &cells) {
+  auto steps = chebyshev_distance(from, to);
+  for (int i = 1; i <= steps; i++) {
+    cells.push_back(
+        Vec2(from.x + (int)lround((double)(to.x - from.x) * i / steps),
+             from.y + (int)lround((double)(to.y - from.y) * i / steps)));
+  }
+}
+
+// resizes the node arrays if the map size changed, otherwise bumps the
+// generation so that every node from the previous search reads as unvisited.
+void PathFinder::start_search(int _rows_move_grid, int _cols_move_grid) {
+  open_heap.clear();
+  auto num_nodes = _rows_move_grid * _cols_move_grid;
+  if (_rows_move_grid != rows_move_grid || _cols_move_grid != cols_move_grid ||
+      (int)node_generations.size() != num_nodes) {
+    rows_move_grid = _rows_move_grid;
+    cols_move_grid = _cols_move_grid;
+    node_generations.assign(num_nodes, 0);
+    g_costs.assign(num_nodes, 0);
+    came_from.assign(num_nodes, -1);
+    heap_positions.assign(num_nodes, NODE_CLOSED);
+    passable_generations.assign(num_nodes, 0);
+    passable_values.assign(num_nodes, 0);
+    search_generation = 0;
+  }
+  search_generation += 1;
+  // on wrap around old stamps could match again, so clear them once.
+  if (search_generation == 0) {
+    fill(node_generations.begin(), node_generations.end(), 0);
+    fill(passable_generations.begin(), passable_generations.end(), 0);
+    search_generation = 1;
+  }
+}
+
+int PathFinder::get_idx(Vec2 p) { return p.x * cols_move_grid + p.y; }
+
+Vec2 PathFinder::get_point(int idx) {
+  return Vec2(idx / cols_move_grid, idx % cols_move_grid);
+}
+
+// the unit's whole hitbox has to be clear of obstacles (and other units
+// unless they can path through each other), not just the point.
+bool PathFinder::is_passable(Vec2 p) {
+  if (p.x < 0 || p.x >= rows_move_grid || p.y < 0 || p.y >= cols_move_grid) {
+    return false;
+  }
+  auto idx = get_idx(p);
+  if (passable_generations[idx] != search_generation) {
+    auto moved_hit_box = hit_box;
+    moved_hit_box.x = p.x;
+    moved_hit_box.y = p.y;
+    passable_generations[idx] = search_generation;
+    passable_values[idx] =
+        move_grid->rect_is_walkable(moved_hit_box) &&
+        (occupancy_grid == nullptr ||
+         !occupancy_grid->rect_is_occupied(moved_hit_box, ignored_hit_box));
+  }
+  return passable_values[idx];
+}
+
+// keep track of closest point to the target. Used sometimes if the
+// path is not reached, and you want to move to the cloest point to
+// the target.
+void PathFinder::track_closest_point(Vec2 p, Vec2 target) {
+  auto dist = manhattan_distance(p, target);
+  if (dist < closest_point_dist) {
+    closest_point_dist = dist;
+    closest_point_to_target = p;
+  }
+}
+
+bool PathFinder::is_visited(int idx) {
+  return node_generations[idx] == search_generation;
+}
+
+void PathFinder::visit(int idx, int g_cost, int _came_from) {
+  node_generations[idx] = search_generation;
+  g_costs[idx] = g_cost;
+  came_from[idx] = _came_from;
+  heap_positions[idx] = NODE_CLOSED;
 }
 
-void PathFinder::clear_pq() {
-  while (!pq.empty()) {
-    pq.pop();
+// lower f first, then lower h so that equal cost nodes closer to the
+// target are expanded first.
+bool PathFinder::open_heap_less(const NodeF &n1, const NodeF &n2) {
+  if (n1.f != n2.f) {
+    return n1.f < n2.f;
   }
+  return n1.h < n2.h;
 }
 
-// get_path uses Point instead of Vec2 so that I can make == and
-// hash functions for the Point type without modifying Vec2. A
-// vector of Vec2 is returned however.
-void PathFinder::set_path(Game &game, Map &map, Unit &unit, Vec2 start,
-                          Vec2 target,
-                          bool allow_units_to_path_through_each_other) {
+void PathFinder::open_heap_swap(int i, int j) {
+  swap(open_heap[i], open_heap[j]);
+  heap_positions[open_heap[i].idx] = i;
+  heap_positions[open_heap[j].idx] = j;
+}
+
+void PathFinder::open_heap_sift_up(int heap_position) {
+  while (heap_position > 0) {
+    auto parent = (heap_position - 1) / 2;
+    if (!open_heap_less(open_heap[heap_position], open_heap[parent])) {
+      break;
+    }
+    open_heap_swap(heap_position, parent);
+    heap_position = parent;
+  }
+}
+
+void PathFinder::open_heap_sift_down(int heap_position) {
+  auto heap_size = (int)open_heap.size();
+  while (true) {
+    auto left = heap_position * 2 + 1;
+    auto right = left + 1;
+    auto smallest = heap_position;
+    if (left < heap_size &&
+        open_heap_less(open_heap[left], open_heap[smallest])) {
+      smallest = left;
+    }
+    if (right < heap_size &&
+        open_heap_less(open_heap[right], open_heap[smallest])) {
+      smallest = right;
+    }
+    if (smallest == heap_position) {
+      break;
+    }
+    open_heap_swap(heap_position, smallest);
+    heap_position = smallest;
+  }
+}
+
+void PathFinder::open_heap_push(NodeF node) {
+  open_heap.push_back(node);
+  auto heap_position = (int)open_heap.size() - 1;
+  heap_positions[node.idx] = heap_position;
+  open_heap_sift_up(heap_position);
+}
+
+NodeF PathFinder::open_heap_pop() {
+  auto top = open_heap[0];
+  open_heap_swap(0, (int)open_heap.size() - 1);
+  open_heap.pop_back();
+  heap_positions[top.idx] = NODE_CLOSED;
+  nodes_expanded += 1;
+  if (open_heap.size() > 0) {
+    open_heap_sift_down(0);
+  }
+  return top;
+}
+
+void PathFinder::open_heap_decrease_key(int heap_position, int f) {
+  open_heap[heap_position].f = f;
+  open_heap_sift_up(heap_position);
+}
+
+// path excludes the start and includes the target. if the target can't be
+// reached path is empty and closest_point_to_target is the closest point
+// to the target (by manhattan distance) the search got to.
+void PathFinder::find_path(const MoveGrid &_move_grid,
+                           const OccupancyGrid *_occupancy_grid,
+                           Rect _hit_box, Rect _ignored_hit_box, Vec2 start,
+                           Vec2 target, PathFinderMode mode) {
   path_found = false;
-  int closest_point_dist = manhattan_distance(start, target);
+  closest_point_dist = manhattan_distance(start, target);
   closest_point_to_target = start;
   path.clear();
-  clear_pq();
-  closed_set.clear();
-  came_from.clear();
-  g_cost_map.clear();
-  auto iters = 0;
-  auto max_iters = 5000;
+  nodes_expanded = 0;
+  num_scans = 0;
+  move_grid = &_move_grid;
+  occupancy_grid = _occupancy_grid;
+  hit_box = _hit_box;
+  ignored_hit_box = _ignored_hit_box;
 
-  if (!game.map.point_in_bounds_move_grid(target)) {
+  if (!move_grid->point_in_bounds(target) ||
+      !move_grid->point_in_bounds(start)) {
     return;
   }
 
-  auto start_point = Vec2(start.x, start.y);
-  auto target_point = Vec2(target.x, target.y);
-  pq.push(NodeF(start_point, manhattan_distance(start, target)));
-  g_cost_map[start_point] = 0;
-  while (pq.size() > 0 && iters < 5000) {
-    iters += 1;
-
-    auto current_pair = pq.top();
-    pq.pop();
-    auto current = current_pair.p;
-    // auto current_height = tiles[current.x][current.y].height;
+  start_search(move_grid->rows, move_grid->cols);
+  switch (mode) {
+  case PathFinderMode::AStar: {
+    a_star(start, target);
+    break;
+  }
+  case PathFinderMode::JumpPoint: {
+    jump_point_search(start, target);
+    break;
+  }
+  default: {
+    cout << "PathFinder::find_path. mode not handled " << (int)mode << "\n";
+    abort();
+  }
+  }
+}
 
-    // add current to closed set
-    if (closed_set.find(current) == closed_set.end()) {
-      closed_set[current] = true;
-    } else {
-      // node is in closed set and has already been considered, continue
-      continue;
+// opens a node, or if a cheaper way to an open node was found goes through
+// that instead (moving it up the heap if its f went down). nodes are never
+// reopened.
+void PathFinder::add_node(int idx, int parent_idx, int g_cost, int f, int h) {
+  if (is_visited(idx) &&
+      (heap_positions[idx] == NODE_CLOSED || g_cost >= g_costs[idx])) {
+    return;
+  }
+  if (is_visited(idx)) {
+    g_costs[idx] = g_cost;
+    came_from[idx] = parent_idx;
+    if (f < open_heap[heap_positions[idx]].f) {
+      open_heap_decrease_key(heap_positions[idx], f);
     }
+  } else {
+    visit(idx, g_cost, parent_idx);
+    open_heap_push(NodeF(idx, f, h));
+  }
+}
 
-    // keep track of closest point to the target. Used sometimes if the
-    // path is not reached, and you want to move to the cloest point to
-    // the target.
-    auto dist = manhattan_distance(current, target);
-    if (dist < closest_point_dist) {
-      closest_point_dist = dist;
-      closest_point_to_target = current;
-    }
+// A* over the move grid. Steps in all 8 directions cost 1, so the
+// chebyshev distance to the target never overestimates and paths are the
+// shortest, ties on f go to the node closest to the target.
+void PathFinder::a_star(Vec2 start, Vec2 target) {
+  auto start_idx = get_idx(start);
+  auto target_idx = get_idx(target);
+  auto iters = 0;
+  auto start_h = chebyshev_distance(start, target);
+  add_node(start_idx, -1, 0, start_h, start_h);
+  while (open_heap.size() > 0 && iters < PATH_FINDER_MAX_ITERS) {
+    iters += 1;
+
+    auto current_idx = open_heap_pop().idx;
+    auto current = get_point(current_idx);
+    track_closest_point(current, target);
 
-    if (current == target_point) {
+    if (current_idx == target_idx) {
       path_found = true;
-      // insert final point in front first (will be at end after everything
-      // else is inserted)
-      path.insert(path.begin(), target);
-      auto came_from_iter = came_from.find(current);
-      while (came_from_iter != came_from.end()) {
-        current = came_from[current];
-        // skip start point
-        if (current == start) {
-          break;
-        } else {
-          path.insert(path.begin(), current);
-          came_from_iter = came_from.find(current);
-        }
-      }
+      set_path_from_came_from(start_idx, target_idx);
       return;
     }
 
@@ -102,36 +367,412 @@ void PathFinder::set_path(Game &game, Map &map, Unit &unit, Vec2 start,
         Vec2(current.x - 1, current.y - 1), Vec2(current.x + 1, current.y + 1),
         Vec2(current.x + 1, current.y - 1), Vec2(current.x - 1, current.y + 1),
     };
+    auto new_g_cost = g_costs[current_idx] + 1;
     for (auto n : neighbors) {
-      auto dist = manhattan_distance(start, n);
-      if (closed_set.find(n) != closed_set.end()) {
-        continue;
+      if (is_passable(n)) {
+        auto h = chebyshev_distance(n, target);
+        add_node(get_idx(n), current_idx, new_g_cost, new_g_cost + h, h);
       }
-      // the hitbox of the unit if they were to go to this tile
-      auto unit_tile_point_hit_box_cpy = unit.sprite.tile_point_hit_box;
-      unit_tile_point_hit_box_cpy.x = n.x;
-      unit_tile_point_hit_box_cpy.y = n.y;
-      auto tile_point = move_grid_point_to_tile_point(n);
-      // cout << n.x << " " << n.y << " " << tile_point.x << " " << tile_point.y
-      // << "\n";
-      auto tile_idx = twod_to_oned_idx(tile_point, game.map.rows);
-      if (!game.map.point_in_bounds_move_grid(n)) {
-        continue;
-      } else if (game.map.tiles[tile_idx].is_obstacle) {
-        continue;
-      } else if (!allow_units_to_path_through_each_other &&
-                 game.map.unit_occupies_tile_point_move_grid(
-                     game, unit_tile_point_hit_box_cpy, unit.guid)) {
+    }
+  }
+}
+
+// jump point search (Harabor and Grastien). Only the nodes where the
+// path has to turn (jump points) go into the open set, the points in
+// between are scanned by jump and filled back in when the path is built.
+// Jumps read passability from bitmaps (see set_jump_bits) so a straight
+// scan tests 64 points at a time. Every block of points scanned and every
+// diagonal step counts towards PATH_FINDER_MAX_SCANS.
+void PathFinder::jump_point_search(Vec2 start, Vec2 target) {
+  set_jump_bits();
+  auto start_idx = get_idx(start);
+  auto target_idx = get_idx(target);
+  auto iters = 0;
+  auto start_h = chebyshev_distance(start, target);
+  add_node(start_idx, -1, 0, start_h, start_h);
+  while (open_heap.size() > 0 && iters < PATH_FINDER_MAX_ITERS &&
+         num_scans < PATH_FINDER_MAX_SCANS) {
+    iters += 1;
+
+    auto current_idx = open_heap_pop().idx;
+    auto current = get_point(current_idx);
+    track_closest_point(current, target);
+
+    if (current_idx == target_idx) {
+      path_found = true;
+      set_path_from_came_from(start_idx, target_idx);
+      return;
+    }
+
+    array<Vec2, 8> dirs;
+    auto num_dirs = get_jump_point_dirs(current, came_from[current_idx], dirs);
+    for (int i = 0; i < num_dirs; i++) {
+      auto jump_point_idx = jump(current, dirs[i], target);
+      if (jump_point_idx == -1) {
         continue;
       }
-      auto new_g_cost = g_cost_map[current] + 1;
-      auto g_cost_iter = g_cost_map.find(n);
-      if (g_cost_iter == g_cost_map.end() || new_g_cost < g_cost_map[n]) {
-        auto f = manhattan_distance(n, target);
-        g_cost_map[n] = new_g_cost;
-        pq.push(NodeF(n, f));
-        came_from[n] = current;
+      auto jump_point = get_point(jump_point_idx);
+      auto g_cost =
+          g_costs[current_idx] + chebyshev_distance(current, jump_point);
+      auto h = chebyshev_distance(jump_point, target);
+      add_node(jump_point_idx, current_idx, g_cost, g_cost + h, h);
+    }
+  }
+}
+
+JumpBits::JumpBits() {
+  rows = 0;
+  cols = 0;
+  words_per_row = 0;
+  words_per_col = 0;
+  passable_by_row = vector<uint64_t>();
+  passable_by_col = vector<uint64_t>();
+  inc_stops_by_row = vector<uint64_t>();
+  dec_stops_by_row = vector<uint64_t>();
+  inc_stops_by_col = vector<uint64_t>();
+  dec_stops_by_col = vector<uint64_t>();
+}
+
+// everything blocked
+void JumpBits::init(int _rows, int _cols) {
+  rows = _rows;
+  cols = _cols;
+  words_per_row = (cols + 63) / 64;
+  words_per_col = (rows + 63) / 64;
+  passable_by_row.assign(rows * words_per_row, 0);
+  passable_by_col.assign(cols * words_per_col, 0);
+}
+
+void JumpBits::set_passable(Vec2 p) {
+  passable_by_row[p.x * words_per_row + (p.y >> 6)] |= (uint64_t)1
+                                                       << (p.y & 63);
+  passable_by_col[p.y * words_per_col + (p.x >> 6)] |= (uint64_t)1
+                                                       << (p.x & 63);
+}
+
+// clears bits [i_start, i_end) of the line starting at line_start.
+static void clear_bits(vector<uint64_t> &bits, int line_start, int i_start,
+                       int i_end) {
+  auto i = i_start;
+  while (i < i_end) {
+    auto bit = i & 63;
+    auto num_bits = min(64 - bit, i_end - i);
+    auto mask = num_bits == 64 ? ~(uint64_t)0
+                               : (((uint64_t)1 << num_bits) - 1) << bit;
+    bits[line_start + (i >> 6)] &= ~mask;
+    i += num_bits;
+  }
+}
+
+void JumpBits::set_blocked(Rect area) {
+  auto x_start = max(area.x, 0);
+  auto x_end = min(area.x + area.w, rows);
+  auto y_start = max(area.y, 0);
+  auto y_end = min(area.y + area.h, cols);
+  if (x_start >= x_end || y_start >= y_end) {
+    return;
+  }
+  for (int x = x_start; x < x_end; x++) {
+    clear_bits(passable_by_row, x * words_per_row, y_start, y_end);
+  }
+  for (int y = y_start; y < y_end; y++) {
+    clear_bits(passable_by_col, y * words_per_col, x_start, x_end);
+  }
+}
+
+bool JumpBits::is_passable(int x, int y) const {
+  if (x < 0 || x >= rows || y < 0 || y >= cols) {
+    return false;
+  }
+  auto word = passable_by_row[x * words_per_row + (y >> 6)];
+  return (word >> (y & 63)) & 1;
+}
+
+// where a straight scan along a line stops: points that are blocked, and
+// points with a forced neighbour (the point beside it on the next line
+// over is blocked and the one after that in the scan direction isn't).
+// The bits past the end of a line are blocked so every scan stops.
+static void set_stops(const vector<uint64_t> &passable, int num_lines,
+                      int words_per_line, vector<uint64_t> &inc_stops,
+                      vector<uint64_t> &dec_stops) {
+  inc_stops.assign(passable.size(), 0);
+  dec_stops.assign(passable.size(), 0);
+  auto get_word = [&](int line, int i) {
+    if (line < 0 || line >= num_lines || i < 0 || i >= words_per_line) {
+      return (uint64_t)0;
+    }
+    return passable[line * words_per_line + i];
+  };
+  for (int line = 0; line < num_lines; line++) {
+    for (int i = 0; i < words_per_line; i++) {
+      auto inc_forced = (uint64_t)0;
+      auto dec_forced = (uint64_t)0;
+      for (auto side_line : {line - 1, line + 1}) {
+        auto side = get_word(side_line, i);
+        // bit j is the point after / before j
+        auto side_next = (side >> 1) | (get_word(side_line, i + 1) << 63);
+        auto side_prev = (side << 1) | (get_word(side_line, i - 1) >> 63);
+        inc_forced |= ~side & side_next;
+        dec_forced |= ~side & side_prev;
+      }
+      auto blocked = ~get_word(line, i);
+      inc_stops[line * words_per_line + i] = blocked | inc_forced;
+      dec_stops[line * words_per_line + i] = blocked | dec_forced;
+    }
+  }
+}
+
+void JumpBits::set_stops() {
+  ::set_stops(passable_by_row, rows, words_per_row, inc_stops_by_row,
+              dec_stops_by_row);
+  ::set_stops(passable_by_col, cols, words_per_col, inc_stops_by_col,
+              dec_stops_by_col);
+}
+
+// bits isn't 0
+static int get_lowest_bit(uint64_t bits) {
+#ifdef _MSC_VER
+  unsigned long idx;
+  _BitScanForward64(&idx, bits);
+  return (int)idx;
+#else
+  return __builtin_ctzll(bits);
+#endif
+}
+
+// bits isn't 0
+static int get_highest_bit(uint64_t bits) {
+#ifdef _MSC_VER
+  unsigned long idx;
+  _BitScanReverse64(&idx, bits);
+  return (int)idx;
+#else
+  return 63 - __builtin_clzll(bits);
+#endif
+}
+
+// scans from (x, y) (in the grid) in a straight dir. Returns the distance
+// to the first point with a forced neighbour, or if a blocked point comes
+// first minus the number of passable points before it. Each word of stops
+// read counts as a scan.
+int JumpBits::scan_straight(int x, int y, int dx, int dy,
+                            int &num_scans) const {
+  auto is_along_x = dx != 0;
+  auto step = is_along_x ? dx : dy;
+  auto &stops = is_along_x ? (step > 0 ? inc_stops_by_col : dec_stops_by_col)
+                           : (step > 0 ? inc_stops_by_row : dec_stops_by_row);
+  auto words_per_line = is_along_x ? words_per_col : words_per_row;
+  auto line_len = is_along_x ? rows : cols;
+  auto line_start = (is_along_x ? y : x) * words_per_line;
+  auto i = is_along_x ? x : y;
+  // the first stop after i, or off the end of the line
+  auto stop = step > 0 ? line_len : -1;
+  if (step > 0 && i + 1 < line_len) {
+    auto word_idx = (i + 1) >> 6;
+    auto word = stops[line_start + word_idx] & (~(uint64_t)0 << ((i + 1) & 63));
+    num_scans += 1;
+    while (word == 0 && word_idx + 1 < words_per_line) {
+      word_idx += 1;
+      word = stops[line_start + word_idx];
+      num_scans += 1;
+    }
+    if (word != 0) {
+      stop = word_idx * 64 + get_lowest_bit(word);
+    }
+  } else if (step < 0 && i - 1 >= 0) {
+    auto word_idx = (i - 1) >> 6;
+    auto word =
+        stops[line_start + word_idx] & (~(uint64_t)0 >> (63 - ((i - 1) & 63)));
+    num_scans += 1;
+    while (word == 0 && word_idx > 0) {
+      word_idx -= 1;
+      word = stops[line_start + word_idx];
+      num_scans += 1;
+    }
+    if (word != 0) {
+      stop = word_idx * 64 + get_highest_bit(word);
+    }
+  }
+  auto stop_dist = (stop - i) * step;
+  if (!is_passable(x + dx * stop_dist, y + dy * stop_dist)) {
+    return -(stop_dist - 1);
+  }
+  return stop_dist;
+}
+
+// the passability bitmaps only change with the move grid and the hitbox
+// size so they are kept between searches. A search that has to avoid
+// units copies them and blocks the points where the hitbox would overlap
+// a unit, which is the unit's hitbox grown down and left by the size of
+// the hitbox. The searching unit (ignored_hit_box) is skipped once, like
+// rect_is_occupied does.
+void PathFinder::set_jump_bits() {
+  auto hit_box_dims = Vec2(hit_box.w, hit_box.h);
+  if (walkable_jump_bits_version != move_grid->version ||
+      !(walkable_jump_bits_hit_box_dims == hit_box_dims)) {
+    walkable_jump_bits_version = move_grid->version;
+    walkable_jump_bits_hit_box_dims = hit_box_dims;
+    walkable_jump_bits.init(rows_move_grid, cols_move_grid);
+    auto moved_hit_box = hit_box;
+    for (int x = 0; x < rows_move_grid; x++) {
+      for (int y = 0; y < cols_move_grid; y++) {
+        moved_hit_box.x = x;
+        moved_hit_box.y = y;
+        if (move_grid->rect_is_walkable(moved_hit_box)) {
+          walkable_jump_bits.set_passable(Vec2(x, y));
+        }
       }
     }
+    walkable_jump_bits.set_stops();
+  }
+  jump_bits = &walkable_jump_bits;
+  if (occupancy_grid == nullptr || hit_box.w <= 0 || hit_box.h <= 0) {
+    return;
+  }
+
+  unit_jump_bits.rows = walkable_jump_bits.rows;
+  unit_jump_bits.cols = walkable_jump_bits.cols;
+  unit_jump_bits.words_per_row = walkable_jump_bits.words_per_row;
+  unit_jump_bits.words_per_col = walkable_jump_bits.words_per_col;
+  unit_jump_bits.passable_by_row = walkable_jump_bits.passable_by_row;
+  unit_jump_bits.passable_by_col = walkable_jump_bits.passable_by_col;
+  auto is_ignored_skipped = ignored_hit_box.w <= 0 || ignored_hit_box.h <= 0;
+  for (auto &unit_entry : occupancy_grid->unit_hit_boxes) {
+    if (!is_ignored_skipped && unit_entry.second == ignored_hit_box) {
+      is_ignored_skipped = true;
+      continue;
+    }
+    auto unit_hit_box = occupancy_grid->clip_rect(unit_entry.second);
+    if (unit_hit_box.w <= 0 || unit_hit_box.h <= 0) {
+      continue;
+    }
+    unit_jump_bits.set_blocked(Rect(unit_hit_box.x - hit_box.w + 1,
+                                    unit_hit_box.y - hit_box.h + 1,
+                                    unit_hit_box.w + hit_box.w - 1,
+                                    unit_hit_box.h + hit_box.h - 1));
+  }
+  unit_jump_bits.set_stops();
+  jump_bits = &unit_jump_bits;
+}
+
+// the directions worth searching from p given the direction it was reached
+// from: straight on, the components of a diagonal, and the forced
+// neighbours around obstacles next to p. The start searches all 8.
+int PathFinder::get_jump_point_dirs(Vec2 p, int parent_idx,
+                                    array<Vec2, 8> &dirs) {
+  if (parent_idx == -1) {
+    dirs = {Vec2(1, 0),  Vec2(-1, 0), Vec2(0, 1),  Vec2(0, -1),
+            Vec2(-1, -1), Vec2(1, 1),  Vec2(1, -1), Vec2(-1, 1)};
+    return 8;
   }
-}
\ No newline at end of file
+  auto parent = get_point(parent_idx);
+  auto dx = (p.x > parent.x) - (p.x < parent.x);
+  auto dy = (p.y > parent.y) - (p.y < parent.y);
+  auto num_dirs = 0;
+  if (dx != 0 && dy != 0) {
+    dirs[num_dirs++] = Vec2(dx, dy);
+    dirs[num_dirs++] = Vec2(dx, 0);
+    dirs[num_dirs++] = Vec2(0, dy);
+    if (!jump_bits->is_passable(p.x - dx, p.y)) {
+      dirs[num_dirs++] = Vec2(-dx, dy);
+    }
+    if (!jump_bits->is_passable(p.x, p.y - dy)) {
+      dirs[num_dirs++] = Vec2(dx, -dy);
+    }
+  } else if (dx != 0) {
+    dirs[num_dirs++] = Vec2(dx, 0);
+    if (!jump_bits->is_passable(p.x, p.y + 1)) {
+      dirs[num_dirs++] = Vec2(dx, 1);
+    }
+    if (!jump_bits->is_passable(p.x, p.y - 1)) {
+      dirs[num_dirs++] = Vec2(dx, -1);
+    }
+  } else {
+    dirs[num_dirs++] = Vec2(0, dy);
+    if (!jump_bits->is_passable(p.x + 1, p.y)) {
+      dirs[num_dirs++] = Vec2(1, dy);
+    }
+    if (!jump_bits->is_passable(p.x - 1, p.y)) {
+      dirs[num_dirs++] = Vec2(-1, dy);
+    }
+  }
+  return num_dirs;
+}
+
+// the first jump point from p in dir: the target, a point with a forced
+// neighbour, or for a diagonal a point a straight jump from finds one.
+// Returns its idx, or -1 if something blocks the way first.
+int PathFinder::jump(Vec2 p, Vec2 dir, Vec2 target) {
+  auto dx = dir.x;
+  auto dy = dir.y;
+  if (dx == 0 || dy == 0) {
+    return jump_straight(p.x, p.y, dx, dy, target);
+  }
+  auto x = p.x;
+  auto y = p.y;
+  while (num_scans < PATH_FINDER_MAX_SCANS) {
+    num_scans += 1;
+    x += dx;
+    y += dy;
+    if (!jump_bits->is_passable(x, y)) {
+      return -1;
+    }
+    track_closest_point(Vec2(x, y), target);
+    if (x == target.x && y == target.y) {
+      return get_idx(target);
+    }
+    if ((jump_bits->is_passable(x - dx, y + dy) &&
+         !jump_bits->is_passable(x - dx, y)) ||
+        (jump_bits->is_passable(x + dx, y - dy) &&
+         !jump_bits->is_passable(x, y - dy)) ||
+        jump_straight(x, y, dx, 0, target) != -1 ||
+        jump_straight(x, y, 0, dy, target) != -1) {
+      return x * cols_move_grid + y;
+    }
+  }
+  return -1;
+}
+
+int PathFinder::jump_straight(int x, int y, int dx, int dy, Vec2 target) {
+  auto dist = jump_bits->scan_straight(x, y, dx, dy, num_scans);
+  auto num_passable = dist > 0 ? dist : -dist;
+  // the closest point to the target on the scanned line
+  if (num_passable > 0) {
+    auto t = dx != 0 ? (target.x - x) * dx : (target.y - y) * dy;
+    t = max(1, min(t, num_passable));
+    track_closest_point(Vec2(x + dx * t, y + dy * t), target);
+  }
+  auto is_target_on_line = dx != 0 ? target.y == y : target.x == x;
+  auto target_dist = dx != 0 ? (target.x - x) * dx : (target.y - y) * dy;
+  if (is_target_on_line && target_dist > 0 && target_dist <= num_passable) {
+    return get_idx(target);
+  }
+  if (dist > 0) {
+    return (x + dx * dist) * cols_move_grid + y + dy * dist;
+  }
+  return -1;
+}
+
+// walks came_from back from the target, filling in every point between
+// nodes (jump points can be far apart, A* nodes are always adjacent). The
+// target is always in the path, even if it is the start.
+void PathFinder::set_path_from_came_from(int start_idx, int target_idx) {
+  path.clear();
+  if (start_idx == target_idx) {
+    path.push_back(get_point(target_idx));
+    return;
+  }
+  auto idx = target_idx;
+  while (idx != start_idx) {
+    auto p = get_point(idx);
+    auto parent = get_point(came_from[idx]);
+    auto dx = (parent.x > p.x) - (parent.x < p.x);
+    auto dy = (parent.y > p.y) - (parent.y < p.y);
+    while (!(p == parent)) {
+      path.push_back(p);
+      p = Vec2(p.x + dx, p.y + dy);
+    }
+    idx = came_from[idx];
+  }
+  reverse(path.begin(), path.end());
+}
@@ -0,0 +1,16 @@
+#include "pathfinder.h"
+#include "map.h"
+#include "unit.h"
+
+void PathFinder::set_path(Map &map, Unit &unit, Vec2 start, Vec2 target,
+                          bool allow_units_to_path_through_each_other,
+                          PathFinderMode mode) {
+  const OccupancyGrid *_occupancy_grid = &map.occupancy_grid;
+  if (allow_units_to_path_through_each_other) {
+    _occupancy_grid = nullptr;
+  }
+  find_path(map.move_grid, _occupancy_grid,
+            unit.sprite.get_tile_point_hit_box(),
+            map.occupancy_grid.get_unit_hit_box(unit.handle), start, target,
+            mode);
+}
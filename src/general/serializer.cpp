@@ -3,6 +3,21 @@
 #include "dialogue.h"
 #include "game.h"
 #include "tween.h"
+#include <boost/uuid/nil_generator.hpp>
+
+// the plain data parts of a unit, see reflect.h. Only the serializer reads
+// them so they are declared here instead of with the structs.
+template <> struct Reflect<Dialogue> {
+  static constexpr auto fields = make_tuple(
+      reflect_field("game_flag_condition", &Dialogue::game_flag_condition),
+      reflect_field("strs", &Dialogue::strs));
+};
+
+template <> struct Reflect<AIWalkPath> {
+  static constexpr auto fields =
+      make_tuple(reflect_field("delay", &AIWalkPath::delay),
+                 reflect_field("target_point", &AIWalkPath::target_point));
+};
 
 Serializer::Serializer() {
   doc = Document();
@@ -47,51 +62,46 @@ void Serializer::serialize_string_val(const char *key, string value) {
 
 void Serializer::serialize_double_point(const char *key, DoublePoint &value) {
   writer.String(key);
-  writer.StartObject();
-  serialize_double("x", value.x);
-  serialize_double("y", value.y);
-  writer.EndObject();
+  reflect_serialize(writer, value);
 }
 
 void Serializer::deserialize_double_point(GenericObject<false, Value> &obj,
                                           const char *key, DoublePoint &value) {
-  auto point_obj = obj[key].GetObject();
-  value.x = point_obj["x"].GetDouble();
-  value.y = point_obj["y"].GetDouble();
+  reflect_deserialize(obj[key], value);
 }
 
 void Serializer::serialize_vec2(const char *key, Vec2 &value) {
   writer.String(key);
-  writer.StartObject();
-  serialize_int("x", value.x);
-  serialize_int("y", value.y);
-  writer.EndObject();
+  reflect_serialize(writer, value);
 }
 
 void Serializer::deserialize_vec2(GenericObject<false, Value> &obj,
                                   const char *key, Vec2 &value) {
-  auto vec_obj = obj[key].GetObject();
-  value.x = vec_obj["x"].GetInt();
-  value.y = vec_obj["y"].GetInt();
+  reflect_deserialize(obj[key], value);
+}
+
+void Serializer::serialize_vec2_vec(const char *key, vector<Vec2> &values) {
+  writer.String(key);
+  reflect_write_json_value(writer, values);
+}
+
+void Serializer::deserialize_vec2_vec(GenericObject<false, Value> &obj,
+                                      const char *key, vector<Vec2> &values) {
+  values.clear();
+  // older files don't have every vec2 vec
+  if (obj.HasMember(key)) {
+    reflect_read_json_value(obj[key], values);
+  }
 }
 
 void Serializer::serialize_rect(const char *key, Rect &value) {
   writer.String(key);
-  writer.StartObject();
-  serialize_int("x", value.x);
-  serialize_int("y", value.y);
-  serialize_int("w", value.w);
-  serialize_int("h", value.h);
-  writer.EndObject();
+  reflect_serialize(writer, value);
 }
 
 void Serializer::deserialize_rect(GenericObject<false, Value> &obj,
                                   const char *key, Rect &value) {
-  auto rect_obj = obj[key].GetObject();
-  value.x = rect_obj["x"].GetInt();
-  value.y = rect_obj["y"].GetInt();
-  value.w = rect_obj["w"].GetInt();
-  value.h = rect_obj["h"].GetInt();
+  reflect_deserialize(obj[key], value);
 }
 
 void Serializer::serialize_sprite_src_vec(const char *key,
@@ -128,71 +138,37 @@ void Serializer::deserialize_sprite_src_vec(GenericObject<false, Value> &obj,
 
 void Serializer::serialize_dialogues(vector<Dialogue> &dialogues) {
   writer.String("dialogues");
-  writer.StartArray();
-  for (auto &dialogue : dialogues) {
-    writer.StartObject();
-    serialize_int("game_flag_condition", (int)dialogue.game_flag_condition);
-    writer.String("strs");
-    writer.StartArray();
-    for (auto &str : dialogue.strs) {
-      writer.String(str.c_str(), str.size());
-    }
-    writer.EndArray();
-    writer.EndObject();
-  }
-  writer.EndArray();
+  reflect_write_json_value(writer, dialogues);
 }
 
 void Serializer::deserialize_dialogues(GenericObject<false, Value> &obj,
                                        vector<Dialogue> &dialogues) {
   // make sure json object has dialogues first
   if (obj.HasMember("dialogues")) {
-    for (auto &dialogue_obj : obj["dialogues"].GetArray()) {
-      Dialogue dialogue;
-      auto game_flag_condition = dialogue_obj["game_flag_condition"].GetInt();
-      dialogue.game_flag_condition = static_cast<GameFlag>(game_flag_condition);
-      auto dialogue_strs_array = dialogue_obj["strs"].GetArray();
-      for (auto &str_obj : dialogue_strs_array) {
-        auto str = str_obj.GetString();
-        dialogue.strs.push_back(str);
-      }
-      dialogues.push_back(dialogue);
-    }
+    reflect_read_json_value(obj["dialogues"], dialogues);
   }
 }
 
 void Serializer::serialize_ai_walk_paths(vector<AIWalkPath> &ai_walk_paths) {
   writer.String("ai_walk_paths");
-  writer.StartArray();
-  for (auto &ai_walk_path : ai_walk_paths) {
-    writer.StartObject();
-    serialize_uint("delay", ai_walk_path.delay);
-    serialize_vec2("target_point", ai_walk_path.target_point);
-    writer.EndObject();
-  }
-  writer.EndArray();
+  reflect_write_json_value(writer, ai_walk_paths);
 }
 
 void Serializer::deserialize_ai_walk_paths(GenericObject<false, Value> &obj,
                                            vector<AIWalkPath> &ai_walk_paths) {
   // make sure json object has ai_walk_paths first
   if (obj.HasMember("ai_walk_paths")) {
-    auto ai_walk_path_array = obj["ai_walk_paths"].GetArray();
-    for (auto &ai_walk_path_obj : ai_walk_path_array) {
-      AIWalkPath ai_walk_path;
-      ai_walk_path.delay = ai_walk_path_obj["delay"].GetUint();
-      deserialize_vec2(obj, "target_point", ai_walk_path.target_point);
-      ai_walk_paths.push_back(ai_walk_path);
-    }
+    reflect_read_json_value(obj["ai_walk_paths"], ai_walk_paths);
   }
 }
 
-void Serializer::serialize_tween_callback(TweenCallback &cb) {
+void Serializer::serialize_tween_callback(Game &game, TweenCallback &cb) {
   writer.StartObject();
   serialize_int("cb_type", static_cast<int>(cb.cb_type));
-  serialize_string_val("unit_handle", to_string(cb.unit_guid));
+  serialize_entity_handle(game, "unit_handle", cb.unit_handle);
   serialize_vec2("tile_point", cb.tile_point);
   serialize_bool("is_final_point_in_path", cb.is_final_point_in_path);
+  serialize_bool("is_final_point_in_segment", cb.is_final_point_in_segment);
   writer.EndObject();
 }
 
@@ -200,9 +176,35 @@ void Serializer::deserialize_tween_callback(Game &game,
                                             GenericObject<false, Value> &obj,
                                             TweenCallback &cb) {
   cb.cb_type = static_cast<TweenCallbackType>(obj["cb_type"].GetInt());
-  cb.unit_guid = game.engine.string_gen(obj["unit_handle"].GetString());
+  deserialize_entity_handle(game, obj, "unit_handle", cb.unit_handle);
   deserialize_vec2(obj, "tile_point", cb.tile_point);
   cb.is_final_point_in_path = obj["is_final_point_in_path"].GetBool();
+  if (obj.HasMember("is_final_point_in_segment")) {
+    cb.is_final_point_in_segment = obj["is_final_point_in_segment"].GetBool();
+  }
+}
+
+// handles are only good for the session they were made in so the entity's
+// guid is written instead, a nil guid for a handle that isn't set.
+void Serializer::serialize_entity_handle(Game &game, const char *key,
+                                         EntityHandle handle) {
+  auto guid = boost::uuids::nil_uuid();
+  if (game.entity_registry.contains(handle)) {
+    guid = game.entity_registry.get_guid(handle);
+  }
+  serialize_string_val(key, to_string(guid));
+}
+
+void Serializer::deserialize_entity_handle(Game &game,
+                                           GenericObject<false, Value> &obj,
+                                           const char *key,
+                                           EntityHandle &handle) {
+  auto guid = game.engine.string_gen(obj[key].GetString());
+  if (guid.is_nil()) {
+    handle = EntityHandle();
+    return;
+  }
+  handle = game.entity_registry.get_handle(guid);
 }
 
 void Serializer::serialize_tile_point_hitbox(Vec2 &hitbox_dims,
@@ -220,46 +222,20 @@ void Serializer::deserialize_tile_point_hitbox(GenericObject<false, Value> &obj,
 
 void Serializer::serialize_range(const char *key, Range &range) {
   writer.String(key);
-  writer.StartObject();
-  serialize_int("lower_bound", range.lower_bound);
-  serialize_int("current", range.current);
-  serialize_int("current_before_status_effects",
-                range.current_before_status_effects);
-  serialize_int("max", range.max);
-  serialize_int("upper_bound", range.upper_bound);
-  writer.EndObject();
+  reflect_serialize(writer, range);
 }
 
 void Serializer::deserialize_range(GenericObject<false, Value> &obj,
                                    const char *key, Range &range) {
-  auto range_obj = obj[key].GetObject();
-  range.lower_bound = range_obj["lower_bound"].GetInt();
-  range.current = range_obj["current"].GetInt();
-  range.current_before_status_effects =
-      range_obj["current_before_status_effects"].GetInt();
-  range.max = range_obj["max"].GetInt();
-  range.upper_bound = range_obj["upper_bound"].GetInt();
+  reflect_deserialize(obj[key], range);
 }
 
 void Serializer::serialize_stats(const char *key, Stats &stats) {
   writer.String(key);
-  writer.StartObject();
-  serialize_range("hp", stats.hp);
-  serialize_range("action_points", stats.action_points);
-  serialize_range("damage", stats.damage);
-  serialize_range("range", stats.range);
-  serialize_range("aoe", stats.aoe);
-  serialize_range("cast_time", stats.cast_time);
-  writer.EndObject();
+  reflect_serialize(writer, stats);
 }
 
 void Serializer::deserialize_stats(GenericObject<false, Value> &obj,
                                    const char *key, Stats &stats) {
-  auto stats_obj = obj[key].GetObject();
-  deserialize_range(stats_obj, "hp", stats.hp);
-  deserialize_range(stats_obj, "action_points", stats.action_points);
-  deserialize_range(stats_obj, "damage", stats.damage);
-  deserialize_range(stats_obj, "range", stats.range);
-  deserialize_range(stats_obj, "aoe", stats.aoe);
-  deserialize_range(stats_obj, "cast_time", stats.cast_time);
+  reflect_deserialize(obj[key], stats);
 }
\ No newline at end of file
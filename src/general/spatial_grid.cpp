@@ -0,0 +1,245 @@
+#include "spatial_grid.h"
+#include <algorithm>
+#include <climits>
+
+SpatialGrid::SpatialGrid() {}
+
+SpatialGrid::SpatialGrid(int map_rows, int map_cols) {
+  rows = max(1, (map_rows * TILE_SIZE + SPATIAL_GRID_CELL_SIZE - 1) /
+                    SPATIAL_GRID_CELL_SIZE);
+  cols = max(1, (map_cols * TILE_SIZE + SPATIAL_GRID_CELL_SIZE - 1) /
+                    SPATIAL_GRID_CELL_SIZE);
+  cells = vector<vector<int>>(rows * cols);
+}
+
+// adds the entry or moves it to rect. The cells are only touched when the
+// rect moves into different cells.
+void SpatialGrid::update(EntityHandle handle, const Rect &rect) {
+  auto cell_rect = get_cell_rect(rect);
+  auto it = entry_idxs.find(handle);
+  if (it == entry_idxs.end()) {
+    auto entry = SpatialGridEntry();
+    entry.handle = handle;
+    entry.rect = rect;
+    entry.cell_rect = cell_rect;
+    entries.push_back(entry);
+    entry_idxs[handle] = entries.size() - 1;
+    add_to_cells(entries.size() - 1);
+    return;
+  }
+  auto entry_idx = it->second;
+  entries[entry_idx].rect = rect;
+  if (entries[entry_idx].cell_rect != cell_rect) {
+    remove_from_cells(entry_idx);
+    entries[entry_idx].cell_rect = cell_rect;
+    add_to_cells(entry_idx);
+  }
+}
+
+// the last entry is moved into the erased entry's place.
+void SpatialGrid::erase(EntityHandle handle) {
+  auto it = entry_idxs.find(handle);
+  if (it == entry_idxs.end()) {
+    return;
+  }
+  auto entry_idx = it->second;
+  auto last_idx = (int)entries.size() - 1;
+  remove_from_cells(entry_idx);
+  entry_idxs.erase(it);
+  if (entry_idx != last_idx) {
+    remove_from_cells(last_idx);
+    entries[entry_idx] = entries[last_idx];
+    entry_idxs[entries[entry_idx].handle] = entry_idx;
+    add_to_cells(entry_idx);
+  }
+  entries.pop_back();
+}
+
+bool SpatialGrid::contains(EntityHandle handle) {
+  return entry_idxs.contains(handle);
+}
+
+// the entries whose rect contains p, edges included like
+// rect_contains_point.
+void SpatialGrid::query_point(Vec2 p, vector<EntityHandle> &handles) {
+  query_cells(get_cell_rect(Rect(p.x, p.y, 0, 0)), handles,
+              [&](const Rect &rect) { return rect_contains_point(rect, p); });
+}
+
+// the entries whose rect overlaps rect.
+void SpatialGrid::query_rect(const Rect &rect,
+                             vector<EntityHandle> &handles) {
+  query_cells(get_cell_rect(rect), handles, [&](const Rect &entry_rect) {
+    return rect_contains_rect(rect, entry_rect);
+  });
+}
+
+// the entries whose rect's x, y is closer than radius to p.
+void SpatialGrid::query_radius(Vec2 p, int radius,
+                               vector<EntityHandle> &handles) {
+  auto radius_sq = (int64_t)radius * radius;
+  query_cells(get_cell_rect(Rect(p.x - radius, p.y - radius, radius * 2,
+                                 radius * 2)),
+              handles, [&](const Rect &rect) {
+                auto dx = (int64_t)(rect.x - p.x);
+                auto dy = (int64_t)(rect.y - p.y);
+                return dx * dx + dy * dy < radius_sq;
+              });
+}
+
+// the entries whose rect overlaps the circle, see rect_contains_circle.
+void SpatialGrid::query_circle(Vec2 center, int radius,
+                               vector<EntityHandle> &handles) {
+  query_cells(get_cell_rect(Rect(center.x - radius, center.y - radius,
+                                 radius * 2, radius * 2)),
+              handles, [&](const Rect &rect) {
+                auto entry_rect = rect;
+                return rect_contains_circle(center, radius, entry_rect);
+              });
+}
+
+// the matching entry whose rect's x, y is the fewest world points from p
+// (manhattan). Cells are searched in rings around p's cell until nothing
+// outside of the searched cells can be closer.
+pair<bool, EntityHandle>
+SpatialGrid::get_closest(Vec2 p, function<bool(EntityHandle)> is_match) {
+  auto found = false;
+  EntityHandle closest_handle;
+  auto closest_dist = INT_MAX;
+  auto center = get_cell(p);
+  start_query();
+  for (int ring = 0;; ring++) {
+    auto min_x = max(center.x - ring, 0);
+    auto min_y = max(center.y - ring, 0);
+    auto max_x = min(center.x + ring, rows - 1);
+    auto max_y = min(center.y + ring, cols - 1);
+    for (int x = min_x; x <= max_x; x++) {
+      auto is_ring_edge_x = abs(x - center.x) == ring;
+      for (int y = min_y; y <= max_y; y++) {
+        if (!is_ring_edge_x && abs(y - center.y) != ring) {
+          // skip to the ring's other edge
+          y = max(y, center.y + ring - 1);
+          continue;
+        }
+        for (auto entry_idx : cells[get_cell_idx(x, y)]) {
+          auto &entry = entries[entry_idx];
+          if (entry.query_stamp == query_stamp) {
+            continue;
+          }
+          entry.query_stamp = query_stamp;
+          auto dist = manhattan_distance(p, entry.rect.get_xy());
+          if (dist < closest_dist && is_match(entry.handle)) {
+            found = true;
+            closest_dist = dist;
+            closest_handle = entry.handle;
+          }
+        }
+      }
+    }
+    // the closest anything in the cells not searched yet can be. Cells past
+    // the grid's edge don't exist, entries outside of it are in the edge
+    // cells.
+    auto min_unsearched_dist = INT_MAX;
+    if (min_x > 0) {
+      min_unsearched_dist =
+          min(min_unsearched_dist, p.x - min_x * SPATIAL_GRID_CELL_SIZE);
+    }
+    if (max_x < rows - 1) {
+      min_unsearched_dist =
+          min(min_unsearched_dist, (max_x + 1) * SPATIAL_GRID_CELL_SIZE - p.x);
+    }
+    if (min_y > 0) {
+      min_unsearched_dist =
+          min(min_unsearched_dist, p.y - min_y * SPATIAL_GRID_CELL_SIZE);
+    }
+    if (max_y < cols - 1) {
+      min_unsearched_dist =
+          min(min_unsearched_dist, (max_y + 1) * SPATIAL_GRID_CELL_SIZE - p.y);
+    }
+    if (min_unsearched_dist == INT_MAX ||
+        (found && closest_dist <= min_unsearched_dist)) {
+      break;
+    }
+  }
+  return make_pair(found, closest_handle);
+}
+
+// clears handles and adds the entries in the cells of cell_rect that is_hit
+// returns true for.
+void SpatialGrid::query_cells(const Rect &cell_rect,
+                              vector<EntityHandle> &handles,
+                              function<bool(const Rect &)> is_hit) {
+  handles.clear();
+  start_query();
+  for (int x = cell_rect.x; x < cell_rect.x + cell_rect.w; x++) {
+    for (int y = cell_rect.y; y < cell_rect.y + cell_rect.h; y++) {
+      for (auto entry_idx : cells[get_cell_idx(x, y)]) {
+        auto &entry = entries[entry_idx];
+        if (entry.query_stamp == query_stamp) {
+          continue;
+        }
+        entry.query_stamp = query_stamp;
+        if (is_hit(entry.rect)) {
+          handles.push_back(entry.handle);
+        }
+      }
+    }
+  }
+}
+
+Vec2 SpatialGrid::get_cell(Vec2 p) {
+  // floor so points left of or below the map go in the edge cells
+  auto x = p.x >= 0 ? p.x / SPATIAL_GRID_CELL_SIZE
+                    : (p.x + 1) / SPATIAL_GRID_CELL_SIZE - 1;
+  auto y = p.y >= 0 ? p.y / SPATIAL_GRID_CELL_SIZE
+                    : (p.y + 1) / SPATIAL_GRID_CELL_SIZE - 1;
+  return Vec2(clamp(x, 0, rows - 1), clamp(y, 0, cols - 1));
+}
+
+// the cells rect's edges are in, edges included.
+Rect SpatialGrid::get_cell_rect(const Rect &rect) {
+  auto min_cell = get_cell(Vec2(rect.x, rect.y));
+  auto max_cell = get_cell(Vec2(rect.x + rect.w, rect.y + rect.h));
+  return Rect(min_cell.x, min_cell.y, max_cell.x - min_cell.x + 1,
+              max_cell.y - min_cell.y + 1);
+}
+
+int SpatialGrid::get_cell_idx(int cell_x, int cell_y) {
+  return cell_x * cols + cell_y;
+}
+
+void SpatialGrid::add_to_cells(int entry_idx) {
+  auto &cell_rect = entries[entry_idx].cell_rect;
+  for (int x = cell_rect.x; x < cell_rect.x + cell_rect.w; x++) {
+    for (int y = cell_rect.y; y < cell_rect.y + cell_rect.h; y++) {
+      cells[get_cell_idx(x, y)].push_back(entry_idx);
+    }
+  }
+}
+
+void SpatialGrid::remove_from_cells(int entry_idx) {
+  auto &cell_rect = entries[entry_idx].cell_rect;
+  for (int x = cell_rect.x; x < cell_rect.x + cell_rect.w; x++) {
+    for (int y = cell_rect.y; y < cell_rect.y + cell_rect.h; y++) {
+      auto &cell = cells[get_cell_idx(x, y)];
+      for (int i = 0; i < (int)cell.size(); i++) {
+        if (cell[i] == entry_idx) {
+          cell[i] = cell.back();
+          cell.pop_back();
+          break;
+        }
+      }
+    }
+  }
+}
+
+// stamps are never 0 so new entries are never taken as already tested.
+void SpatialGrid::start_query() {
+  query_stamp += 1;
+  if (query_stamp == 0) {
+    for (auto &entry : entries) {
+      entry.query_stamp = 0;
+    }
+    query_stamp = 1;
+  }
+}
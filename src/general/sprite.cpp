@@ -61,9 +61,16 @@ void Sprite::draw(Game &game) {
 
 void Sprite::set_is_hidden(bool _is_hidden) { is_hidden = _is_hidden; }
 
-void sprite_serialize(Game &game, Sprite &sprite) {
+// with a palette only the dst and the sprite's palette idx are written,
+// the sprite has to be in the palette.
+void sprite_serialize(Game &game, Sprite &sprite, SpritePalette *palette) {
   game.serializer.writer.StartObject();
   game.serializer.serialize_rect("dst", sprite.dst);
+  if (palette != nullptr) {
+    game.serializer.serialize_int("palette_idx", palette->get_idx(sprite));
+    game.serializer.writer.EndObject();
+    return;
+  }
   game.serializer.serialize_int("image_name", (int)sprite.image.image_name);
   game.serializer.serialize_int("anim_speed", sprite.anim_speed);
   game.serializer.serialize_sprite_src_vec("srcs", sprite.srcs);
@@ -71,7 +78,21 @@ void sprite_serialize(Game &game, Sprite &sprite) {
   // cout << "output " << game.serializer.sb.GetString() << "\n";
 }
 
-Sprite sprite_deserialize(Game &game, GenericObject<false, Value> &obj) {
+// sprites written with a palette are read from it, older files have the
+// whole sprite.
+Sprite sprite_deserialize(Game &game, GenericObject<false, Value> &obj,
+                          SpritePalette *palette) {
+  if (palette != nullptr && obj.HasMember("palette_idx")) {
+    auto palette_idx = obj["palette_idx"].GetInt();
+    if (palette_idx < 0 || palette_idx >= (int)palette->sprites.size()) {
+      cout << "sprite_deserialize. Palette idx out of range " << palette_idx
+           << "\n";
+      abort();
+    }
+    Sprite sprite = palette->sprites[palette_idx];
+    game.serializer.deserialize_rect(obj, "dst", sprite.dst);
+    return sprite;
+  }
   Sprite sprite = Sprite();
   auto image_name = (ImageName)obj["image_name"].GetInt();
   if (image_name == ImageName::None) {
@@ -120,4 +141,70 @@ Sprite sprite_deserialize_from_file(Game &game, const char *file_path) {
   auto obj = game.serializer.doc.GetObject();
   // deserialize unit_obj into a Unit
   return sprite_deserialize(game, obj);
-}
\ No newline at end of file
+}
+
+// what makes two palette sprites the same, the dst isn't part of it.
+static string get_sprite_palette_key(Sprite &sprite) {
+  auto key = to_string((int)sprite.image.image_name) + " " +
+             to_string(sprite.anim_speed);
+  for (auto &src : sprite.srcs) {
+    auto &r = src.image_location.src;
+    key += " " + to_string(r.x) + " " + to_string(r.y) + " " +
+           to_string(r.w) + " " + to_string(r.h);
+  }
+  return key;
+}
+
+// returns the sprite's idx, adding it if the palette doesn't have it yet.
+int SpritePalette::add(Sprite &sprite) {
+  auto key = get_sprite_palette_key(sprite);
+  auto it = idxs.find(key);
+  if (it != idxs.end()) {
+    return it->second;
+  }
+  auto palette_sprite = Sprite();
+  palette_sprite.image = sprite.image;
+  palette_sprite.anim_speed = sprite.anim_speed;
+  palette_sprite.srcs = sprite.srcs;
+  sprites.push_back(palette_sprite);
+  idxs[key] = sprites.size() - 1;
+  return sprites.size() - 1;
+}
+
+int SpritePalette::get_idx(Sprite &sprite) {
+  auto it = idxs.find(get_sprite_palette_key(sprite));
+  GAME_ASSERT(it != idxs.end());
+  return it->second;
+}
+
+void sprite_palette_serialize(Game &game, SpritePalette &palette) {
+  game.serializer.writer.StartArray();
+  for (auto &sprite : palette.sprites) {
+    game.serializer.writer.StartObject();
+    game.serializer.serialize_int("image_name", (int)sprite.image.image_name);
+    game.serializer.serialize_int("anim_speed", sprite.anim_speed);
+    game.serializer.serialize_sprite_src_vec("srcs", sprite.srcs);
+    game.serializer.writer.EndObject();
+  }
+  game.serializer.writer.EndArray();
+}
+
+// palette sprites have the same fields as a sprite without its dst, the
+// images and srcs are resolved here once for every sprite that uses them.
+SpritePalette sprite_palette_deserialize(Game &game,
+                                         GenericArray<false, Value> &array) {
+  auto palette = SpritePalette();
+  for (auto &value : array) {
+    auto obj = value.GetObject();
+    Sprite sprite = Sprite();
+    auto image_name = (ImageName)obj["image_name"].GetInt();
+    if (image_name != ImageName::None) {
+      sprite.image = game.engine.get_image(image_name);
+    }
+    sprite.anim_speed = obj["anim_speed"].GetInt();
+    game.serializer.deserialize_sprite_src_vec(obj, sprite.image, "srcs",
+                                               sprite.srcs);
+    palette.sprites.push_back(sprite);
+  }
+  return palette;
+}
@@ -25,26 +25,35 @@ void Tile::set_to_default_tile(Game &game) {
       100);
 }
 
-void tile_serialize(Game &game, Tile &tile) {
+void tile_serialize(Game &game, Tile &tile, SpritePalette *palette) {
   game.serializer.writer.StartObject();
   game.serializer.writer.String("sprite");
-  sprite_serialize(game, tile.sprite);
+  sprite_serialize(game, tile.sprite, palette);
   game.serializer.serialize_bool("is_obstacle", tile.is_obstacle);
   game.serializer.serialize_bool("is_warp_point", tile.is_warp_point);
   game.serializer.serialize_vec2("warps_to_tile_point",
                                  tile.warps_to_tile_point);
+  // only warp points to other maps have it, maps have a lot of tiles
+  if (tile.warps_to_map_file_path.size() > 0) {
+    game.serializer.serialize_string("warps_to_map_file_path",
+                                     tile.warps_to_map_file_path);
+  }
   game.serializer.writer.EndObject();
   // cout << "output " << game.serializer.sb.GetString() << "\n";
 }
 
-Tile tile_deserialize(Game &game, GenericObject<false, Value> &obj) {
+Tile tile_deserialize(Game &game, GenericObject<false, Value> &obj,
+                      SpritePalette *palette) {
   Tile tile = Tile();
   auto sprite_obj = obj["sprite"].GetObject();
-  tile.sprite = sprite_deserialize(game, sprite_obj);
+  tile.sprite = sprite_deserialize(game, sprite_obj, palette);
   tile.is_obstacle = obj["is_obstacle"].GetBool();
   tile.is_warp_point = obj["is_warp_point"].GetBool();
   game.serializer.deserialize_vec2(obj, "warps_to_tile_point",
                                    tile.warps_to_tile_point);
+  if (obj.HasMember("warps_to_map_file_path")) {
+    tile.warps_to_map_file_path = obj["warps_to_map_file_path"].GetString();
+  }
   return tile;
 }
 
@@ -53,6 +53,11 @@ void TreasureChest::set_tile_point(Game &game, Vec2 _tile_point) {
   set_world_point_from_tile_point(_tile_point, opened_sprite.dst);
 }
 
+// covers both sprites, either can be the one the mouse is over.
+Rect TreasureChest::get_bounding_dst() {
+  return get_bounding_rect(sprite.dst, opened_sprite.dst);
+}
+
 void treasure_chest_serialize(Game &game, TreasureChest &treasure_chest) {
   game.serializer.writer.StartObject();
   game.serializer.serialize_string_val("guid", to_string(treasure_chest.guid));
@@ -21,20 +21,20 @@ TweenCompletion::TweenCompletion() {
   completed = false;
 }
 
-void TweenCallback::set_as_unit_move_callback(boost::uuids::uuid _unit_guid,
+void TweenCallback::set_as_unit_move_callback(EntityHandle _unit_handle,
                                               Vec2 _tile_point,
                                               bool _is_final_point_in_path) {
   cb_type = TweenCallbackType::UnitMove;
-  unit_guid = _unit_guid;
+  unit_handle = _unit_handle;
   tile_point = _tile_point;
   is_final_point_in_path = _is_final_point_in_path;
 }
 
 void TweenCallback::set_as_send_item_to_unit_callback(
-    boost::uuids::uuid _unit_guid, boost::uuids::uuid _item_guid) {
+    EntityHandle _unit_handle, EntityHandle _item_handle) {
   cb_type = TweenCallbackType::SendItemToUnit;
-  unit_guid = _unit_guid;
-  item_guid = _item_guid;
+  unit_handle = _unit_handle;
+  item_handle = _item_handle;
 }
 
 void TweenCallback::set_as_item_pickup_display_complete(
@@ -43,20 +43,20 @@ void TweenCallback::set_as_item_pickup_display_complete(
   panel_guid = _panel_guid;
 }
 
-void TweenCallback::set_as_battle_text(boost::uuids::uuid _unit_guid,
+void TweenCallback::set_as_battle_text(EntityHandle _unit_handle,
                                        int _handle) {
   cb_type = TweenCallbackType::BattleText;
-  unit_guid = _unit_guid;
+  unit_handle = _unit_handle;
   handle = _handle;
 }
 
 void TweenCallback::set_as_use_ability(
-    boost::uuids::uuid _acting_unit_guid,
-    vector<boost::uuids::uuid> _receiving_unit_guids, int _ability_handle,
+    EntityHandle _acting_unit_handle,
+    vector<EntityHandle> _receiving_unit_handles, int _ability_handle,
     int _damage, Vec2 _target_dst, PerformAbilityContext _ability_context) {
   cb_type = TweenCallbackType::UseAbility;
-  unit_guid = _acting_unit_guid;
-  receiving_unit_guids = _receiving_unit_guids;
+  unit_handle = _acting_unit_handle;
+  receiving_unit_handles = _receiving_unit_handles;
   handle = _ability_handle;
   damage = _damage;
   target_dst = _target_dst;
@@ -64,12 +64,12 @@ void TweenCallback::set_as_use_ability(
 }
 
 void TweenCallback::set_as_use_ability_timeout(
-    boost::uuids::uuid _acting_unit_guid,
-    vector<boost::uuids::uuid> _receiving_unit_guids, AbilityName _ability_name,
+    EntityHandle _acting_unit_handle,
+    vector<EntityHandle> _receiving_unit_handles, AbilityName _ability_name,
     int _damage, Vec2 _target_dst, PerformAbilityContext _ability_context) {
   cb_type = TweenCallbackType::UseAbilityTimeout;
-  unit_guid = _acting_unit_guid;
-  receiving_unit_guids = _receiving_unit_guids;
+  unit_handle = _acting_unit_handle;
+  receiving_unit_handles = _receiving_unit_handles;
   ability_name = _ability_name;
   damage = _damage;
   target_dst = _target_dst;
@@ -92,6 +92,35 @@ void Tweens::update(Game &game, Rect &val) {
     }
   }
 
+  // callbacks can clear the tweens or add a path tween (the next path
+  // segment), so the tween is looked up by index after each one.
+  for (int i = (int)tween_paths.size() - 1; i >= 0; i--) {
+    auto start_clear_count = clear_count;
+    auto tween_completion = tween_paths.at(i).update(game, val);
+    if (tween_completion.started) {
+      tween_paths.at(i).has_started = true;
+      auto callback = tween_paths.at(i).get_cell_callback(0);
+      handle_tween_on_start(game, callback);
+    }
+    while (tween_paths.at(i).completed_cell_count <
+           tween_paths.at(i).reached_cell_count) {
+      auto cell_idx = tween_paths.at(i).completed_cell_count;
+      tween_paths.at(i).completed_cell_count += 1;
+      auto callback = tween_paths.at(i).get_cell_callback(cell_idx);
+      handle_tween_on_complete(game, callback);
+      if (clear_count != start_clear_count) {
+        return;
+      }
+      if (cell_idx + 1 < (int)tween_paths.at(i).cells.size()) {
+        callback = tween_paths.at(i).get_cell_callback(cell_idx + 1);
+        handle_tween_on_start(game, callback);
+      }
+    }
+    if (tween_completion.completed) {
+      tween_paths.erase(tween_paths.begin() + i);
+    }
+  }
+
   for (int i = (int)tween_xys_constant_speed.size() - 1; i >= 0; i--) {
     auto &tween = tween_xys_constant_speed.at(i);
     auto tween_completion = tween.update(game, val);
@@ -113,7 +142,7 @@ void Tweens::update(Game &game, Rect &val) {
     auto target_val = Rect(0, 0, 0, 0);
     GAME_ASSERT(tween.moving_target_type != TweenMovingTargetType::None);
     if (tween.moving_target_type == TweenMovingTargetType::Unit) {
-      target_val = game.map.unit_dict[tween.moving_target_guid].sprite.dst;
+      target_val = game.map.unit_dict[tween.moving_target_handle].sprite.dst;
     }
     auto tween_completion = tween.update(game, val, target_val);
     if (tween_completion.started) {
@@ -132,6 +161,8 @@ void Tweens::update(Game &game, Rect &val) {
 
 void Tweens::clear() {
   tween_xys.clear();
+  tween_paths.clear();
+  clear_count += 1;
   tween_xys_constant_speed.clear();
   tween_xys_speed_moving_target.clear();
 }
@@ -153,6 +184,53 @@ TweenXY::TweenXY(Rect _start_val, Rect _target_val, Uint32 current_time,
   double_point = DoublePoint((double)_start_val.x, (double)_start_val.y);
 }
 
+TweenPath::TweenPath() {
+  start_val = Rect(0, 0, 0, 0);
+  speed = 0;
+  spawn_time = 0;
+  delay = 0;
+  current_time_spawn_time_delta = 0;
+  has_started = false;
+  path_ends = true;
+  reached_cell_count = 0;
+  completed_cell_count = 0;
+}
+
+TweenPath::TweenPath(EntityHandle _unit_handle, Rect _start_val,
+                     const vector<Vec2> &_cells,
+                     const vector<int> &_corner_idxs, Uint32 current_time,
+                     Uint32 _delay, double _speed, bool _path_ends) {
+  unit_handle = _unit_handle;
+  start_val = _start_val;
+  cells = _cells;
+  corner_idxs = _corner_idxs;
+  speed = _speed;
+  spawn_time = current_time;
+  delay = _delay;
+  current_time_spawn_time_delta = 0;
+  has_started = false;
+  path_ends = _path_ends;
+  reached_cell_count = 0;
+  completed_cell_count = 0;
+  set_corner_dists();
+}
+
+void TweenPath::set_corner_dists() {
+  corner_dists.clear();
+  auto prev_x = (double)start_val.x;
+  auto prev_y = (double)start_val.y;
+  auto dist = 0.0;
+  for (auto corner_idx : corner_idxs) {
+    auto world_point = tile_point_to_world_point_move_grid(cells[corner_idx]);
+    auto delta_x = world_point.x - prev_x;
+    auto delta_y = world_point.y - prev_y;
+    dist += sqrt(delta_x * delta_x + delta_y * delta_y);
+    corner_dists.push_back(dist);
+    prev_x = world_point.x;
+    prev_y = world_point.y;
+  }
+}
+
 TweenXYConstantSpeed::TweenXYConstantSpeed(Rect _start_val, Rect _target_val,
                                            Uint32 current_time, Uint32 _delay,
                                            double _speed,
@@ -180,7 +258,7 @@ TweenXYSpeedMovingTarget::TweenXYSpeedMovingTarget(
     Rect _start_val, Rect _target_val, TweenInterpType _tween_interp_type,
     Uint32 current_time, Uint32 _delay, double _speed,
     TweenMovingTargetType _moving_target_type,
-    boost::uuids::uuid _moving_target_guid, TweenCallback _callback,
+    EntityHandle _moving_target_handle, TweenCallback _callback,
     std::function<void()> _on_start, std::function<void()> _on_complete) {
   callback = _callback;
   start_val = _start_val;
@@ -196,7 +274,7 @@ TweenXYSpeedMovingTarget::TweenXYSpeedMovingTarget(
   on_complete = _on_complete;
   double_point = DoublePoint((double)_start_val.x, (double)_start_val.y);
   moving_target_type = _moving_target_type;
-  moving_target_guid = _moving_target_guid;
+  moving_target_handle = _moving_target_handle;
 }
 
 // tweens handle removing individual tweens when the tween is completed
@@ -238,6 +316,66 @@ TweenCompletion TweenXY::update(Game &game, Rect &val) {
   return tween_completion;
 }
 
+// the position is worked out from the time since the delay, so a slow
+// frame can pass several cells, reached_cell_count says how many.
+TweenCompletion TweenPath::update(Game &game, Rect &val) {
+  auto tween_completion = TweenCompletion();
+  auto current_time = game.engine.current_time;
+  current_time_spawn_time_delta = current_time - spawn_time;
+  if (current_time < spawn_time + delay) {
+    val.x = start_val.x;
+    val.y = start_val.y;
+    return tween_completion;
+  }
+
+  if (!has_started) {
+    tween_completion.started = true;
+  }
+  if (cells.size() == 0 || corner_idxs.size() == 0) {
+    reached_cell_count = (int)cells.size();
+    tween_completion.completed = true;
+    return tween_completion;
+  }
+  auto dist = (current_time - (spawn_time + delay)) * speed;
+  auto prev_corner_dist = 0.0;
+  auto prev_corner_idx = -1;
+  auto prev_world_point = Vec2(start_val.x, start_val.y);
+  for (size_t i = 0; i < corner_idxs.size(); i++) {
+    auto corner_idx = corner_idxs[i];
+    auto world_point = tile_point_to_world_point_move_grid(cells[corner_idx]);
+    if (dist < corner_dists[i]) {
+      auto segment_dist = corner_dists[i] - prev_corner_dist;
+      auto frac = (dist - prev_corner_dist) / segment_dist;
+      val.x = prev_world_point.x + (int)((world_point.x - prev_world_point.x) *
+                                         frac);
+      val.y = prev_world_point.y + (int)((world_point.y - prev_world_point.y) *
+                                         frac);
+      // cell k of the segment is reached k / segment cells of the way along
+      auto segment_cells = corner_idx - prev_corner_idx;
+      reached_cell_count = prev_corner_idx + 1 + (int)(frac * segment_cells);
+      return tween_completion;
+    }
+    prev_corner_dist = corner_dists[i];
+    prev_corner_idx = corner_idx;
+    prev_world_point = world_point;
+  }
+  val.x = prev_world_point.x;
+  val.y = prev_world_point.y;
+  reached_cell_count = (int)cells.size();
+  tween_completion.completed = true;
+  return tween_completion;
+}
+
+// only the last cell ends the path or the segment.
+TweenCallback TweenPath::get_cell_callback(int cell_idx) {
+  auto is_last_cell = cell_idx == (int)cells.size() - 1;
+  auto callback = TweenCallback();
+  callback.set_as_unit_move_callback(unit_handle, cells[cell_idx],
+                                     is_last_cell && path_ends);
+  callback.is_final_point_in_segment = is_last_cell && !path_ends;
+  return callback;
+}
+
 // tweens handle removing individual tweens when the tween is completed
 // so you do not have to do that in the on complete function.
 TweenCompletion TweenXYConstantSpeed::update(Game &game, Rect &val) {
@@ -337,10 +475,12 @@ void handle_tween_on_start(Game &game, TweenCallback &cb) {
     break;
   }
   case TweenCallbackType::UnitMove: {
-    auto &unit = game.map.unit_dict[cb.unit_guid];
+    auto &unit = game.map.unit_dict[cb.unit_handle];
     unit.is_moving = true;
     unit.sprite.tile_point_hit_box.x = cb.tile_point.x;
     unit.sprite.tile_point_hit_box.y = cb.tile_point.y;
+    game.map.occupancy_grid.move_unit(unit.handle,
+                                      unit.sprite.get_tile_point_hit_box());
     break;
   }
   case TweenCallbackType::SendItemToUnit: {
@@ -376,17 +516,28 @@ void handle_tween_on_complete(Game &game, TweenCallback &cb) {
     break;
   }
   case TweenCallbackType::UnitMove: {
-    auto &unit = game.map.unit_dict[cb.unit_guid];
+    auto &unit = game.map.unit_dict[cb.unit_handle];
     auto tile_point = move_grid_point_to_tile_point(cb.tile_point);
     auto tile_idx = twod_to_oned_idx(tile_point, game.map.rows);
     auto &tile = game.map.tiles[tile_idx];
-    if (tile.is_warp_point) {
+    // only the player's units go to other maps, the map's own units walk
+    // over those warp points.
+    auto is_warp_point_to_map = tile.warps_to_map_file_path.size() > 0;
+    if (tile.is_warp_point &&
+        (!is_warp_point_to_map ||
+         game.map.is_handle_in_all_player_units(cb.unit_handle))) {
       // clear move tweens
       unit.sprite.tweens.clear();
       unit.is_moving = false;
       unit.is_ai_walking = false;
       unit.unit_ui_before_unit.move_icon.is_hidden = true;
-      unit.set_tile_point(tile.warps_to_tile_point);
+      unit.path_waypoints.clear();
+      if (is_warp_point_to_map) {
+        game.map_transition_request.set_transition(tile.warps_to_map_file_path,
+                                                   tile.warps_to_tile_point);
+      } else {
+        unit.set_tile_point(game, tile.warps_to_tile_point);
+      }
     }
     if (unit.in_battle) {
       GAME_ASSERT(game.map.battle_dict.contains(unit.battle_guid));
@@ -404,18 +555,22 @@ void handle_tween_on_complete(Game &game, TweenCallback &cb) {
       if (unit.in_battle) {
         GAME_ASSERT(game.map.battle_dict.contains(unit.battle_guid));
         auto &battle = game.map.battle_dict[unit.battle_guid];
+        battle.set_move_range_field(game, unit);
         battle.perform_next_battle_action(game);
       }
     }
+    if (cb.is_final_point_in_segment) {
+      unit.move_to_next_path_waypoints(game, 0);
+    }
     break;
   }
   case TweenCallbackType::SendItemToUnit: {
-    auto &unit = game.map.unit_dict[cb.unit_guid];
-    auto &item = game.map.item_dict[cb.item_guid];
+    auto &unit = game.map.unit_dict[cb.unit_handle];
+    auto &item = game.map.item_dict[cb.item_handle];
     // if the unit is in the player's control add the item to
     // their inventory.
-    if (is_player_controlled_unit_guid(game.map.player_unit_guids,
-                                       cb.unit_guid)) {
+    if (is_player_controlled_unit_handle(game.map.player_unit_handles,
+                                         cb.unit_handle)) {
       if (item.item_type == ItemType::Money) {
         unit.coin.quantity += item.quantity;
       } else {
@@ -425,8 +580,8 @@ void handle_tween_on_complete(Game &game, TweenCallback &cb) {
       game.ui.item_pickup_list.add_item(game, item);
     }
     // erase item
-    GAME_ASSERT(game.map.item_dict.contains(item.guid));
-    game.map.remove_item_guid_at_end_of_frame(item.guid);
+    GAME_ASSERT(game.map.item_dict.contains(item.handle));
+    game.map.remove_item_handle_at_end_of_frame(item.handle);
     break;
   }
   case TweenCallbackType::ItemPickupDisplayComplete: {
@@ -438,8 +593,8 @@ void handle_tween_on_complete(Game &game, TweenCallback &cb) {
     break;
   }
   case TweenCallbackType::BattleText: {
-    GAME_ASSERT(game.map.unit_dict.contains(cb.unit_guid));
-    auto &unit = game.map.unit_dict[cb.unit_guid];
+    GAME_ASSERT(game.map.unit_dict.contains(cb.unit_handle));
+    auto &unit = game.map.unit_dict[cb.unit_handle];
     unit.unit_ui_last_layer.battle_texts.battle_texts.release_handle(cb.handle);
     break;
   }
@@ -453,13 +608,13 @@ void handle_tween_on_complete(Game &game, TweenCallback &cb) {
     // get the receiving units for aoe spells just when they go off
     // as units can move if its a charge spell.
     if (ability.stats.aoe.current != 1) {
-      cb.receiving_unit_guids =
-          game.map.get_receiving_unit_guids(game, ability, cb.target_dst);
+      cb.receiving_unit_handles =
+          game.map.get_receiving_unit_handles(game, ability, cb.target_dst);
     }
 
-    for (auto receiving_unit_guid : cb.receiving_unit_guids) {
-      GAME_ASSERT(game.map.unit_dict.contains(receiving_unit_guid));
-      auto &receiving_unit = game.map.unit_dict[receiving_unit_guid];
+    for (auto receiving_unit_handle : cb.receiving_unit_handles) {
+      GAME_ASSERT(game.map.unit_dict.contains(receiving_unit_handle));
+      auto &receiving_unit = game.map.unit_dict[receiving_unit_handle];
       switch (ability.ability_type) {
       case AbilityType::None: {
         cout << "TweenCallback::UseAbility ability type of None was used.\n";
@@ -499,8 +654,8 @@ void handle_tween_on_complete(Game &game, TweenCallback &cb) {
       }
     }
 
-    GAME_ASSERT(game.map.unit_dict.contains(cb.unit_guid));
-    auto &acting_unit = game.map.unit_dict[cb.unit_guid];
+    GAME_ASSERT(game.map.unit_dict.contains(cb.unit_handle));
+    auto &acting_unit = game.map.unit_dict[cb.unit_handle];
     if (acting_unit.in_battle) {
       GAME_ASSERT(game.map.battle_dict.contains(acting_unit.battle_guid));
       acting_unit.is_battle_acting = false;
@@ -510,20 +665,20 @@ void handle_tween_on_complete(Game &game, TweenCallback &cb) {
       // can't counter counter abilities (infinite cycle)
       if (cb.ability_context != PerformAbilityContext::Counter) {
         auto someone_countered = false;
-        for (auto receiving_unit_guid : cb.receiving_unit_guids) {
-          GAME_ASSERT(game.map.unit_dict.contains(receiving_unit_guid));
+        for (auto receiving_unit_handle : cb.receiving_unit_handles) {
+          GAME_ASSERT(game.map.unit_dict.contains(receiving_unit_handle));
           // can't counter an ability you hit yourself with
-          if (receiving_unit_guid == acting_unit.guid) {
+          if (receiving_unit_handle == acting_unit.handle) {
             continue;
           }
-          auto &receiving_unit = game.map.unit_dict[receiving_unit_guid];
+          auto &receiving_unit = game.map.unit_dict[receiving_unit_handle];
           if (receiving_unit.equipped_abilities.counter.ability_name !=
               AbilityName::None) {
             someone_countered = true;
             auto battle_action = BattleAction();
             battle_action.set_as_use_ability(
-                receiving_unit.guid,
-                vector<boost::uuids::uuid>{acting_unit.guid},
+                receiving_unit.handle,
+                vector<EntityHandle>{acting_unit.handle},
                 receiving_unit.equipped_abilities.counter, Vec2(0, 0));
             battle.counter_queue.push(battle_action);
           }
@@ -550,10 +705,10 @@ void handle_tween_on_complete(Game &game, TweenCallback &cb) {
     break;
   }
   case TweenCallbackType::UseAbilityTimeout: {
-    GAME_ASSERT(game.map.unit_dict.contains(cb.unit_guid));
-    auto &acting_unit = game.map.unit_dict[cb.unit_guid];
+    GAME_ASSERT(game.map.unit_dict.contains(cb.unit_handle));
+    auto &acting_unit = game.map.unit_dict[cb.unit_handle];
     acting_unit.unit_ui_after_unit.ability_box.is_hidden = true;
-    game.map.perform_ability(game, cb.unit_guid, cb.receiving_unit_guids,
+    game.map.perform_ability(game, cb.unit_handle, cb.receiving_unit_handles,
                              game.assets.get_ability(cb.ability_name),
                              cb.target_dst, cb.ability_context);
     break;
@@ -599,7 +754,34 @@ void tweens_serialize(Game &game, Tweens &tweens) {
                                            tween_xy.double_point);
     game.serializer.serialize_bool("has_started", tween_xy.has_started);
     game.serializer.writer.String("callback");
-    game.serializer.serialize_tween_callback(tween_xy.callback);
+    game.serializer.serialize_tween_callback(game, tween_xy.callback);
+    game.serializer.writer.EndObject();
+  }
+  game.serializer.writer.EndArray();
+  game.serializer.writer.String("tween_paths");
+  game.serializer.writer.StartArray();
+  for (auto &tween_path : tweens.tween_paths) {
+    game.serializer.writer.StartObject();
+    game.serializer.serialize_entity_handle(game, "unit_handle",
+                                            tween_path.unit_handle);
+    game.serializer.serialize_rect("start_val", tween_path.start_val);
+    game.serializer.serialize_vec2_vec("cells", tween_path.cells);
+    game.serializer.writer.String("corner_idxs");
+    game.serializer.writer.StartArray();
+    for (auto corner_idx : tween_path.corner_idxs) {
+      game.serializer.writer.Int(corner_idx);
+    }
+    game.serializer.writer.EndArray();
+    game.serializer.serialize_double("speed", tween_path.speed);
+    game.serializer.serialize_uint("delay", tween_path.delay);
+    game.serializer.serialize_uint("current_time_spawn_time_delta",
+                                   tween_path.current_time_spawn_time_delta);
+    game.serializer.serialize_bool("has_started", tween_path.has_started);
+    game.serializer.serialize_bool("path_ends", tween_path.path_ends);
+    game.serializer.serialize_int("reached_cell_count",
+                                  tween_path.reached_cell_count);
+    game.serializer.serialize_int("completed_cell_count",
+                                  tween_path.completed_cell_count);
     game.serializer.writer.EndObject();
   }
   game.serializer.writer.EndArray();
@@ -627,6 +809,37 @@ Tweens tweens_deserialize(Game &game, GenericObject<false, Value> &obj) {
     game.serializer.deserialize_tween_callback(game, cb_obj, tween_xy.callback);
     tweens.tween_xys.push_back(tween_xy);
   }
+  // older files don't have path tweens
+  if (obj.HasMember("tween_paths")) {
+    auto tween_path_array = obj["tween_paths"].GetArray();
+    for (auto &tween_path_value : tween_path_array) {
+      auto tween_path_obj = tween_path_value.GetObject();
+      auto tween_path = TweenPath();
+      game.serializer.deserialize_entity_handle(
+          game, tween_path_obj, "unit_handle", tween_path.unit_handle);
+      game.serializer.deserialize_rect(tween_path_obj, "start_val",
+                                       tween_path.start_val);
+      game.serializer.deserialize_vec2_vec(tween_path_obj, "cells",
+                                           tween_path.cells);
+      for (auto &corner_idx : tween_path_obj["corner_idxs"].GetArray()) {
+        tween_path.corner_idxs.push_back(corner_idx.GetInt());
+      }
+      tween_path.speed = tween_path_obj["speed"].GetDouble();
+      tween_path.delay = tween_path_obj["delay"].GetUint();
+      tween_path.current_time_spawn_time_delta =
+          tween_path_obj["current_time_spawn_time_delta"].GetUint();
+      tween_path.spawn_time =
+          game.engine.current_time - tween_path.current_time_spawn_time_delta;
+      tween_path.has_started = tween_path_obj["has_started"].GetBool();
+      tween_path.path_ends = tween_path_obj["path_ends"].GetBool();
+      tween_path.reached_cell_count =
+          tween_path_obj["reached_cell_count"].GetInt();
+      tween_path.completed_cell_count =
+          tween_path_obj["completed_cell_count"].GetInt();
+      tween_path.set_corner_dists();
+      tweens.tween_paths.push_back(tween_path);
+    }
+  }
   return tweens;
 }
 
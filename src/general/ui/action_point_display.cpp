@@ -64,11 +64,11 @@ void ActionPointDisplay::update(Game &game, int available, int total) {
     // go through all the client's units and see which unit
     // is the active unit in a battle, then advance that battle's
     // turn.
-    for (auto &unit_guid : game.map.player_unit_guids) {
-      auto &u = game.map.unit_dict[unit_guid];
+    for (auto &unit_handle : game.map.player_unit_handles) {
+      auto &u = game.map.unit_dict[unit_handle];
       if (u.in_battle) {
         auto &battle = game.map.battle_dict[u.battle_guid];
-        if (battle.acting_unit_guid == unit_guid) {
+        if (battle.acting_unit_handle == unit_handle) {
           battle_found = true;
           battle.end_turn(game);
         }
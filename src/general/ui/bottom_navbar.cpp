@@ -145,7 +145,7 @@ void BottomNavBar::update(Game &game, Unit &unit) {
             game.engine.mouse_point_game_rect_scaled !=
                 slot.input_events.mouse_dst_when_mouse_down) {
           game.ui.drag_ghost.drop_callback.set_as_bottom_navbar_ability_swap(
-              unit.guid, j);
+              unit.handle, j);
           game.ui.drag_ghost.start_drag(ability.portrait);
         }
 
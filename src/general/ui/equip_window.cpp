@@ -52,7 +52,8 @@ void EquipWindow::update(Game &game, Unit &unit) {
   inventory_background.update(game);
   funds_money_display.coin.quantity = unit.coin.quantity;
   funds_money_display.update(game);
-  inventory_window.update(game, unit.inventory, DropType::EquipItem, unit.guid);
+  inventory_window.update(game, unit.inventory, DropType::EquipItem,
+                          unit.handle);
 }
 
 void EquipWindow::draw(Game &game, Unit &unit) {
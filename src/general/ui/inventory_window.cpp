@@ -12,11 +12,11 @@ InventoryWindow::InventoryWindow(Game &game, Vec2 _dst) {
   }
 }
 
-// unit_guid is passed in because its needed for some drop callbacks
+// unit_handle is passed in because its needed for some drop callbacks
 // but its not needed for other callbacks so its a little ugly.
 void InventoryWindow::update(Game &game, Inventory &inventory,
                              DropType _drop_type,
-                             boost::uuids::uuid unit_guid) {
+                             EntityHandle unit_handle) {
   Vec2 start_dst = dst;
   Vec2 slot_dst = dst;
   int columns = 7;
@@ -54,7 +54,7 @@ void InventoryWindow::update(Game &game, Inventory &inventory,
           break;
         }
         case DropType::EquipItem: {
-          game.ui.drag_ghost.drop_callback.set_as_equip_item(item, unit_guid,
+          game.ui.drag_ghost.drop_callback.set_as_equip_item(item, unit_handle,
                                                              (int)i);
           game.ui.drag_ghost.start_drag(item);
           break;
@@ -63,7 +63,7 @@ void InventoryWindow::update(Game &game, Inventory &inventory,
         // later if needed
         /*case DropType::ShopBuyItem: {
           DropCallback drop_callback = DropCallback();
-          drop_callback.set_as_shop_buy_item(item, unit_guid);
+          drop_callback.set_as_shop_buy_item(item, unit_handle);
           game.ui.drag_ghost.start_drag(item, drop_callback);
           break;
         }*/
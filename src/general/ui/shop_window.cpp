@@ -95,13 +95,13 @@ void ShopWindow::update_when_open(Game &game, Unit &unit, Unit &seller) {
   funds_display.update(game);
   total_display.update(game);
   buy_merchant_inventory_window.update(game, seller.inventory, DropType::None,
-                                       seller.guid);
+                                       seller.handle);
   buy_merchant_order_window.update(game, buy_order_inventory, DropType::None,
-                                   unit.guid);
+                                   unit.handle);
   sell_player_inventory_window.update(game, unit.inventory, DropType::None,
-                                      unit.guid);
+                                      unit.handle);
   sell_merchant_order_window.update(game, sell_order_inventory, DropType::None,
-                                    unit.guid);
+                                    unit.handle);
   confirm_button.update(game);
 
   // after shop_mode_tabs update to avoid a frame of nothing being drawn
@@ -228,7 +228,7 @@ void ShopWindow::draw(Game &game, Unit &unit, Unit &seller) {
   confirm_button.draw(game);
 }
 
-void ShopWindow::show_shop(boost::uuids::uuid _seller_unit_guid) {
+void ShopWindow::show_shop(EntityHandle _seller_unit_handle) {
   is_hidden = false;
-  seller_unit_guid = _seller_unit_guid;
+  seller_unit_handle = _seller_unit_handle;
 }
\ No newline at end of file
@@ -86,7 +86,7 @@ void SkillTreeWindow::update(Game &game, Unit &unit) {
               skill_slot.has_skill_slot.input_events
                   .mouse_dst_when_mouse_down) {
         game.ui.drag_ghost.drop_callback.set_as_equip_ability(
-            skill_slot.ability, unit.guid);
+            skill_slot.ability, unit.handle);
         game.ui.drag_ghost.start_drag(skill_slot.ability.portrait);
       }
       if (skill_slot.does_not_have_skill_slot.input_events.is_click) {
@@ -37,8 +37,8 @@ void TurnOrderDisplay::update(Game &game, Battle &battle) {
     charge_slot.dst.set_xy(charge_slot_dst);
     slot_start.x += slot_w + SLOT_MARGIN_RIGHT;
   }
-  for (auto &unit_guid : battle.unit_guids) {
-    auto &unit = game.map.unit_dict[unit_guid];
+  for (auto &unit_handle : battle.unit_handles) {
+    auto &unit = game.map.unit_dict[unit_handle];
     unit.unit_ui_after_unit.turn_order_arrow.is_hidden = true;
   }
   game.map.turn_order_ability_target.is_hidden = true;
@@ -57,13 +57,13 @@ void TurnOrderDisplay::update_layout(Game &game, Battle &battle, bool _draw) {
     charge_slot.is_hidden = true;
   }
 
-  if (battle.unit_guids.size() > 0) {
+  if (battle.unit_handles.size() > 0) {
     auto turn_idx = 0;
     int slot_idx = 0;
-    int battle_unit_guid_idx = 0;
-    for (size_t i = 0; i < battle.unit_guids.size(); i++) {
-      if (battle.unit_guids[i] == battle.acting_unit_guid) {
-        battle_unit_guid_idx = (int)i;
+    int battle_unit_handle_idx = 0;
+    for (size_t i = 0; i < battle.unit_handles.size(); i++) {
+      if (battle.unit_handles[i] == battle.acting_unit_handle) {
+        battle_unit_handle_idx = (int)i;
         break;
       }
     }
@@ -71,8 +71,8 @@ void TurnOrderDisplay::update_layout(Game &game, Battle &battle, bool _draw) {
       auto &slot = slots[slot_idx];
       auto &hp_bar = hp_bars[slot_idx];
       slot.is_hidden = false;
-      auto unit_guid = battle.unit_guids.at(battle_unit_guid_idx);
-      auto &unit = game.map.unit_dict[unit_guid];
+      auto unit_handle = battle.unit_handles.at(battle_unit_handle_idx);
+      auto &unit = game.map.unit_dict[unit_handle];
       if (!_draw) {
         slot.update(game);
         auto hp_bar_w = slot.dst.w - 2;
@@ -97,9 +97,9 @@ void TurnOrderDisplay::update_layout(Game &game, Battle &battle, bool _draw) {
                            portrait_dst);
         hp_bar.draw(game);
       }
-      battle_unit_guid_idx += 1;
-      if (battle_unit_guid_idx > (int)battle.unit_guids.size() - 1) {
-        battle_unit_guid_idx = 0;
+      battle_unit_handle_idx += 1;
+      if (battle_unit_handle_idx > (int)battle.unit_handles.size() - 1) {
+        battle_unit_handle_idx = 0;
       }
       for (auto &charging_action : battle.charging_actions) {
         if (charging_action.ability.stats.cast_time.current - 1 == turn_idx) {
@@ -111,7 +111,7 @@ void TurnOrderDisplay::update_layout(Game &game, Battle &battle, bool _draw) {
           auto &hp_bar_charge_slot = hp_bars[slot_idx];
           charge_slot.is_hidden = false;
           auto &acting_unit =
-              game.map.unit_dict[charging_action.acting_unit_guid];
+              game.map.unit_dict[charging_action.acting_unit_handle];
           if (!_draw) {
             charge_slot.update(game);
             auto hp_bar_w = charge_slot.dst.w - 2;
@@ -139,12 +139,11 @@ void TurnOrderDisplay::update_layout(Game &game, Battle &battle, bool _draw) {
                 game.map.turn_order_ability_target.update(game);
                 game.map.turn_order_ability_target.is_hidden = false;
               } else {
-                GAME_ASSERT(charging_action.receiving_unit_guids.size() > 0);
-                GAME_ASSERT(game.map.unit_dict.contains(
-                    charging_action.receiving_unit_guids.at(0)));
-                auto &receiving_unit =
-                    game.map
-                        .unit_dict[charging_action.receiving_unit_guids.at(0)];
+                GAME_ASSERT(charging_action.receiving_unit_handles.size() > 0);
+                auto receiving_unit_handle =
+                    charging_action.receiving_unit_handles.at(0);
+                GAME_ASSERT(game.map.unit_dict.contains(receiving_unit_handle));
+                auto &receiving_unit = game.map.unit_dict[receiving_unit_handle];
                 receiving_unit.unit_ui_after_unit.crosshairs.set_is_hidden(
                     false);
               }
@@ -32,8 +32,8 @@ void UI::update(Game &game) {
   equip_window.update(game, player_unit);
   skill_tree_window.update(game, player_unit);
   if (!shop_window.is_hidden &&
-      game.map.unit_dict.contains(shop_window.seller_unit_guid)) {
-    auto &seller_unit = game.map.unit_dict[shop_window.seller_unit_guid];
+      game.map.unit_dict.contains(shop_window.seller_unit_handle)) {
+    auto &seller_unit = game.map.unit_dict[shop_window.seller_unit_handle];
     shop_window.update_when_open(game, player_unit, seller_unit);
   } else {
     shop_window.update_always(game, player_unit);
@@ -67,8 +67,8 @@ void UI::draw(Game &game) {
   equip_window.draw(game, player_unit);
   skill_tree_window.draw(game, player_unit);
   if (!shop_window.is_hidden &&
-      game.map.unit_dict.contains(shop_window.seller_unit_guid)) {
-    auto &seller_unit = game.map.unit_dict[shop_window.seller_unit_guid];
+      game.map.unit_dict.contains(shop_window.seller_unit_handle)) {
+    auto &seller_unit = game.map.unit_dict[shop_window.seller_unit_handle];
     shop_window.draw(game, player_unit, seller_unit);
   }
   battle_start_alert.draw(game);
@@ -78,7 +78,7 @@ void UI::draw(Game &game) {
   drag_ghost.draw(game);
 }
 
-void DropCallback::set_as_equip_item(Item &_item, boost::uuids::uuid _unit_guid,
+void DropCallback::set_as_equip_item(Item &_item, EntityHandle _unit_handle,
                                      int _item_idx) {
   drop_type = DropType::EquipItem;
   if (item.item_name != _item.item_name) {
@@ -88,39 +88,39 @@ void DropCallback::set_as_equip_item(Item &_item, boost::uuids::uuid _unit_guid,
   // time. set the newly copied item's quantity to 1 to make sure only 1 item is
   // equipped and removed from the inventory when equipped.
   item.quantity = 1;
-  unit_guid = _unit_guid;
+  unit_handle = _unit_handle;
   item_idx = _item_idx;
 }
 
 void DropCallback::set_as_unequip_item(Item &_item,
-                                       boost::uuids::uuid _unit_guid) {
+                                       EntityHandle _unit_handle) {
   drop_type = DropType::UnequipItem;
   if (item.item_name != _item.item_name) {
     item = _item;
   }
   // should already be 1, but setting it again anyway
   item.quantity = 1;
-  unit_guid = _unit_guid;
+  unit_handle = _unit_handle;
 }
 
 void DropCallback::set_as_shop_buy_item(Item &_item,
-                                        boost::uuids::uuid _merchant_guid) {
+                                        EntityHandle _merchant_handle) {
   drop_type = DropType::ShopBuyItem;
   item = _item;
-  merchant_guid = _merchant_guid;
+  merchant_handle = _merchant_handle;
 }
 
 void DropCallback::set_as_equip_ability(const Ability &_ability,
-                                        boost::uuids::uuid _unit_guid) {
+                                        EntityHandle _unit_handle) {
   drop_type = DropType::EquipAbility;
   ability = _ability;
-  unit_guid = _unit_guid;
+  unit_handle = _unit_handle;
 }
 
 void DropCallback::set_as_bottom_navbar_ability_swap(
-    boost::uuids::uuid _unit_guid, int _ability_idx) {
+    EntityHandle _unit_handle, int _ability_idx) {
   drop_type = DropType::BottomNavbarAbilitySwap;
-  unit_guid = _unit_guid;
+  unit_handle = _unit_handle;
   ability_idx = _ability_idx;
 }
 
@@ -140,8 +140,8 @@ void DragGhost::handle_on_drop(Game &game) {
     break;
   }
   case DropType::EquipItem: {
-    GAME_ASSERT(game.map.unit_dict.contains(drop_callback.unit_guid));
-    auto &unit = game.map.unit_dict[drop_callback.unit_guid];
+    GAME_ASSERT(game.map.unit_dict.contains(drop_callback.unit_handle));
+    auto &unit = game.map.unit_dict[drop_callback.unit_handle];
     // drop_callback's item's quantity is set to 1 when creating
     // the callback, so only one piece of equipment is removed in
     // unit.inventory.remove_item
@@ -183,8 +183,8 @@ void DragGhost::handle_on_drop(Game &game) {
     break;
   }
   case DropType::UnequipItem: {
-    GAME_ASSERT(game.map.unit_dict.contains(drop_callback.unit_guid));
-    auto &unit = game.map.unit_dict[drop_callback.unit_guid];
+    GAME_ASSERT(game.map.unit_dict.contains(drop_callback.unit_handle));
+    auto &unit = game.map.unit_dict[drop_callback.unit_handle];
     for (size_t i = 0; i < game.ui.equip_window.inventory_window.slots.size();
          i++) {
       auto &slot = game.ui.equip_window.inventory_window.slots[i];
@@ -207,8 +207,8 @@ void DragGhost::handle_on_drop(Game &game) {
     break;
   }
   case DropType::ShopBuyItem: {
-    GAME_ASSERT(game.map.unit_dict.contains(drop_callback.merchant_guid));
-    auto &merchant = game.map.unit_dict[drop_callback.merchant_guid];
+    GAME_ASSERT(game.map.unit_dict.contains(drop_callback.merchant_handle));
+    auto &merchant = game.map.unit_dict[drop_callback.merchant_handle];
     for (auto &slot : game.ui.shop_window.buy_merchant_order_window.slots) {
       if (is_mouse_over_dst(game, false, slot.dst)) {
         game.ui.shop_window.buy_order_inventory.add_item(drop_callback.item);
@@ -218,8 +218,8 @@ void DragGhost::handle_on_drop(Game &game) {
     break;
   }
   case DropType::EquipAbility: {
-    GAME_ASSERT(game.map.unit_dict.contains(drop_callback.unit_guid));
-    auto &unit = game.map.unit_dict[drop_callback.unit_guid];
+    GAME_ASSERT(game.map.unit_dict.contains(drop_callback.unit_handle));
+    auto &unit = game.map.unit_dict[drop_callback.unit_handle];
     for (size_t i = 0;
          i < game.ui.bottom_navbar
                  .ability_slots[game.ui.bottom_navbar.showing_ability_row_idx]
@@ -237,10 +237,10 @@ void DragGhost::handle_on_drop(Game &game) {
     break;
   }
   case DropType::BottomNavbarAbilitySwap: {
-    GAME_ASSERT(game.map.unit_dict.contains(drop_callback.unit_guid));
+    GAME_ASSERT(game.map.unit_dict.contains(drop_callback.unit_handle));
     GAME_ASSERT(drop_callback.ability_idx >= 0 &&
                 drop_callback.ability_idx <= NUM_ABILITY_SLOTS_PER_ROW - 1);
-    auto &unit = game.map.unit_dict[drop_callback.unit_guid];
+    auto &unit = game.map.unit_dict[drop_callback.unit_handle];
     auto dropped_on_slot = false;
     for (size_t i = 0;
          i < game.ui.bottom_navbar
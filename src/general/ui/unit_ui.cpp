@@ -59,7 +59,7 @@ void UnitUIAfterUnit::update(Game &game, Unit &unit) {
   turn_order_arrow.dst = active_arrow.dst;
   if (unit.in_battle) {
     auto &battle = game.map.battle_dict[unit.battle_guid];
-    active_arrow.is_hidden = battle.acting_unit_guid != unit.guid;
+    active_arrow.is_hidden = battle.acting_unit_handle != unit.handle;
   }
   active_arrow.update(game);
   turn_order_arrow.update(game);
@@ -60,7 +60,7 @@ void UIEquipmentSlots::update_slot(Game &game, Unit &unit, UISprite &slot,
         slot.input_events.was_mouse_down_when_mouse_over &&
         game.engine.mouse_point_game_rect_scaled !=
             slot.input_events.mouse_dst_when_mouse_down) {
-      game.ui.drag_ghost.drop_callback.set_as_unequip_item(item, unit.guid);
+      game.ui.drag_ghost.drop_callback.set_as_unequip_item(item, unit.handle);
       game.ui.drag_ghost.start_drag(item);
     }
   }
@@ -5,6 +5,7 @@
 #include "rapidjson/stringbuffer.h"
 #include "rapidjson/writer.h"
 #include "utils_game.h"
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <sstream>
@@ -53,20 +54,21 @@ Unit::Unit(Game &game) {
   ai_walk_paths = vector<AIWalkPath>();
   ai_walk_path_idx = 0;
   dialogue_idx = 0;
-  in_dialogue_with_unit_guid;
+  in_dialogue_with_unit_handle;
   is_ai_walking = false;
   is_moving = false;
   coin = get_coin_item(game);
   cash = get_cash_item(game);
 }
 
-void Unit::set_tile_point(Vec2 tile_point) {
+void Unit::set_tile_point(Game &game, Vec2 tile_point) {
   auto _tile_point_move_grid = tile_point_to_tile_point_move_grid(tile_point);
   auto world_point = tile_point_to_world_point_move_grid(_tile_point_move_grid);
   sprite.dst.x = world_point.x;
   sprite.dst.y = world_point.y;
   sprite.tile_point_hit_box.x = _tile_point_move_grid.x;
   sprite.tile_point_hit_box.y = _tile_point_move_grid.y;
+  game.map.occupancy_grid.move_unit(handle, sprite.get_tile_point_hit_box());
   // add the initial walk tile point to the units starting point
   auto ai_walk_path = AIWalkPath(_tile_point_move_grid, 0);
   if (ai_walk_paths.size() > 0) {
@@ -76,12 +78,13 @@ void Unit::set_tile_point(Vec2 tile_point) {
   }
 }
 
-void Unit::set_tile_point_move_grid(Vec2 _tile_point_move_grid) {
+void Unit::set_tile_point_move_grid(Game &game, Vec2 _tile_point_move_grid) {
   auto world_point = tile_point_to_world_point_move_grid(_tile_point_move_grid);
   sprite.dst.x = world_point.x;
   sprite.dst.y = world_point.y;
   sprite.tile_point_hit_box.x = _tile_point_move_grid.x;
   sprite.tile_point_hit_box.y = _tile_point_move_grid.y;
+  game.map.occupancy_grid.move_unit(handle, sprite.get_tile_point_hit_box());
   // add the initial walk tile point to the units starting point
   auto ai_walk_path = AIWalkPath(_tile_point_move_grid, 0);
   if (ai_walk_paths.size() > 0) {
@@ -111,7 +114,7 @@ void Unit::draw(Game &game) { sprite.draw(game); }
 
 // returns true when the dialogue sequence is over
 bool Unit::show_next_dialogue(Game &game,
-                              boost::uuids::uuid _talking_to_unit_handle) {
+                              EntityHandle _talking_to_unit_handle) {
   // clear any move tweens as the unit is no win dialogue
   sprite.tweens.clear();
   for (auto &dialogue : dialogues) {
@@ -122,7 +125,7 @@ bool Unit::show_next_dialogue(Game &game,
         dialogue_idx = 0;
         return true;
       }
-      in_dialogue_with_unit_guid = _talking_to_unit_handle;
+      in_dialogue_with_unit_handle = _talking_to_unit_handle;
       unit_ui_after_unit.dialogue_box.is_hidden = false;
       unit_ui_after_unit.dialogue_box.set_text_str(game, *this,
                                                    dialogue.strs[dialogue_idx]);
@@ -146,7 +149,7 @@ void Unit::do_next_ai_walk(Game &game) {
   }
   auto &ai_walk_path = ai_walk_paths.at(ai_walk_path_idx);
   is_ai_walking = true;
-  move_to(game, ai_walk_path.target_point, ai_walk_path.delay, true);
+  request_move_to(game, ai_walk_path.target_point, ai_walk_path.delay, true);
 }
 
 void Unit::move_to(Game &game, Vec2 target, Uint32 _delay,
@@ -155,63 +158,192 @@ void Unit::move_to(Game &game, Vec2 target, Uint32 _delay,
   // cancel move tweens later).
   stop_moving(game);
   auto unit_tile_point = get_tile_point();
-  game.path_finder.set_path(game, game.map, *this, unit_tile_point, target,
-                            allow_units_to_path_through_each_other);
+  // long walks outside of battle go through the cluster graph first, only
+  // the part of the path the unit is about to walk is searched in full.
+  if (!in_battle &&
+      chebyshev_distance(unit_tile_point, target) > PATH_CLUSTER_SIZE) {
+    auto hit_box = sprite.get_tile_point_hit_box();
+    auto &path_cluster_graph =
+        game.map.get_path_cluster_graph(Vec2(hit_box.w, hit_box.h));
+    if (path_cluster_graph.set_waypoints(game.map.move_grid, unit_tile_point,
+                                         target)) {
+      path_waypoints = path_cluster_graph.waypoints;
+      game.path_finder.smooth_waypoints(game.map.move_grid, hit_box,
+                                        unit_tile_point, path_waypoints);
+      reverse(path_waypoints.begin(), path_waypoints.end());
+      waypoints_allow_units_to_path_through_each_other =
+          allow_units_to_path_through_each_other;
+      show_move_icon(game, target);
+      move_to_next_path_waypoints(game, _delay);
+      return;
+    }
+  }
+  // battle moves that don't come with a path (see BattleAction::has_path)
+  // take the shortest one.
+  auto path_finder_mode = PATH_FINDER_WALK_MODE;
+  if (in_battle) {
+    path_finder_mode = PathFinderMode::AStar;
+  }
+  game.path_finder.set_path(game.map, *this, unit_tile_point, target,
+                            allow_units_to_path_through_each_other,
+                            path_finder_mode);
   /*if (!game.path_finder.path_found) {
-    game.path_finder.set_path(game, game.map, *this, unit_tile_point,
+    game.path_finder.set_path(game.map, *this, unit_tile_point,
                               game.path_finder.closest_point_to_target,
                               allow_units_to_path_through_each_other);
   }*/
   if (game.path_finder.path.size() == 0) {
     return;
   }
+  show_move_icon(game, target);
+  add_move_tweens(game, game.path_finder.path, _delay, true);
+}
 
-  // cout << "path size " << game.path_finder.path.size() << "\n";
-  auto prev_tile_point = unit_tile_point;
-  // first prev world point should be the sprite's dst, not the world point from
-  // the index. if the grid is larger it would cause a jarring snap effect from
-  // the sprites dst to the world point of the index initially.
-  auto prev_world_point = sprite.dst;
-  // set move icon pos
-  if (!in_battle && is_player_unit_guid(game.map.player_unit_guids, guid)) {
+// move_to with the search done by the path request service, the unit starts
+// walking when Map::update delivers the result. Long walks outside of
+// battle still go through move_to, the cluster graph only searches a short
+// part of them at a time.
+void Unit::request_move_to(Game &game, Vec2 target, Uint32 _delay,
+                           bool allow_units_to_path_through_each_other) {
+  auto unit_tile_point = get_tile_point();
+  if (!in_battle &&
+      chebyshev_distance(unit_tile_point, target) > PATH_CLUSTER_SIZE) {
+    move_to(game, target, _delay, allow_units_to_path_through_each_other);
+    return;
+  }
+  // a new request replaces the outstanding one, the move isn't cancelled.
+  path_request_ticket = PATH_REQUEST_NONE;
+  stop_moving(game);
+  auto path_finder_mode = PATH_FINDER_WALK_MODE;
+  if (in_battle) {
+    path_finder_mode = PathFinderMode::AStar;
+  }
+  path_request_ticket = game.path_request_service.request_path(
+      game.map, *this, unit_tile_point, target,
+      allow_units_to_path_through_each_other, path_finder_mode);
+  path_request_delay = _delay;
+  is_path_request_battle_move = in_battle;
+}
+
+void Unit::follow_path_result(Game &game, PathResult &result) {
+  path_request_ticket = PATH_REQUEST_NONE;
+  // the unit was put somewhere else while the search ran, search again.
+  if (!(result.start == get_tile_point())) {
+    request_move_to(game, result.target, path_request_delay,
+                    result.allow_units_to_path_through_each_other);
+    return;
+  }
+  walk_path(game, result.path, result.target, path_request_delay);
+}
+
+// walks a path that was already found. target is only used for the move
+// icon.
+void Unit::walk_path(Game &game, const vector<Vec2> &path, Vec2 target,
+                     Uint32 _delay) {
+  if (path.size() == 0) {
+    // battles wait for a move to finish before the next action.
+    if (in_battle) {
+      GAME_ASSERT(game.map.battle_dict.contains(battle_guid));
+      auto &battle = game.map.battle_dict[battle_guid];
+      battle.perform_next_battle_action(game);
+    }
+    return;
+  }
+  show_move_icon(game, target);
+  add_move_tweens(game, path, _delay, true);
+}
+
+// refines waypoints until there is about a cluster's worth of path to walk.
+// called by move_to and again by the UnitMove callback at the end of each
+// part. if units block the way to a waypoint the rest of the walk is
+// searched straight to the target.
+void Unit::move_to_next_path_waypoints(Game &game, Uint32 _delay) {
+  auto start = get_tile_point();
+  auto segment = vector<Vec2>();
+  while (!path_waypoints.empty() && (int)segment.size() < PATH_CLUSTER_SIZE) {
+    auto waypoint = path_waypoints.back();
+    game.path_finder.set_path(game.map, *this, start, waypoint,
+                              waypoints_allow_units_to_path_through_each_other,
+                              PATH_FINDER_WALK_MODE);
+    if (!game.path_finder.path_found) {
+      auto target = path_waypoints.front();
+      path_waypoints.clear();
+      game.path_finder.set_path(
+          game.map, *this, start, target,
+          waypoints_allow_units_to_path_through_each_other,
+          PATH_FINDER_WALK_MODE);
+      segment.insert(segment.end(), game.path_finder.path.begin(),
+                     game.path_finder.path.end());
+      break;
+    }
+    segment.insert(segment.end(), game.path_finder.path.begin(),
+                   game.path_finder.path.end());
+    start = waypoint;
+    path_waypoints.pop_back();
+  }
+  if (segment.size() == 0) {
+    path_waypoints.clear();
+    is_moving = false;
+    is_ai_walking = false;
+    unit_ui_before_unit.move_icon.is_hidden = true;
+    return;
+  }
+  add_move_tweens(game, segment, _delay, path_waypoints.empty());
+}
+
+void Unit::show_move_icon(Game &game, Vec2 target) {
+  if (!in_battle &&
+      is_player_unit_handle(game.map.player_unit_handles, handle)) {
     auto target_world_point = tile_point_to_world_point_move_grid(target);
     unit_ui_before_unit.move_icon.dst.x = target_world_point.x;
     unit_ui_before_unit.move_icon.dst.y = target_world_point.y;
     unit_ui_before_unit.move_icon.is_hidden = false;
   }
+}
 
-  Uint32 delay = _delay;
-  for (size_t i = 0; i < game.path_finder.path.size(); i++) {
-    auto p = game.path_finder.path[i];
-    auto move_speed = 30;
-    if (manhattan_distance(prev_tile_point, p) > 1) {
-      move_speed = (int)(move_speed * 1.5);
+// one path tween for the whole path. path_ends is false when more waypoints
+// are left, the last point then continues the walk instead of ending it.
+// outside of battle the path is smoothed into straight lines. Battle paths
+// are walked point by point, every point is a corner, so the unit walks
+// the cells it was shown and charged for. The tween starts from the
+// sprite's dst, not the world point of the unit's tile point, so there's
+// no snap if the grid is larger.
+void Unit::add_move_tweens(Game &game, const vector<Vec2> &path, Uint32 _delay,
+                           bool path_ends) {
+  if (path.size() == 0) {
+    return;
+  }
+  auto cells = path;
+  auto corner_idxs = vector<int>();
+  if (in_battle) {
+    for (int i = 0; i < (int)cells.size(); i++) {
+      corner_idxs.push_back(i);
     }
-    // cout << "path " << i << " " << p.x << " " << p.y << "\n";
-    auto world_point_xy = tile_point_to_world_point_move_grid(p);
-    auto world_point = Rect(world_point_xy.x, world_point_xy.y, 0, 0);
-    auto callback = TweenCallback();
-    callback.set_as_unit_move_callback(guid, p,
-                                       i == game.path_finder.path.size() - 1);
-    sprite.tweens.tween_xys.emplace_back(TweenXY(
-        prev_world_point, world_point, game.engine.current_time,
-        (Uint32)move_speed, delay, callback, []() {}, []() {}));
-    prev_tile_point = p;
-    prev_world_point = world_point;
-    delay += move_speed;
+  } else {
+    game.path_finder.smooth_path(
+        game.map.move_grid, &game.map.occupancy_grid,
+        sprite.get_tile_point_hit_box(),
+        game.map.occupancy_grid.get_unit_hit_box(handle), get_tile_point(),
+        cells, corner_idxs);
   }
+  // one move grid point every 30ms
+  auto speed = MOVE_GRID_TILE_SIZE / 30.0;
+  sprite.tweens.tween_paths.emplace_back(TweenPath(handle, sprite.dst, cells,
+                                                   corner_idxs,
+                                                   game.engine.current_time,
+                                                   _delay, speed, path_ends));
 }
 
-void Unit::send_item_to_player(Game &game, boost::uuids::uuid item_guid) {
-  auto &item = game.map.item_dict.at(item_guid);
+void Unit::send_item_to_player(Game &game, EntityHandle item_handle) {
+  auto &item = game.map.item_dict.at(item_handle);
   // make sure this is set
   item.being_sent_to_player = true;
   auto callback = TweenCallback();
-  callback.set_as_send_item_to_unit_callback(guid, item_guid);
+  callback.set_as_send_item_to_unit_callback(handle, item_handle);
   item.sprite.tweens.tween_xys_speed_moving_target.emplace_back(
       TweenXYSpeedMovingTarget(
           item.sprite.dst, sprite.dst, TweenInterpType::QuadraticIn,
-          game.engine.current_time, 0, 2, TweenMovingTargetType::Unit, guid,
+          game.engine.current_time, 0, 2, TweenMovingTargetType::Unit, handle,
           callback, []() {}, []() {}));
 }
 
@@ -220,18 +352,31 @@ Vec2 Unit::get_tile_point() {
 }
 
 void Unit::stop_moving(Game &game) {
+  auto is_battle_move_cancelled =
+      path_request_ticket != PATH_REQUEST_NONE && is_path_request_battle_move;
   sprite.tweens.clear();
+  path_waypoints.clear();
+  path_request_ticket = PATH_REQUEST_NONE;
+  is_path_request_battle_move = false;
   is_moving = false;
   unit_ui_before_unit.move_icon.is_hidden = true;
+  // the dropped result would have started the walk that the battle waits
+  // on, so the move ends here instead.
+  if (is_battle_move_cancelled && in_battle &&
+      game.map.battle_dict.contains(battle_guid)) {
+    auto &battle = game.map.battle_dict[battle_guid];
+    battle.perform_next_battle_action(game);
+  }
 }
 
 void Unit::add_battle_text(Game &game, string &_text) {
-  auto handle = unit_ui_last_layer.battle_texts.battle_texts.get_handle(
-      BattleText(game, *this, _text));
+  auto battle_text_handle =
+      unit_ui_last_layer.battle_texts.battle_texts.get_handle(
+          BattleText(game, *this, _text));
   auto &battle_text =
-      unit_ui_last_layer.battle_texts.battle_texts.items.at(handle);
+      unit_ui_last_layer.battle_texts.battle_texts.items.at(battle_text_handle);
   auto callback = TweenCallback();
-  callback.set_as_battle_text(guid, handle);
+  callback.set_as_battle_text(handle, battle_text_handle);
   auto top_center = sprite.dst.get_top_center();
   auto text_start =
       Rect(top_center.x, top_center.y, sprite.dst.w, sprite.dst.h);
@@ -342,10 +487,14 @@ void unit_serialize(Game &game, Unit &unit) {
   game.serializer.serialize_bool("in_dialogue", unit.in_dialogue);
   game.serializer.serialize_dialogues(unit.dialogues);
   game.serializer.serialize_int("dialogue_idx", unit.dialogue_idx);
-  game.serializer.serialize_string_val(
-      "in_dialogue_with_unit_guid", to_string(unit.in_dialogue_with_unit_guid));
+  game.serializer.serialize_entity_handle(game, "in_dialogue_with_unit_guid",
+                                          unit.in_dialogue_with_unit_handle);
   game.serializer.serialize_ai_walk_paths(unit.ai_walk_paths);
   game.serializer.serialize_int("ai_walk_path_idx", unit.ai_walk_path_idx);
+  game.serializer.serialize_vec2_vec("path_waypoints", unit.path_waypoints);
+  game.serializer.serialize_bool(
+      "waypoints_allow_units_to_path_through_each_other",
+      unit.waypoints_allow_units_to_path_through_each_other);
   game.serializer.writer.String("tweens");
   tweens_serialize(game, unit.sprite.tweens);
   game.serializer.writer.EndObject();
@@ -424,10 +573,17 @@ Unit unit_deserialize(Game &game, GenericObject<false, Value> &obj,
   unit.in_dialogue = obj["in_dialogue"].GetBool();
   game.serializer.deserialize_dialogues(obj, unit.dialogues);
   unit.dialogue_idx = obj["dialogue_idx"].GetInt();
-  unit.in_dialogue_with_unit_guid =
-      game.engine.string_gen(obj["in_dialogue_with_unit_guid"].GetString());
+  game.serializer.deserialize_entity_handle(game, obj,
+                                            "in_dialogue_with_unit_guid",
+                                            unit.in_dialogue_with_unit_handle);
   game.serializer.deserialize_ai_walk_paths(obj, unit.ai_walk_paths);
   unit.ai_walk_path_idx = obj["ai_walk_path_idx"].GetInt();
+  game.serializer.deserialize_vec2_vec(obj, "path_waypoints",
+                                       unit.path_waypoints);
+  if (obj.HasMember("waypoints_allow_units_to_path_through_each_other")) {
+    unit.waypoints_allow_units_to_path_through_each_other =
+        obj["waypoints_allow_units_to_path_through_each_other"].GetBool();
+  }
   auto tweens_obj = obj["tweens"].GetObject();
   unit.sprite.tweens = tweens_deserialize(game, tweens_obj);
   return unit;
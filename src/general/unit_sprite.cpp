@@ -75,6 +75,14 @@ void UnitSprite::update(Game &game) {
   tweens.update(game, dst);
 }
 
+// tile_point_hit_box w, h are only set in update, units that have not been
+// updated yet (just spawned or deserialized) still need the right size.
+Rect UnitSprite::get_tile_point_hit_box() {
+  return Rect(tile_point_hit_box.x, tile_point_hit_box.y,
+              hitbox_dims.x / MOVE_GRID_TILE_SIZE,
+              hitbox_dims.y / MOVE_GRID_TILE_SIZE);
+}
+
 void UnitSprite::draw(Game &game) {
   if (is_hidden) {
     return;
@@ -2,6 +2,7 @@
 #include <iostream>
 #include <math.h>
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <regex>
@@ -206,6 +207,14 @@ bool rect_contains_rect(const Rect &r1, const Rect &r2) {
          r1.y + r1.h > r2.y;
 }
 
+// the smallest rect that contains both rects.
+Rect get_bounding_rect(const Rect &r1, const Rect &r2) {
+  auto x = min(r1.x, r2.x);
+  auto y = min(r1.y, r2.y);
+  return Rect(x, y, max(r1.x + r1.w, r2.x + r2.w) - x,
+              max(r1.y + r1.h, r2.y + r2.h) - y);
+}
+
 Vec2 tile_point_to_world_point_move_grid(Vec2 tile_point) {
   return Vec2(tile_point.x * MOVE_GRID_TILE_SIZE,
               tile_point.y * MOVE_GRID_TILE_SIZE);
@@ -231,6 +240,12 @@ int manhattan_distance(Vec2 v1, Vec2 v2) {
   return abs(v1.x - v2.x) + abs(v1.y - v2.y);
 }
 
+// number of steps between two points when diagonal steps cost the same as
+// straight ones, which is how units move on the move grid.
+int chebyshev_distance(Vec2 v1, Vec2 v2) {
+  return max(abs(v1.x - v2.x), abs(v1.y - v2.y));
+}
+
 Vec2 oned_to_twod_idx(int idx, int rows) {
   return Vec2(idx % rows, idx / rows);
 }
@@ -257,16 +272,16 @@ void set_world_point_from_tile_point(Vec2 _tile_point, Rect &dst_to_set) {
 }
 
 // is the unit guid the player's unit
-bool is_player_unit_guid(vector<boost::uuids::uuid> &unit_guids,
-                         boost::uuids::uuid unit_guid) {
-  return unit_guids.size() > 0 && unit_guids[0] == unit_guid;
+bool is_player_unit_handle(vector<EntityHandle> &unit_handles,
+                           EntityHandle unit_handle) {
+  return unit_handles.size() > 0 && unit_handles[0] == unit_handle;
 }
 
-// is the unit_guid the player's unit or a unit the player controls
-bool is_player_controlled_unit_guid(vector<boost::uuids::uuid> &unit_guids,
-                                    boost::uuids::uuid unit_guid) {
-  return find(unit_guids.begin(), unit_guids.end(), unit_guid) !=
-         unit_guids.end();
+// is the unit_handle the player's unit or a unit the player controls
+bool is_player_controlled_unit_handle(vector<EntityHandle> &unit_handles,
+                                      EntityHandle unit_handle) {
+  return find(unit_handles.begin(), unit_handles.end(), unit_handle) !=
+         unit_handles.end();
 }
 
 int get_current_frame_idx(Uint32 current_time, Uint32 spawn_time, int size,
@@ -365,6 +380,20 @@ Faction get_opposite_faction(Faction faction) {
   }
 }
 
+// if you have 5 ap, you can move a full 5 ap + 1 full move ap - 1 pixel
+// so 5 ap means you can move 5 * MOVE_INDEXES_PER_ACTION_POINT +
+// (MOVE_INDEXES_PER_ACTION_POINT - 1)
+int get_available_move_size(int action_points, int move_indexes_this_turn) {
+  auto available_move_size = (action_points * MOVE_INDEXES_PER_ACTION_POINT) +
+                             (MOVE_INDEXES_PER_ACTION_POINT - 1) -
+                             move_indexes_this_turn;
+  // can be < 0 becuase of the sub at the end
+  if (available_move_size < 0) {
+    available_move_size = 0;
+  }
+  return available_move_size;
+}
+
 int get_path_ap_cost(size_t path_size, int move_indexes_this_turn,
                      int num_moves_this_turn) {
   int ap_cost =
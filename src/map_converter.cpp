@@ -0,0 +1,44 @@
+#include "map_file.h"
+#include "rapidjson/document.h"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+using namespace std;
+using namespace rapidjson;
+
+// converts json maps (assets/prefabs/maps/*.json) to the binary map format
+// in map_file.h. The binary map is written next to the json one unless an
+// output path is given. The editor writes both when it saves a map, this is
+// for maps saved before the binary format or edited by hand.
+// usage: ./map_converter map.json [map.lmap]
+int main(int argc, char **argv) {
+  if (argc < 2 || argc > 3) {
+    cout << "usage: " << argv[0] << " map.json [map" << MAP_FILE_EXTENSION
+         << "]\n";
+    return 1;
+  }
+  auto json_file_path = string(argv[1]);
+  auto binary_file_path =
+      argc == 3 ? string(argv[2]) : get_binary_map_file_path(json_file_path);
+  ifstream file(json_file_path);
+  if (!file.good()) {
+    cout << "map_converter. File error " << json_file_path << "\n";
+    return 1;
+  }
+  stringstream buffer;
+  buffer << file.rdbuf();
+  auto json = buffer.str();
+  Document doc;
+  doc.Parse(json.c_str(), json.size());
+  if (doc.HasParseError() || !doc.IsObject()) {
+    cout << "map_converter. Parse error " << json_file_path << "\n";
+    return 1;
+  }
+  auto obj = doc.GetObject();
+  map_file_write_from_json(obj, binary_file_path.c_str());
+  ifstream binary_file(binary_file_path, ios::binary | ios::ate);
+  cout << json_file_path << " (" << json.size() << " bytes) -> "
+       << binary_file_path << " (" << binary_file.tellg() << " bytes)\n";
+  return 0;
+}
@@ -0,0 +1,110 @@
+#include "game.h"
+#include "map.h"
+#include "map_reader.h"
+#include "rapidjson/document.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+using namespace std;
+using namespace rapidjson;
+
+// map load benchmark. Loads the shipped json maps with one of the readers
+// and reports the fastest load and how much the peak resident set grew.
+// The peak only goes up, so run each mode in its own process:
+//   ./map_load_bench dom && ./map_load_bench sax
+// dom is the old path (the whole file into a stringstream and a string,
+// parsed into a document, then walked), sax is map_deserialize_from_file
+// (the MapReader). Needs a window as the images are loaded like the game
+// does.
+// usage: ./map_load_bench dom|sax [runs]
+
+#define BENCH_DEFAULT_RUNS 20
+
+static const char *bench_map_file_paths[] = {
+    "assets/prefabs/maps/map.json",
+    "assets/prefabs/maps/map2.json",
+};
+
+static Map load_map_dom(Game &game, const char *file_path) {
+  ifstream file(file_path);
+  if (!file.good()) {
+    cout << "load_map_dom. File error " << file_path << "\n";
+    abort();
+  }
+  stringstream buffer;
+  buffer << file.rdbuf();
+  Document doc;
+  doc.Parse(buffer.str().c_str());
+  auto obj = doc.GetObject();
+  return map_deserialize(game, obj);
+}
+
+// in kilobytes
+static long get_peak_rss() {
+#ifdef _WIN32
+  return 0;
+#else
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+#endif
+}
+
+int main(int argc, char *argv[]) {
+  if (argc < 2 || (string(argv[1]) != "dom" && string(argv[1]) != "sax")) {
+    cout << "usage: " << argv[0] << " dom|sax [runs]\n";
+    return 1;
+  }
+  auto is_sax = string(argv[1]) == "sax";
+  auto num_runs = BENCH_DEFAULT_RUNS;
+  if (argc > 2) {
+    num_runs = max(1, atoi(argv[2]));
+  }
+  Game *game = new Game();
+  game->engine.start();
+  for (size_t i = 0; i < static_cast<int>(GameFlag::Last); i++) {
+    game->game_flags.push_back(i == 0);
+  }
+  game->assets = Assets();
+  game->assets.start(*game);
+
+  cout << "mode " << argv[1] << ", runs " << num_runs << "\n";
+  cout << left << setw(32) << "map" << right << setw(12) << "file kb"
+       << setw(12) << "best ms" << setw(16) << "peak rss +kb"
+       << "\n";
+  for (auto file_path : bench_map_file_paths) {
+    ifstream file(file_path, ios::binary | ios::ate);
+    auto file_num_bytes = (long)file.tellg();
+    auto peak_rss = get_peak_rss();
+    auto best_ms = 0.0;
+    for (int i = 0; i < num_runs; i++) {
+      auto start_time = chrono::steady_clock::now();
+      {
+        auto map = is_sax ? map_deserialize_from_file(*game, file_path)
+                          : load_map_dom(*game, file_path);
+      }
+      auto ms = chrono::duration<double, milli>(chrono::steady_clock::now() -
+                                                start_time)
+                    .count();
+      if (i == 0 || ms < best_ms) {
+        best_ms = ms;
+      }
+    }
+    cout << left << setw(32) << file_path << right << setw(12)
+         << file_num_bytes / 1024 << fixed << setprecision(2) << setw(12)
+         << best_ms << setw(16) << get_peak_rss() - peak_rss << "\n";
+  }
+  SDL_GL_DeleteContext(game->engine.context);
+  SDL_DestroyWindow(game->engine.window);
+  SDL_Quit();
+  delete game;
+  return 0;
+}
@@ -0,0 +1,423 @@
+#include "move_grid.h"
+#include "occupancy_grid.h"
+#include "path_cluster_graph.h"
+#include "pathfinder.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <queue>
+#include <random>
+#include <string>
+#include <vector>
+using namespace std;
+
+// standalone pathfinding benchmark, it only needs the grids so it builds
+// without SDL/GL. Each scenario is a synthetic map (tile obstacles and
+// unit hitboxes, the same grids Map::build_move_grid makes) with a fixed
+// set of queries from the seed, and every mode runs the same queries.
+// optimal is the breadth first search path length, the ratio is the mode's
+// path length over it for the queries the mode found a path for.
+// usage: ./pathfinder_bench [queries per scenario] [seed]
+
+#define BENCH_DEFAULT_QUERIES 50
+#define BENCH_DEFAULT_SEED 1
+// times each query set is run, the fastest run is reported
+#define BENCH_RUNS 2
+// the default unit hitbox (UnitSprite) in move grid points
+#define BENCH_HIT_BOX_W (20 / MOVE_GRID_TILE_SIZE)
+#define BENCH_HIT_BOX_H (40 / MOVE_GRID_TILE_SIZE)
+#define BENCH_NUM_UNITS 300
+
+struct BenchQuery {
+  Vec2 start = Vec2(0, 0);
+  Vec2 target = Vec2(0, 0);
+  int optimal_length = 0;
+};
+
+struct BenchScenario {
+  string name = "";
+  MoveGrid move_grid = MoveGrid();
+  OccupancyGrid occupancy_grid = OccupancyGrid();
+  // units block paths, like battle paths
+  bool use_occupancy_grid = false;
+  vector<BenchQuery> queries = vector<BenchQuery>();
+};
+
+enum class BenchMode {
+  AStar,
+  JumpPoint,
+  // the cluster graph then jump point search to each waypoint, like
+  // Unit::move_to outside of battle
+  Hierarchical,
+};
+
+struct BenchResult {
+  double ns_per_query = 0;
+  double nodes_expanded = 0;
+  int num_found = 0;
+  int num_optimal = 0;
+  double length_ratio = 0;
+};
+
+Rect get_hit_box(Vec2 p) {
+  return Rect(p.x, p.y, BENCH_HIT_BOX_W, BENCH_HIT_BOX_H);
+}
+
+bool is_passable(BenchScenario &scenario, Vec2 p) {
+  if (!scenario.move_grid.point_in_bounds(p)) {
+    return false;
+  }
+  auto hit_box = get_hit_box(p);
+  if (!scenario.move_grid.rect_is_walkable(hit_box)) {
+    return false;
+  }
+  return !scenario.use_occupancy_grid ||
+         !scenario.occupancy_grid.rect_is_occupied(hit_box,
+                                                   Rect(0, 0, 0, 0));
+}
+
+// steps from start to every point, -1 if it can't be reached.
+void set_distances(BenchScenario &scenario, Vec2 start,
+                   vector<int> &distances) {
+  auto &move_grid = scenario.move_grid;
+  distances.assign(move_grid.rows * move_grid.cols, -1);
+  auto open = queue<Vec2>();
+  distances[move_grid.get_idx(start)] = 0;
+  open.push(start);
+  while (!open.empty()) {
+    auto p = open.front();
+    open.pop();
+    auto steps = distances[move_grid.get_idx(p)];
+    for (int dx = -1; dx <= 1; dx++) {
+      for (int dy = -1; dy <= 1; dy++) {
+        auto n = Vec2(p.x + dx, p.y + dy);
+        if ((dx == 0 && dy == 0) || !is_passable(scenario, n) ||
+            distances[move_grid.get_idx(n)] != -1) {
+          continue;
+        }
+        distances[move_grid.get_idx(n)] = steps + 1;
+        open.push(n);
+      }
+    }
+  }
+}
+
+BenchScenario make_open_field(int rows, int cols) {
+  auto scenario = BenchScenario();
+  scenario.name = "open";
+  scenario.move_grid = MoveGrid(rows * MOVE_GRID_RATIO, cols * MOVE_GRID_RATIO);
+  scenario.move_grid.update_all_clearances();
+  return scenario;
+}
+
+// a perfect maze (recursive backtracker). Cells are 2x2 tiles with 1 tile
+// walls so a unit fits through the corridors.
+BenchScenario make_maze(int maze_rows, int maze_cols, mt19937 &rng) {
+  auto rows = maze_rows * 3 + 1;
+  auto cols = maze_cols * 3 + 1;
+  auto scenario = BenchScenario();
+  scenario.name = "maze";
+  scenario.move_grid = MoveGrid(rows * MOVE_GRID_RATIO, cols * MOVE_GRID_RATIO);
+  auto is_open = vector<uint8_t>(rows * cols, 0);
+  auto open_tiles = [&](int x, int y, int w, int h) {
+    for (int i = x; i < x + w; i++) {
+      for (int j = y; j < y + h; j++) {
+        is_open[i * cols + j] = 1;
+      }
+    }
+  };
+  auto is_visited = vector<uint8_t>(maze_rows * maze_cols, 0);
+  auto stack = vector<Vec2>{Vec2(0, 0)};
+  is_visited[0] = 1;
+  open_tiles(1, 1, 2, 2);
+  const Vec2 dirs[4] = {Vec2(1, 0), Vec2(-1, 0), Vec2(0, 1), Vec2(0, -1)};
+  while (!stack.empty()) {
+    auto cell = stack.back();
+    auto unvisited = vector<Vec2>();
+    for (auto dir : dirs) {
+      auto n = Vec2(cell.x + dir.x, cell.y + dir.y);
+      if (n.x >= 0 && n.x < maze_rows && n.y >= 0 && n.y < maze_cols &&
+          !is_visited[n.x * maze_cols + n.y]) {
+        unvisited.push_back(dir);
+      }
+    }
+    if (unvisited.empty()) {
+      stack.pop_back();
+      continue;
+    }
+    auto dir = unvisited[rng() % unvisited.size()];
+    auto n = Vec2(cell.x + dir.x, cell.y + dir.y);
+    is_visited[n.x * maze_cols + n.y] = 1;
+    open_tiles(n.x * 3 + 1, n.y * 3 + 1, 2, 2);
+    // the wall between the two cells
+    open_tiles(min(cell.x, n.x) * 3 + 1 + (dir.x != 0 ? 2 : 0),
+               min(cell.y, n.y) * 3 + 1 + (dir.y != 0 ? 2 : 0),
+               dir.x != 0 ? 1 : 2, dir.y != 0 ? 1 : 2);
+    stack.push_back(n);
+  }
+  for (int x = 0; x < rows; x++) {
+    for (int y = 0; y < cols; y++) {
+      if (!is_open[x * cols + y]) {
+        scenario.move_grid.set_tile_is_obstacle(Vec2(x, y), true, false);
+      }
+    }
+  }
+  scenario.move_grid.update_all_clearances();
+  return scenario;
+}
+
+// square rooms with 1 tile walls and a 3 tile doorway in each wall.
+BenchScenario make_rooms(int num_rooms, int room_size, mt19937 &rng) {
+  auto size = num_rooms * (room_size + 1) + 1;
+  auto scenario = BenchScenario();
+  scenario.name = "rooms";
+  scenario.move_grid = MoveGrid(size * MOVE_GRID_RATIO, size * MOVE_GRID_RATIO);
+  auto &move_grid = scenario.move_grid;
+  for (int i = 0; i <= num_rooms; i++) {
+    auto wall = i * (room_size + 1);
+    for (int j = 0; j < num_rooms; j++) {
+      auto room_start = j * (room_size + 1) + 1;
+      // outer walls have no doorways
+      auto has_doorway = i != 0 && i != num_rooms;
+      auto doorway = room_start + (int)(rng() % (room_size - 2));
+      for (int k = room_start - 1; k < room_start + room_size + 1; k++) {
+        if (has_doorway && k >= doorway && k < doorway + 3) {
+          continue;
+        }
+        move_grid.set_tile_is_obstacle(Vec2(wall, k), true, false);
+      }
+      doorway = room_start + (int)(rng() % (room_size - 2));
+      for (int k = room_start - 1; k < room_start + room_size + 1; k++) {
+        if (has_doorway && k >= doorway && k < doorway + 3) {
+          continue;
+        }
+        move_grid.set_tile_is_obstacle(Vec2(k, wall), true, false);
+      }
+    }
+  }
+  move_grid.update_all_clearances();
+  return scenario;
+}
+
+// an open field crowded with units, paths can't go through them.
+BenchScenario make_many_units(int rows, int cols, int num_units,
+                              mt19937 &rng) {
+  auto scenario = make_open_field(rows, cols);
+  scenario.name = "units";
+  scenario.use_occupancy_grid = true;
+  auto &move_grid = scenario.move_grid;
+  scenario.occupancy_grid = OccupancyGrid(move_grid.rows, move_grid.cols);
+  for (int i = 0; i < num_units; i++) {
+    auto p = Vec2(rng() % (move_grid.rows - BENCH_HIT_BOX_W),
+                  rng() % (move_grid.cols - BENCH_HIT_BOX_H));
+    if (!is_passable(scenario, p)) {
+      continue;
+    }
+    auto unit_handle = EntityHandle(i, 0);
+    scenario.occupancy_grid.add_unit(unit_handle, get_hit_box(p));
+  }
+  return scenario;
+}
+
+// starts are random passable points, targets are random points that can
+// be reached from them.
+void add_queries(BenchScenario &scenario, int num_queries, mt19937 &rng) {
+  auto &move_grid = scenario.move_grid;
+  auto distances = vector<int>();
+  auto reachable_idxs = vector<int>();
+  while ((int)scenario.queries.size() < num_queries) {
+    auto start = Vec2(rng() % move_grid.rows, rng() % move_grid.cols);
+    if (!is_passable(scenario, start)) {
+      continue;
+    }
+    set_distances(scenario, start, distances);
+    reachable_idxs.clear();
+    for (int i = 0; i < (int)distances.size(); i++) {
+      if (distances[i] > 0) {
+        reachable_idxs.push_back(i);
+      }
+    }
+    if (reachable_idxs.empty()) {
+      continue;
+    }
+    auto target_idx = reachable_idxs[rng() % reachable_idxs.size()];
+    auto query = BenchQuery();
+    query.start = start;
+    query.target =
+        Vec2(target_idx / move_grid.cols, target_idx % move_grid.cols);
+    query.optimal_length = distances[target_idx];
+    scenario.queries.push_back(query);
+  }
+}
+
+// returns the number of nodes expanded, path is the path found (empty if
+// none was).
+int run_query(BenchScenario &scenario, BenchMode mode, PathFinder &path_finder,
+              PathClusterGraph &path_cluster_graph, const BenchQuery &query,
+              vector<Vec2> &path) {
+  path.clear();
+  const OccupancyGrid *occupancy_grid = nullptr;
+  if (scenario.use_occupancy_grid) {
+    occupancy_grid = &scenario.occupancy_grid;
+  }
+  auto hit_box = get_hit_box(query.start);
+  auto no_hit_box = Rect(0, 0, 0, 0);
+  if (mode == BenchMode::AStar || mode == BenchMode::JumpPoint) {
+    auto path_finder_mode = mode == BenchMode::AStar
+                                ? PathFinderMode::AStar
+                                : PathFinderMode::JumpPoint;
+    path_finder.find_path(scenario.move_grid, occupancy_grid, hit_box,
+                          no_hit_box, query.start, query.target,
+                          path_finder_mode);
+    if (path_finder.path_found) {
+      path = path_finder.path;
+    }
+    return path_finder.nodes_expanded;
+  }
+
+  auto waypoints = vector<Vec2>{query.target};
+  if (chebyshev_distance(query.start, query.target) > PATH_CLUSTER_SIZE) {
+    if (!path_cluster_graph.set_waypoints(scenario.move_grid, query.start,
+                                          query.target)) {
+      return 0;
+    }
+    waypoints = path_cluster_graph.waypoints;
+    path_finder.smooth_waypoints(scenario.move_grid, hit_box, query.start,
+                                 waypoints);
+  }
+  auto nodes_expanded = 0;
+  auto start = query.start;
+  for (auto waypoint : waypoints) {
+    path_finder.find_path(scenario.move_grid, occupancy_grid, hit_box,
+                          no_hit_box, start, waypoint,
+                          PATH_FINDER_WALK_MODE);
+    nodes_expanded += path_finder.nodes_expanded;
+    // units can block the way to a waypoint, the rest is searched straight
+    // to the target like Unit::move_to_next_path_waypoints
+    if (!path_finder.path_found && !(waypoint == query.target)) {
+      path_finder.find_path(scenario.move_grid, occupancy_grid, hit_box,
+                            no_hit_box, start, query.target,
+                            PATH_FINDER_WALK_MODE);
+      nodes_expanded += path_finder.nodes_expanded;
+      waypoint = query.target;
+    }
+    if (!path_finder.path_found) {
+      path.clear();
+      return nodes_expanded;
+    }
+    path.insert(path.end(), path_finder.path.begin(), path_finder.path.end());
+    if (waypoint == query.target) {
+      break;
+    }
+    start = waypoint;
+  }
+  return nodes_expanded;
+}
+
+BenchResult run_mode(BenchScenario &scenario, BenchMode mode) {
+  auto result = BenchResult();
+  auto path_finder = PathFinder();
+  auto path_cluster_graph =
+      PathClusterGraph(scenario.move_grid.rows, scenario.move_grid.cols,
+                       Vec2(BENCH_HIT_BOX_W, BENCH_HIT_BOX_H));
+  auto path = vector<Vec2>();
+  // builds the clusters and sizes the search arrays, like the first
+  // search on a map does
+  run_query(scenario, mode, path_finder, path_cluster_graph,
+            scenario.queries[0], path);
+  auto best_ns = -1.0;
+  for (int run = 0; run < BENCH_RUNS; run++) {
+    auto start_time = chrono::steady_clock::now();
+    for (auto &query : scenario.queries) {
+      run_query(scenario, mode, path_finder, path_cluster_graph, query, path);
+    }
+    auto ns = (double)chrono::duration_cast<chrono::nanoseconds>(
+                  chrono::steady_clock::now() - start_time)
+                  .count();
+    if (best_ns < 0 || ns < best_ns) {
+      best_ns = ns;
+    }
+  }
+  result.ns_per_query = best_ns / scenario.queries.size();
+
+  // untimed run for the path stats
+  auto total_nodes_expanded = 0.0;
+  auto total_length_ratio = 0.0;
+  for (auto &query : scenario.queries) {
+    total_nodes_expanded += run_query(scenario, mode, path_finder,
+                                      path_cluster_graph, query, path);
+    if (path.empty() || !(path.back() == query.target)) {
+      continue;
+    }
+    result.num_found += 1;
+    if ((int)path.size() == query.optimal_length) {
+      result.num_optimal += 1;
+    }
+    total_length_ratio += (double)path.size() / query.optimal_length;
+  }
+  result.nodes_expanded = total_nodes_expanded / scenario.queries.size();
+  if (result.num_found > 0) {
+    result.length_ratio = total_length_ratio / result.num_found;
+  }
+  return result;
+}
+
+string get_mode_name(BenchMode mode) {
+  switch (mode) {
+  case BenchMode::AStar: {
+    return "astar";
+  }
+  case BenchMode::JumpPoint: {
+    return "jps";
+  }
+  case BenchMode::Hierarchical: {
+    return "hpa";
+  }
+  default: {
+    cout << "get_mode_name. mode not handled " << (int)mode << "\n";
+    abort();
+  }
+  }
+}
+
+int main(int argc, char *argv[]) {
+  auto num_queries = BENCH_DEFAULT_QUERIES;
+  auto seed = BENCH_DEFAULT_SEED;
+  if (argc > 1) {
+    num_queries = max(1, atoi(argv[1]));
+  }
+  if (argc > 2) {
+    seed = atoi(argv[2]);
+  }
+  auto rng = mt19937(seed);
+  auto scenarios = vector<BenchScenario>();
+  scenarios.push_back(make_open_field(48, 48));
+  scenarios.push_back(make_maze(16, 16, rng));
+  scenarios.push_back(make_rooms(5, 8, rng));
+  scenarios.push_back(make_many_units(48, 48, BENCH_NUM_UNITS, rng));
+  for (auto &scenario : scenarios) {
+    add_queries(scenario, num_queries, rng);
+  }
+
+  cout << "queries per scenario " << num_queries << ", seed " << seed
+       << ", search cap " << PATH_FINDER_MAX_ITERS << " iters\n";
+  cout << left << setw(8) << "map" << setw(8) << "mode" << right << setw(14)
+       << "ns/query" << setw(12) << "expanded" << setw(10) << "found"
+       << setw(10) << "optimal" << setw(10) << "ratio"
+       << "\n";
+  auto modes = vector<BenchMode>{BenchMode::AStar, BenchMode::JumpPoint,
+                                 BenchMode::Hierarchical};
+  for (auto &scenario : scenarios) {
+    for (auto mode : modes) {
+      auto result = run_mode(scenario, mode);
+      cout << left << setw(8) << scenario.name << setw(8)
+           << get_mode_name(mode) << right << fixed << setprecision(0)
+           << setw(14) << result.ns_per_query << setw(12)
+           << result.nodes_expanded << setw(10) << result.num_found
+           << setw(10) << result.num_optimal << setprecision(3) << setw(10)
+           << result.length_ratio << "\n";
+    }
+  }
+  return 0;
+}